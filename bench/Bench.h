@@ -0,0 +1,136 @@
+#ifndef AFINA_BENCH_BENCH_H
+#define AFINA_BENCH_BENCH_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Afina {
+namespace Bench {
+
+/**
+ * # Wall clock timer
+ * Measures time elapsed since construction or the last Reset call
+ */
+class Stopwatch {
+public:
+    Stopwatch() { Reset(); }
+
+    void Reset() { _start = std::chrono::steady_clock::now(); }
+
+    double Seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+    // Average nanoseconds spent per each of ops operations since start
+    double NsPerOp(std::size_t ops) const { return Seconds() * 1e9 / ops; }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+/**
+ * Returns positional command line argument number idx or the default if it wasn't given
+ */
+inline std::size_t Arg(int argc, char **argv, int idx, std::size_t def) {
+    return argc > idx ? std::strtoull(argv[idx], nullptr, 10) : def;
+}
+
+/**
+ * Builds key number i padded to the given length, keys look like the ones in test/storage
+ */
+inline std::string MakeKey(std::size_t i, std::size_t length = 20) {
+    std::string key = "Key " + std::to_string(i);
+    key.resize(length, ' ');
+    return key;
+}
+
+/**
+ * Simple xorshift generator, std::mt19937 is way too slow to be called on each benchmark iteration
+ */
+class Random {
+public:
+    Random(uint64_t seed = 88172645463325252ull) : _state(seed ? seed : 1) {}
+
+    uint64_t Next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 7;
+        _state ^= _state << 17;
+        return _state;
+    }
+
+    // Uniformly distributed number in [0, 1)
+    double NextDouble() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t _state;
+};
+
+/**
+ * # Zipfian distributed numbers in [0, n)
+ * Small numbers are the most popular ones, skew is controlled by theta. Algorithm from "Quickly
+ * Generating Billion-Record Synthetic Databases", Gray et al, the same one YCSB uses
+ */
+class Zipf {
+public:
+    Zipf(std::size_t n, double theta = 0.99) : _n(n), _theta(theta) {
+        double zeta2 = 1.0 + std::pow(0.5, theta);
+        _zetan = 0;
+        for (std::size_t i = 1; i <= n; ++i) {
+            _zetan += 1.0 / std::pow(double(i), theta);
+        }
+        _alpha = 1.0 / (1.0 - theta);
+        _eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / _zetan);
+        _half_pow_theta = 1.0 + std::pow(0.5, theta);
+    }
+
+    std::size_t Next(Random &rnd) const {
+        double u = rnd.NextDouble();
+        double uz = u * _zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < _half_pow_theta) {
+            return 1;
+        }
+        std::size_t result = std::size_t(_n * std::pow(_eta * u - _eta + 1.0, _alpha));
+        return result < _n ? result : _n - 1;
+    }
+
+private:
+    std::size_t _n;
+    double _theta;
+    double _zetan;
+    double _alpha;
+    double _eta;
+    double _half_pow_theta;
+};
+
+/**
+ * Runs func(thread_idx) on the given number of threads simultaneously, returns wall clock seconds
+ * elapsed until the last one finished
+ */
+template <typename F> double RunThreads(std::size_t threads, F func) {
+    std::vector<std::thread> pool;
+    Stopwatch timer;
+    for (std::size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(func, t);
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    return timer.Seconds();
+}
+
+inline void Report(const char *name, const char *metric, double value) {
+    std::printf("%-40s %-16s %12.2f\n", name, metric, value);
+}
+
+} // namespace Bench
+} // namespace Afina
+
+#endif // AFINA_BENCH_BENCH_H
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+
+#include "Bench.h"
+
+using namespace Afina;
+
+enum class Defrag { kNever, kOnFailure, kIncremental };
+
+/**
+ * Cache-like churn: random blocks get replaced by blocks of another random size, so the area ends up as
+ * a mix of long and short lived blocks of all sizes. Reports share of allocations that failed, how much of
+ * the free memory could be allocated as a single block at the end, and the worst single operation latency
+ */
+static void run(const char *name, Defrag mode, std::size_t area, std::size_t ops, std::size_t steps) {
+    std::vector<char> memory(area);
+    Allocator::Simple allocator(memory.data(), memory.size());
+    Bench::Random rnd;
+
+    // Sizes are log-uniform from 16 bytes to 4KB, like values of a cache
+    auto next_size = [&rnd]() { return std::size_t(16 * std::pow(256.0, rnd.NextDouble())); };
+
+    // Fill 80% of the area first
+    std::vector<Allocator::Pointer> blocks;
+    while (allocator.free_bytes() > area / 5) {
+        blocks.push_back(allocator.alloc(next_size()));
+    }
+
+    std::size_t failed = 0;
+    double worst = 0;
+    Bench::Stopwatch total;
+    for (std::size_t i = 0; i < ops; ++i) {
+        Bench::Stopwatch op;
+        Allocator::Pointer &victim = blocks[rnd.Next() % blocks.size()];
+        allocator.free(victim);
+
+        std::size_t size = next_size();
+        try {
+            if (mode == Defrag::kOnFailure && allocator.max_alloc() < size) {
+                allocator.defrag();
+            }
+            victim = allocator.alloc(size);
+        } catch (Allocator::AllocError &) {
+            failed++;
+        }
+        if (mode == Defrag::kIncremental) {
+            allocator.defrag(steps);
+        }
+        worst = std::max(worst, op.Seconds());
+    }
+
+    double ns = total.NsPerOp(ops);
+    double usable = double(allocator.max_alloc()) / allocator.free_bytes();
+    Bench::Report(name, "ns/op", ns);
+    Bench::Report(name, "worst op us", worst * 1e6);
+    Bench::Report(name, "failed allocs %", 100.0 * failed / ops);
+    Bench::Report(name, "usable free %", 100.0 * usable);
+}
+
+/**
+ * Fragmentation of Simple allocator without defrag, with full defrag on demand, and with incremental
+ * defrag making a few steps after each operation
+ *
+ * Usage: benchFragmentation [area_mb=16] [ops=1000000] [steps=4]
+ */
+int main(int argc, char **argv) {
+    std::size_t area = Bench::Arg(argc, argv, 1, 16) * 1024 * 1024;
+    std::size_t ops = Bench::Arg(argc, argv, 2, 1000000);
+    std::size_t steps = Bench::Arg(argc, argv, 3, 4);
+
+    run("Simple no defrag", Defrag::kNever, area, ops, steps);
+    run("Simple full defrag on failure", Defrag::kOnFailure, area, ops, steps);
+    run("Simple incremental defrag", Defrag::kIncremental, area, ops, steps);
+    return 0;
+}
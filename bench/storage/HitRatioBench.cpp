@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "Bench.h"
+#include "storage/HashLRU.h"
+#include "storage/TinyLFU.h"
+
+using namespace Afina;
+
+// Replays trace as a look-aside cache: on miss key gets stored, returns hit ratio
+static double replay(Storage &storage, const std::vector<std::string> &trace) {
+    std::string value(32, 'v'), out;
+    std::size_t hits = 0;
+    for (auto &key : trace) {
+        if (storage.Get(key, out)) {
+            hits++;
+        } else {
+            storage.Put(key, value);
+        }
+    }
+    return double(hits) / trace.size();
+}
+
+// Zipfian requests over hot keys interrupted by scans of keys that are never seen again
+static std::vector<std::string> synthetic(std::size_t length, std::size_t hot_keys) {
+    std::vector<std::string> trace;
+    Bench::Zipf zipf(hot_keys);
+    Bench::Random rnd;
+    std::size_t cold = 0;
+    while (trace.size() < length) {
+        for (std::size_t i = 0; i < hot_keys && trace.size() < length; ++i) {
+            trace.push_back(Bench::MakeKey(zipf.Next(rnd)));
+        }
+        for (std::size_t i = 0; i < hot_keys / 2 && trace.size() < length; ++i) {
+            trace.push_back("Cold " + std::to_string(cold++));
+        }
+    }
+    return trace;
+}
+
+/**
+ * Hit ratio of plain LRU versus W-TinyLFU admission on the same trace. Trace file, if given, has one
+ * key per line, otherwise zipfian trace with periodic scans is generated
+ *
+ * Usage: benchHitRatio [cache_items=10000] [trace_file]
+ */
+int main(int argc, char **argv) {
+    std::size_t items = Bench::Arg(argc, argv, 1, 10000);
+    std::vector<std::string> trace;
+    if (argc > 2) {
+        std::ifstream in(argv[2]);
+        std::string key;
+        while (std::getline(in, key)) {
+            trace.push_back(key);
+        }
+    } else {
+        trace = synthetic(items * 100, items * 4);
+    }
+    if (trace.empty()) {
+        std::fprintf(stderr, "Empty trace\n");
+        return 1;
+    }
+
+    // Room for the given number of items with 20 byte keys
+    std::size_t memory = items * (20 + 32);
+    {
+        Backend::HashLRU storage(memory);
+        Bench::Report("HashLRU", "hit ratio %", replay(storage, trace) * 100);
+    }
+    {
+        Backend::TinyLFU storage(std::make_shared<Backend::HashLRU>(memory), memory);
+        Bench::Report("TinyLFU over HashLRU", "hit ratio %", replay(storage, trace) * 100);
+        Backend::TinyLFU::Stats stats = storage.GetStats();
+        Bench::Report("TinyLFU over HashLRU", "admitted", stats.admitted);
+        Bench::Report("TinyLFU over HashLRU", "rejected", stats.rejected);
+    }
+    return 0;
+}
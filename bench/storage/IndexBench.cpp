@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "storage/HashLRU.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+// Fills storage with n keys and then looks up random existing keys, reports latency of each phase
+template <typename T> static void run(const char *name, std::size_t n, std::size_t lookups) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(Bench::MakeKey(i));
+    }
+    std::string value(20, 'v');
+
+    // Make sure nothing gets evicted
+    T storage(n * (keys[0].size() + value.size()) * 2);
+
+    Bench::Stopwatch timer;
+    for (auto &key : keys) {
+        storage.Put(key, value);
+    }
+    Bench::Report(name, "put ns/op", timer.NsPerOp(n));
+
+    Bench::Random rnd;
+    std::string out;
+    std::size_t found = 0;
+    timer.Reset();
+    for (std::size_t i = 0; i < lookups; ++i) {
+        found += storage.Get(keys[rnd.Next() % n], out);
+    }
+    Bench::Report(name, "get ns/op", timer.NsPerOp(lookups));
+
+    timer.Reset();
+    for (std::size_t i = 0; i < lookups; ++i) {
+        found += storage.Get(Bench::MakeKey(n + i), out);
+    }
+    Bench::Report(name, "get miss ns/op", timer.NsPerOp(lookups));
+
+    if (found != lookups) {
+        std::printf("%s: %zu of %zu lookups found\n", name, found, lookups);
+    }
+}
+
+/**
+ * Lookup latency of std::map based SimpleLRU versus HashIndex based HashLRU
+ *
+ * Usage: benchIndex [keys=1000000] [lookups=1000000]
+ */
+int main(int argc, char **argv) {
+    std::size_t n = Bench::Arg(argc, argv, 1, 1000000);
+    std::size_t lookups = Bench::Arg(argc, argv, 2, 1000000);
+
+    run<Backend::SimpleLRU>("SimpleLRU (std::map)", n, lookups);
+    run<Backend::HashLRU>("HashLRU (robin hood)", n, lookups);
+    return 0;
+}
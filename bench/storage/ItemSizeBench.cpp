@@ -0,0 +1,65 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include "Bench.h"
+#include "storage/HashLRU.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+
+// Bytes currently handed out by malloc, including chunk headers and big mmap'ed blocks
+static std::size_t heap_in_use() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Resident set size of the process in bytes
+static std::size_t rss() {
+    std::size_t pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Fills storage with n small items and reports how much memory each item costs on top of its payload
+template <typename T> static void run(const char *name, std::size_t n, std::size_t value_size) {
+    malloc_trim(0);
+    std::size_t heap_before = heap_in_use();
+    std::size_t rss_before = rss();
+
+    std::string value(value_size, 'v');
+    std::size_t payload = 0;
+    {
+        std::unique_ptr<T> storage(new T(n * (value_size + 32) * 2));
+        for (std::size_t i = 0; i < n; ++i) {
+            std::string key = "Key " + std::to_string(i);
+            storage->Put(key, value);
+            payload += key.size() + value.size();
+        }
+
+        double heap = double(heap_in_use() - heap_before) / n;
+        double resident = double(rss() - rss_before) / n;
+        Bench::Report(name, "payload B/item", double(payload) / n);
+        Bench::Report(name, "heap B/item", heap);
+        Bench::Report(name, "rss B/item", resident);
+    }
+}
+
+/**
+ * Per item memory overhead of std::map + std::string nodes versus single allocation items
+ *
+ * Usage: benchItemSize [items=1000000] [value_size=16]
+ */
+int main(int argc, char **argv) {
+    std::size_t n = Bench::Arg(argc, argv, 1, 1000000);
+    std::size_t value_size = Bench::Arg(argc, argv, 2, 16);
+
+    run<Backend::SimpleLRU>("SimpleLRU", n, value_size);
+    run<Backend::HashLRU>("HashLRU", n, value_size);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "Bench.h"
+#include "storage/ClockLRU.h"
+#include "storage/FlatCombineLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/ReadBufferedLRU.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+// Each thread runs ops operations on zipfian keys, read_pct percents of them are reads
+static void run(const char *name, Storage &storage, const std::vector<std::string> &keys, std::size_t threads,
+                std::size_t ops, std::size_t read_pct) {
+    Bench::Zipf zipf(keys.size());
+    std::string value(32, 'v');
+    for (auto &key : keys) {
+        storage.Put(key, value);
+    }
+
+    double seconds = Bench::RunThreads(threads, [&](std::size_t t) {
+        Bench::Random rnd(t + 1);
+        std::string out;
+        for (std::size_t i = 0; i < ops; ++i) {
+            const std::string &key = keys[zipf.Next(rnd)];
+            if (rnd.Next() % 100 < read_pct) {
+                storage.Get(key, out);
+            } else {
+                storage.Put(key, value);
+            }
+        }
+    });
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s, %zu threads", name, threads);
+    Bench::Report(label, "Mops/s", threads * ops / seconds / 1e6);
+}
+
+/**
+ * Throughput of thread safe backends on read heavy zipfian workload
+ *
+ * Usage: benchReadHeavy [max_threads=8] [ops_per_thread=1000000] [keys=100000] [read_pct=95]
+ */
+int main(int argc, char **argv) {
+    std::size_t max_threads = Bench::Arg(argc, argv, 1, 8);
+    std::size_t ops = Bench::Arg(argc, argv, 2, 1000000);
+    std::size_t n = Bench::Arg(argc, argv, 3, 100000);
+    std::size_t read_pct = Bench::Arg(argc, argv, 4, 95);
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(Bench::MakeKey(i));
+    }
+    // Room for a half of keys, so that eviction is a part of the workload
+    std::size_t memory = n * (20 + 32) / 2;
+
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        {
+            Backend::ThreadSafeSimplLRU storage(memory);
+            run("mt_lru", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::ReadBufferedLRU storage(memory);
+            run("mt_buffered", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::FlatCombineLRU storage(memory);
+            run("mt_combine", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::StripedLRU storage = Backend::StripedLRU::Create_StripedLRU(memory, 4);
+            run("mt_slru", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::ClockLRU storage(memory);
+            run("mt_clock", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::LockFreeHash storage(memory);
+            run("mt_lockfree", storage, keys, threads, ops, read_pct);
+        }
+    }
+    return 0;
+}
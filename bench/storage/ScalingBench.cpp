@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "Bench.h"
+#include "storage/ClockLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina;
+
+// Runs the same workload on 1, 2, 4... max_threads threads, reports throughput and speedup over one thread
+static void run(const char *name, const std::function<std::unique_ptr<Storage>()> &create,
+                const std::vector<std::string> &keys, std::size_t max_threads, std::size_t ops,
+                std::size_t read_pct) {
+    Bench::Zipf zipf(keys.size());
+    std::string value(32, 'v');
+
+    double single = 0;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        std::unique_ptr<Storage> storage = create();
+        for (auto &key : keys) {
+            storage->Put(key, value);
+        }
+
+        double seconds = Bench::RunThreads(threads, [&](std::size_t t) {
+            Bench::Random rnd(t + 1);
+            std::string out;
+            for (std::size_t i = 0; i < ops; ++i) {
+                const std::string &key = keys[zipf.Next(rnd)];
+                if (rnd.Next() % 100 < read_pct) {
+                    storage->Get(key, out);
+                } else {
+                    storage->Put(key, value);
+                }
+            }
+        });
+
+        double mops = threads * ops / seconds / 1e6;
+        if (threads == 1) {
+            single = mops;
+        }
+
+        char label[128];
+        std::snprintf(label, sizeof(label), "%s, %zu threads", name, threads);
+        Bench::Report(label, "Mops/s", mops);
+        Bench::Report(label, "speedup", mops / single);
+    }
+}
+
+/**
+ * Scalability of thread safe backends from one thread up to the core count on zipfian workload
+ *
+ * Usage: benchScaling [max_threads=cores] [ops_per_thread=1000000] [keys=100000] [read_pct=90]
+ */
+int main(int argc, char **argv) {
+    std::size_t max_threads = Bench::Arg(argc, argv, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::size_t ops = Bench::Arg(argc, argv, 2, 1000000);
+    std::size_t n = Bench::Arg(argc, argv, 3, 100000);
+    std::size_t read_pct = Bench::Arg(argc, argv, 4, 90);
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(Bench::MakeKey(i));
+    }
+    // Room for a half of keys, so that eviction is a part of the workload
+    std::size_t memory = n * (20 + 32) / 2;
+
+    run("mt_slru", [memory]() {
+        return std::unique_ptr<Storage>(new Backend::StripedLRU(Backend::StripedLRU::Create_StripedLRU(memory, 4)));
+    }, keys, max_threads, ops, read_pct);
+    run("mt_clock", [memory]() { return std::unique_ptr<Storage>(new Backend::ClockLRU(memory)); }, keys,
+        max_threads, ops, read_pct);
+    run("mt_lockfree", [memory]() { return std::unique_ptr<Storage>(new Backend::LockFreeHash(memory)); }, keys,
+        max_threads, ops, read_pct);
+    return 0;
+}
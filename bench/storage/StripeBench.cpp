@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "Bench.h"
+#include "storage/StripedLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+/**
+ * Layout StripedLRU had before: separately allocated shards picked by std::hash modulo their count
+ */
+class LegacyStripes {
+public:
+    LegacyStripes(std::size_t memory_limit, std::size_t stripe_count) {
+        for (std::size_t i = 0; i < stripe_count; ++i) {
+            _shards.emplace_back(new Backend::ThreadSafeSimplLRU(memory_limit / stripe_count));
+        }
+    }
+
+    bool Put(const std::string &key, const std::string &value) { return _Shard(key).Put(key, value); }
+    bool Get(const std::string &key, std::string &value) { return _Shard(key).Get(key, value); }
+
+private:
+    Backend::ThreadSafeSimplLRU &_Shard(const std::string &key) {
+        return *_shards[std::hash<std::string>{}(key) % _shards.size()];
+    }
+
+    std::vector<std::unique_ptr<Backend::ThreadSafeSimplLRU>> _shards;
+};
+
+// Each thread runs ops operations on uniformly random keys, read_pct percents of them are reads
+template <typename S>
+static void run(const char *name, S &storage, const std::vector<std::string> &keys, std::size_t threads,
+                std::size_t ops, std::size_t read_pct) {
+    std::string value(32, 'v');
+    for (auto &key : keys) {
+        storage.Put(key, value);
+    }
+
+    double seconds = Bench::RunThreads(threads, [&](std::size_t t) {
+        Bench::Random rnd(t + 1);
+        std::string out;
+        for (std::size_t i = 0; i < ops; ++i) {
+            const std::string &key = keys[rnd.Next() % keys.size()];
+            if (rnd.Next() % 100 < read_pct) {
+                storage.Get(key, out);
+            } else {
+                storage.Put(key, value);
+            }
+        }
+    });
+
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s, %zu threads", name, threads);
+    Bench::Report(label, "Mops/s", threads * ops / seconds / 1e6);
+}
+
+/**
+ * Old and new StripedLRU layouts from one to max_threads threads. Memory fits all keys, so that
+ * eviction doesn't hide the cost of stripe selection and lock contention
+ *
+ * Usage: benchStripes [max_threads=64] [ops_per_thread=200000] [keys=100000] [read_pct=90]
+ */
+int main(int argc, char **argv) {
+    std::size_t max_threads = Bench::Arg(argc, argv, 1, 64);
+    std::size_t ops = Bench::Arg(argc, argv, 2, 200000);
+    std::size_t n = Bench::Arg(argc, argv, 3, 100000);
+    std::size_t read_pct = Bench::Arg(argc, argv, 4, 90);
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(Bench::MakeKey(i));
+    }
+    std::size_t memory = 2 * n * (20 + 32);
+
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        {
+            LegacyStripes storage(memory, 4);
+            run("legacy, 4 stripes", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::StripedLRU storage = Backend::StripedLRU::Create_StripedLRU(memory, 4);
+            run("padded crc32c, 4 stripes", storage, keys, threads, ops, read_pct);
+        }
+        {
+            Backend::StripedLRU storage = Backend::StripedLRU::Create_StripedLRU(memory);
+            char name[64];
+            std::snprintf(name, sizeof(name), "padded crc32c, %zu stripes", storage.stripe_count());
+            run(name, storage, keys, threads, ops, read_pct);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef AFINA_KEY_REF_H
+#define AFINA_KEY_REF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Afina {
+
+/**
+ * # Fast key hash
+ * With SSE 4.2 (top level CMakeLists builds with -march=native) that is hardware CRC32C over 8 bytes per
+ * instruction, otherwise a portable multiply-xorshift over 8 byte words. Either way the result is spread
+ * over all 64 bits by the final multiplication, so both low bits (stripe or bucket number) and high bits
+ * are usable. Keys are short, so that is several times faster than std::hash which is murmur over bytes.
+ *
+ * All storage backends hash keys with it, so hash computed once by the caller is good for every layer.
+ * Not a cryptographic hash, must not be exposed to clients.
+ */
+inline uint64_t HashKey(const char *data, std::size_t size) {
+    const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+#ifdef __SSE4_2__
+    uint64_t crc = ~uint64_t(0);
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = _mm_crc32_u64(crc, word);
+    }
+    for (; size > 0; ++data, --size) {
+        crc = _mm_crc32_u8(uint32_t(crc), uint8_t(*data));
+    }
+    return (crc ^ (crc << 32)) * kMul;
+#else
+    uint64_t h = size * kMul;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        h = (h ^ word) * kMul;
+        h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data, size);
+    h = (h ^ tail) * kMul;
+    return h ^ (h >> 32);
+#endif
+}
+
+inline uint64_t HashKey(const std::string &key) { return HashKey(key.data(), key.size()); }
+
+/**
+ * # Key view with its hash
+ * Points to key bytes owned by somebody else, such as the request buffer, and carries HashKey of them.
+ * Key is hashed once when the reference is made, then the same hash picks the stripe, the bucket and
+ * whatever else on the way down through the storage layers, and bytes are compared in place
+ *
+ * Reference is valid as long as the memory it points to
+ */
+struct KeyRef {
+    KeyRef(const char *data_, std::size_t size_) : data(data_), size(size_), hash(HashKey(data_, size_)) {}
+
+    KeyRef(const char *data_, std::size_t size_, uint64_t hash_) : data(data_), size(size_), hash(hash_) {}
+
+    KeyRef(const std::string &key) : KeyRef(key.data(), key.size()) {}
+
+    bool operator==(const std::string &key) const {
+        return key.size() == size && std::memcmp(key.data(), data, size) == 0;
+    }
+
+    // Copies key out, for backends that have no way to look up by bytes
+    std::string str() const { return std::string(data, size); }
+
+    const char *data;
+    std::size_t size;
+    uint64_t hash;
+};
+
+} // namespace Afina
+
+#endif // AFINA_KEY_REF_H
@@ -1,7 +1,14 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
 #include <string>
+#include <vector>
+
+#include <afina/KeyRef.h>
 
 namespace Afina {
 
@@ -10,6 +17,77 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Receives value stored in the storage. Value memory is owned by the storage and valid only until
+     * visitor returns, so visitor must copy out whatever it needs and must not call storage back
+     */
+    using Visitor = std::function<void(const char *value, std::size_t size)>;
+
+    /**
+     * Same as Visitor, but also receives key the value is stored for
+     */
+    using MultiVisitor = std::function<void(const std::string &key, const char *value, std::size_t size)>;
+
+    /**
+     * Same as MultiVisitor, for keys passed by reference
+     */
+    using RefVisitor = std::function<void(const KeyRef &key, const char *value, std::size_t size)>;
+
+    /**
+     * Receives each entry of the storage during Scan, expire is unix time entry expires at or 0 if it never
+     * does. Memory is owned by the storage the same way as for Visitor
+     */
+    using Scanner = std::function<void(const char *key, std::size_t key_size, const char *value,
+                                       std::size_t value_size, std::time_t expire)>;
+
+    /**
+     * Same as MultiVisitor, but also receives version of the value, see CompareAndSwap
+     */
+    using CasVisitor =
+        std::function<void(const std::string &key, const char *value, std::size_t size, uint64_t cas)>;
+
+    /**
+     * Receives counter of the storage by its name, see Report
+     */
+    using Reporter = std::function<void(const std::string &name, uint64_t value)>;
+
+    /**
+     * Outcome of CompareAndSwap
+     */
+    enum class CasResult {
+        // Value was replaced
+        kStored,
+
+        // Versions matched, but the new value doesn't fit the storage
+        kNotStored,
+
+        // Value was changed since the given version was read
+        kExists,
+
+        // There is no association for the key
+        kNotFound
+    };
+
+    /**
+     * Outcome of Increment and Decrement
+     */
+    enum class IncrResult {
+        // Counter was changed
+        kUpdated,
+
+        // New value doesn't fit the storage
+        kNotStored,
+
+        // Value isn't a decimal number of 64 bits
+        kNotNumber,
+
+        // There is no association for the key
+        kNotFound
+    };
+
+    // Longest decimal number of 64 bits
+    static constexpr std::size_t kCounterDigits = 20;
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -56,6 +134,77 @@ public:
      */
     virtual bool Set(const std::string &key, const std::string &value) = 0;
 
+    /**
+     * Same as Put, PutIfAbsent and Set, but created association lives until the given unix time only.
+     * Once expire time comes any subsequent access to storage must indicates that association doesn't
+     * exist. Zero means association never expires, the same as methods above do. Expire time in the
+     * past makes value invisible right away: existing association is dropped and method returns true
+     *
+     * Default implementation ignores expire time, backends that could track it must override these
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param expire unix time association expires at
+     */
+    virtual bool Put(const std::string &key, const std::string &value, std::time_t expire) { return Put(key, value); }
+
+    // See Put above
+    virtual bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+        return PutIfAbsent(key, value);
+    }
+
+    // See Put above
+    virtual bool Set(const std::string &key, const std::string &value, std::time_t expire) { return Set(key, value); }
+
+    /**
+     * Adds data to the end of the value associated with the given key. Value is extended in place under
+     * the same lock that guards other calls, so appends racing for the same key are never lost and the
+     * existing value isn't copied. Expire time of the association doesn't change
+     *
+     * If key isn't present or extended value doesn't fit the storage, method returns false and value
+     * stays as it was
+     *
+     * Default implementation is Get followed by Put, that is neither atomic nor in place and drops expire
+     * time, backends should override it
+     *
+     * @param key to extend value of
+     * @param data to add
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Put(key, value + data);
+    }
+
+    // Same as Append, but data is added to the beginning of the value
+    virtual bool Prepend(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Put(key, data + value);
+    }
+
+    /**
+     * Adds delta to the counter associated with the given key. Counter is value that is a decimal number
+     * of 64 bits, it wraps around on overflow. Number is changed in place under the same lock that guards
+     * other calls, so increments racing for the same key are never lost. Expire time of the association
+     * doesn't change
+     *
+     * Backends are free to keep counter in binary form as long as all other calls see it as decimal digits
+     *
+     * Default implementation is Get followed by Put, that is neither atomic nor in place and drops expire
+     * time, backends should override it
+     *
+     * @param key of the counter
+     * @param delta to add
+     * @param value output parameter to write the new counter to
+     */
+    virtual IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+        return _IncrementByPut(key, delta, false, value);
+    }
+
+    // Same as Increment, but delta is subtracted. Counter never goes below zero
+    virtual IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+        return _IncrementByPut(key, delta, true, value);
+    }
+
     /**
      * Removes association for the given key
      * If requested key doesn't present in storage method returns false and
@@ -72,6 +221,12 @@ public:
      */
     virtual bool Delete(const std::string &key) = 0;
 
+    /**
+     * Same as Delete, but key comes with its hash, see KeyRef. Backends that look keys up by hash override
+     * it to use hash as is, default implementation copies key into a string
+     */
+    virtual bool Delete(const KeyRef &key) { return Delete(key.str()); }
+
     /**
      * Retrive key for the given value
      * If there is an association for the given key then method copies value
@@ -84,6 +239,193 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Same as Get, but key comes with its hash, see Delete(const KeyRef &)
+     */
+    virtual bool Get(const KeyRef &key, std::string &value) { return Get(key.str(), value); }
+
+    /**
+     * Retrive value for the given key without copying it out of the storage
+     * If there is an association for the given key then method invokes visitor on the value bytes
+     * right inside of the storage and return true. Access counts the same way as Get does
+     *
+     * In case if given key not found method returns false and visitor isn't called
+     *
+     * Default implementation copies value by Get, backends that could expose own memory must
+     * override it
+     *
+     * @param key to retrive value for
+     * @param visitor callback to pass value into
+     */
+    virtual bool View(const std::string &key, const Visitor &visitor) {
+        std::string value;
+        if (!Get(key, value)) {
+            return false;
+        }
+        visitor(value.data(), value.size());
+        return true;
+    }
+
+    /**
+     * Same as View, but key comes with its hash, see Delete(const KeyRef &)
+     */
+    virtual bool View(const KeyRef &key, const Visitor &visitor) { return View(key.str(), visitor); }
+
+    /**
+     * Retrive values for the given set of keys without copying them out of the storage
+     * For each key that has association method invokes visitor the same way View does. Keys which are
+     * not found are skipped. Visitor could be invoked in an order different from keys order, backends
+     * are free to group keys to amortize locking and lookup costs
+     *
+     * Method returns number of keys found
+     *
+     * @param keys to retrive values for
+     * @param visitor callback to pass keys and values into
+     */
+    virtual std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+        std::size_t found = 0;
+        for (auto &key : keys) {
+            found += View(key, [&key, &visitor](const char *value, std::size_t size) { visitor(key, value, size); });
+        }
+        return found;
+    }
+
+    /**
+     * Same as MultiView, but keys come with their hashes, see Delete(const KeyRef &). That is the lookup
+     * path of "get": each key of the request is hashed exactly once, and backends that compare key bytes
+     * in place find values without a single allocation
+     *
+     * @param keys to retrive values for
+     * @param visitor callback to pass keys and values into
+     */
+    virtual std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+        std::size_t found = 0;
+        for (auto &key : keys) {
+            found += View(key, [&key, &visitor](const char *value, std::size_t size) { visitor(key, value, size); });
+        }
+        return found;
+    }
+
+    /**
+     * Same as MultiView, but visitor also receives version of each value: non zero 64 bit number, that
+     * changes every time association is created or its value changes in any way. Version is only good to
+     * be passed back into CompareAndSwap, it says nothing about order of changes
+     *
+     * Default implementation has no versions and passes 0 for each value
+     *
+     * @param keys to retrive values for
+     * @param visitor callback to pass keys, values and versions into
+     */
+    virtual std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+        return MultiView(keys, [&visitor](const std::string &key, const char *value, std::size_t size) {
+            visitor(key, value, size, 0);
+        });
+    }
+
+    /**
+     * Replaces value associated with the given key only if it is still of the version read by MultiViewCas.
+     * Check and replace happen atomically under the same lock that guards other calls, so of several
+     * clients which read the same version only one succeeds, the rest get kExists and could read again.
+     * New value gets expire time the same way as Put does
+     *
+     * Default implementation has no versions, so it never stores: kExists is returned if key is present
+     * and kNotFound otherwise
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param expire unix time association expires at, see Put
+     * @param cas version the value must have
+     */
+    virtual CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                     uint64_t cas) {
+        return View(key, [](const char *, std::size_t) {}) ? CasResult::kExists : CasResult::kNotFound;
+    }
+
+    /**
+     * Blocks all other calls to the storage until Thaw is called, so that memory of the storage stays
+     * consistent while it is frozen and could be copied by fork, see Backend::Snapshotter. Frozen storage
+     * could be scanned by the same thread
+     *
+     * Default implementation does nothing, that is enough for backends that are not thread safe or are
+     * consistent at any moment, like lock-free ones
+     */
+    virtual void Freeze() {}
+
+    // See Freeze above
+    virtual void Thaw() {}
+
+    /**
+     * Calls scanner for each entry, from the least recently used one to the most recently used one if
+     * backend tracks that. Scan takes no locks and doesn't count as an access, so it must be called only
+     * when nobody else uses the storage: on a frozen storage or in a forked copy of it
+     *
+     * Returns false if backend doesn't support scanning
+     *
+     * @param scanner callback to pass entries into
+     */
+    virtual bool Scan(const Scanner &scanner) { return false; }
+
+    /**
+     * Starts saving content of the storage to disk in background, see Backend::Snapshotter
+     *
+     * Returns false if snapshots are not configured or the previous one is still in progress
+     */
+    virtual bool Snapshot() { return false; }
+
+    /**
+     * Passes counters the backend keeps into reporter, named the way memcached "stats" command names them
+     *
+     * Default implementation has no counters
+     *
+     * @param reporter callback to pass counters into
+     */
+    virtual void Report(const Reporter &reporter) {}
+
+protected:
+    /**
+     * Parses counter out of the value and applies delta to it the way Increment/Decrement do, returns false
+     * if value isn't a counter
+     */
+    static bool _ApplyDelta(const char *value, std::size_t size, uint64_t delta, bool decrement,
+                            uint64_t &result) {
+        if (size == 0 || size > kCounterDigits) {
+            return false;
+        }
+        uint64_t counter = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (value[i] < '0' || value[i] > '9') {
+                return false;
+            }
+            uint64_t next = counter * 10 + (value[i] - '0');
+            if (next / 10 != counter) {
+                return false;
+            }
+            counter = next;
+        }
+        result = _AddDelta(counter, delta, decrement);
+        return true;
+    }
+
+    // Applies delta to the counter the way Increment/Decrement do
+    static uint64_t _AddDelta(uint64_t counter, uint64_t delta, bool decrement) {
+        if (decrement) {
+            return delta > counter ? 0 : counter - delta;
+        }
+        return counter + delta;
+    }
+
+private:
+    IncrResult _IncrementByPut(const std::string &key, uint64_t delta, bool decrement, uint64_t &value) {
+        std::string old;
+        if (!Get(key, old)) {
+            return IncrResult::kNotFound;
+        }
+        if (!_ApplyDelta(old.data(), old.size(), delta, decrement, value)) {
+            return IncrResult::kNotNumber;
+        }
+        return Put(key, std::to_string(value)) ? IncrResult::kUpdated : IncrResult::kNotStored;
+    }
 };
 
 } // namespace Afina
@@ -7,6 +7,15 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * # Relocatable pointer
+ * Refers to a block of Simple allocator through an entry of its indirection table rather than by address,
+ * so allocator is free to move block around during defrag: only the table entry gets updated. Address
+ * returned by get() is valid until the next call of realloc/defrag of the allocator.
+ *
+ * Copies refer to the same block, the same way raw pointers do. Free resets the pointer it was called
+ * with, other copies become dangling
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +26,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _handle ? *_handle : nullptr; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **handle) : _handle(handle) {}
+
+    // Entry of the allocator indirection table, nullptr for empty pointer
+    void **_handle;
 };
 
 } // namespace Allocator
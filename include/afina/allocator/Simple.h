@@ -18,6 +18,14 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Blocks are laid one after another from the area start, each one prefixed with a small header. Indirection
+ * table of Pointer handles grows from the area end towards blocks. New blocks are taken from holes left by
+ * freed blocks, kept in lists binned by size, or bumped from the free space between blocks and the table.
+ *
+ * Since nobody outside holds block addresses, defrag slides used blocks down into holes and updates their
+ * table entries, so all free memory ends up in one piece at the top. Defrag could run in bounded steps
+ * interleaved with other calls, each step moves at most one block.
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +33,106 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes
+     * Throws AllocError NoMemory if there is neither a hole nor free space to fit it, defrag could help
+     * in that case
+     *
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block to N bytes keeping its content up to the smaller of sizes. Empty
+     * pointer gets a new block. Block is resized in place if possible, otherwise moved and p keeps
+     * pointing to it. Throws AllocError NoMemory if there is no room, p is valid then
+     *
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block and resets p to empty one. Empty pointer is ignored, pointer that doesn't refer
+     * to a live block of this allocator results in AllocError InvalidFree
+     *
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Compacts all blocks to the area start at once
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Makes at most steps of the incremental defrag pass, each step moves at most one block. Returns
+     * true once the pass reached the top, so all blocks which were there at the pass start are compacted.
+     * Next call starts a new pass
+     *
+     * @param steps size_t
+     */
+    bool defrag(size_t steps);
+
+    /**
+     * Returns human readable map of blocks
      */
     std::string dump() const;
 
+    // Bytes could be allocated after a full defrag, headers of new blocks aside
+    size_t free_bytes() const;
+
+    // Biggest block could be allocated right now
+    size_t max_alloc() const;
+
 private:
+    struct block;
+
+    // Holes are kept in lists by the highest bit of the size
+    static constexpr size_t kBins = 64;
+
+    // Takes a hole or bumps new block from the top, nullptr if there is no room
+    block *_AllocBlock(size_t size);
+
+    // Turns block into a hole merged with the following one, or gives it to the free space if it is the last
+    void _Release(block *b);
+
+    // Splits tail of the block beyond size off into a hole
+    void _Shrink(block *b, size_t size);
+
+    // Merges holes which follow b into it
+    void _Absorb(block *b);
+
+    block *_FindHole(size_t size);
+    void _InsertHole(block *b);
+    void _RemoveHole(block *b);
+
+    // Returns block pointer refers to, throws InvalidFree if there is none
+    block *_BlockOf(const Pointer &p) const;
+
+    void **_NewHandle();
+
     void *_base;
     const size_t _base_len;
+
+    // Blocks area is [_heap, _top), free space is [_top, _table)
+    char *_heap;
+    char *_top;
+
+    // Indirection table is [_table, _table_end)
+    void **_table;
+    void **_table_end;
+
+    // Unused table entries, linked through the entries themselves
+    void **_free_handles;
+
+    // Sum of sizes of holes, headers included
+    size_t _free_bytes;
+
+    // Lists of holes, linked through their payload
+    block *_bins[kBins];
+
+    // Next block incremental defrag looks at, nullptr if there is no pass in progress
+    char *_defrag_pos;
 };
 
 } // namespace Allocator
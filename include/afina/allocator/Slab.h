@@ -0,0 +1,263 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Global cache of fixed size slabs
+ * Reserves memory_limit bytes of address space once and hands it out in slabs of slab_size bytes. That
+ * is the hard memory ceiling: once all slabs are taken Get returns nullptr and nothing else could be
+ * allocated, no matter how fragmented the contents of slabs are.
+ *
+ * Free slabs form a lock-free stack (Treiber stack with a generation tag against ABA), slabs that were
+ * never used are taken by an atomic bump of the index. Pages of a returned slab are given back to the
+ * kernel, so RSS follows the number of slabs in use.
+ *
+ * That is thread safe implementation
+ */
+class SlabCache {
+public:
+    /**
+     * @param memory_limit bytes to reserve, rounded down to slabs
+     * @param slab_size must be a multiple of the page size
+     */
+    SlabCache(std::size_t memory_limit, std::size_t slab_size);
+
+    /**
+     * Same as above, but slabs are carved out of the given memory owned by the caller, like a shared memory
+     * segment. Pages of returned slabs are removed from the segment
+     *
+     * @param arena memory to hand out, aligned to pages
+     * @param arena_size bytes of arena, rounded down to slabs
+     * @param slab_size must be a multiple of the page size
+     */
+    SlabCache(void *arena, std::size_t arena_size, std::size_t slab_size);
+    ~SlabCache();
+
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /**
+     * Takes one slab, returns nullptr if all of them are in use
+     */
+    void *Get();
+
+    /**
+     * Returns slab taken by Get back to the cache
+     */
+    void Put(void *slab);
+
+    /**
+     * Marks slabs as taken according to the given flags, indexed by slab number, and all the rest as free.
+     * Used to pick up arena that outlived previous owner, must be called before anything is taken
+     */
+    void Restore(const std::vector<bool> &taken);
+
+    // Start of the memory slabs are carved from
+    char *base() const { return _base; }
+
+    // Number of the slab which given memory belongs to
+    std::size_t Index(const void *ptr) const {
+        return std::size_t(static_cast<const char *>(ptr) - _base) / _slab_size;
+    }
+
+    std::size_t slab_size() const { return _slab_size; }
+    std::size_t slab_count() const { return _slab_count; }
+    std::size_t slabs_used() const { return _used.load(std::memory_order_relaxed); }
+
+private:
+    char *_base;
+    const bool _owned;
+    const std::size_t _slab_size;
+    const std::size_t _slab_count;
+
+    // Slabs below that index were taken at least once, the rest were never touched
+    std::atomic<std::size_t> _bump;
+
+    // Top of the free stack: generation in the high half, slab index + 1 in the low one, 0 means empty
+    std::atomic<uint64_t> _free;
+
+    // Links of the free stack, same encoding as _free low half
+    std::unique_ptr<std::atomic<uint32_t>[]> _next;
+
+    std::atomic<std::size_t> _used;
+};
+
+/**
+ * # Slab allocator
+ * Memcached style allocator: requested size is rounded up to one of size classes growing by factor, and
+ * each slab from SlabCache is dedicated to a single class and carved into equal chunks. Chunks never
+ * move between classes and slabs are never split, so there is no external fragmentation at all, only the
+ * internal one bounded by factor.
+ *
+ * Hot path doesn't touch shared state. Each thread works with own pair of magazines per class, stacks of
+ * up to kMagazineSize free chunks: Allocate pops a chunk and Free pushes it back. Only when both of the
+ * magazines are empty (or full) thread exchanges one with the class depot under its mutex, and only when
+ * depot has nothing to offer a new chunk gets carved out of the class slab.
+ *
+ * Magazines are kept in kThreadSlots slots indexed by thread number, each one guarded by a spinlock. As
+ * long as there are no more threads than slots the lock is never contended, and magazines of exited
+ * threads are picked up by the new ones instead of being lost.
+ *
+ * Allocate returns nullptr like malloc does once memory ceiling is reached and class has no free chunks,
+ * caller is expected to free something of the same class (see ClassOf) and try again. Otherwise it could
+ * free all chunks of some slab of another class and Release it, so that the slab moves to the class starving.
+ *
+ * That is thread safe implementation
+ */
+class Slab {
+public:
+    static constexpr std::size_t kDefaultSlabSize = 1024 * 1024;
+
+    // Returned by ClassOf for sizes greater than the biggest class
+    static constexpr std::size_t kNoClass = std::size_t(-1);
+
+    /**
+     * @param memory_limit hard limit on memory used for chunks, rounded down to slabs
+     * @param slab_size size of slab rounded up to pages, also the biggest size could be allocated
+     * @param factor growth of size classes
+     */
+    Slab(std::size_t memory_limit, std::size_t slab_size = kDefaultSlabSize, double factor = 1.25);
+
+    /**
+     * Same as above, but chunks are allocated from the given memory owned by the caller, see SlabCache
+     */
+    Slab(void *arena, std::size_t arena_size, std::size_t slab_size = kDefaultSlabSize, double factor = 1.25);
+    ~Slab();
+
+    Slab(const Slab &) = delete;
+    Slab &operator=(const Slab &) = delete;
+
+    /**
+     * Returns chunk of at least size bytes aligned to 8, or nullptr if there is no memory left
+     */
+    void *Allocate(std::size_t size);
+
+    /**
+     * Returns chunk got from Allocate back
+     */
+    void Free(void *ptr);
+
+    /**
+     * Chunk allocated by previous owner of the arena, size is the one it was requested with
+     */
+    struct Chunk {
+        void *ptr;
+        std::size_t size;
+    };
+
+    /**
+     * Picks up arena that outlived its previous owner: the given chunks are kept allocated, everything
+     * else becomes free. Size class of each slab is derived from chunks found in it, slabs without chunks
+     * go back to SlabCache. Must be called before anything is allocated, and with the same slab size and
+     * factor the previous owner had.
+     *
+     * Returns false and changes nothing if chunks couldn't come from this allocator: out of the arena, at
+     * wrong offsets, of different classes in the same slab or overlapping
+     */
+    bool Restore(const std::vector<Chunk> &live);
+
+    /**
+     * Gives slab back to SlabCache, so that any class could take it. Caller must have freed all the chunks of
+     * the slab it allocated. Free chunks are picked up from the depot and from magazines of all threads.
+     *
+     * Returns false and keeps the slab if some of its chunks are not found: allocated by another user of the
+     * allocator or moving between a thread and the depot at the moment
+     */
+    bool Release(void *slab);
+
+    // Size class chunks of given size belong to, kNoClass if they are too big
+    std::size_t ClassOf(std::size_t size) const;
+
+    // Size class of chunk got from Allocate
+    std::size_t ClassOf(const void *ptr) const {
+        return _slab_class[_slabs.Index(ptr)].load(std::memory_order_relaxed);
+    }
+
+    // Start of the slab chunk got from Allocate belongs to
+    void *SlabOf(const void *ptr) const { return _slabs.base() + _slabs.Index(ptr) * _slabs.slab_size(); }
+
+    // Size of chunks in the given class
+    std::size_t ClassSize(std::size_t cls) const { return _class_sizes[cls]; }
+
+    // Biggest size Allocate could serve
+    std::size_t max_size() const { return _class_sizes.back(); }
+
+    // Bytes in slabs taken from SlabCache so far
+    std::size_t memory_used() const { return _slabs.slabs_used() * _slabs.slab_size(); }
+
+private:
+    static constexpr std::size_t kMinChunk = 64;
+    static constexpr std::size_t kMagazineSize = 64;
+    static constexpr std::size_t kThreadSlots = 64;
+
+    struct magazine {
+        std::size_t count;
+        void *chunks[kMagazineSize];
+    };
+
+    // Per class state shared by all threads
+    struct size_class {
+        std::mutex lock;
+
+        // Depot of magazines full of chunks and empty ones
+        std::vector<magazine *> full;
+        std::vector<magazine *> empty;
+
+        // Part of the last slab which wasn't carved into chunks yet
+        char *carve = nullptr;
+        char *carve_end = nullptr;
+    };
+
+    // Magazines of a single thread for one class: chunks go out of loaded first, previous is the spare one
+    struct class_cache {
+        magazine *loaded;
+        magazine *previous;
+    };
+
+    struct thread_slot {
+        std::atomic<bool> locked{false};
+        std::vector<class_cache> caches;
+    };
+
+    static std::size_t _ThreadSlot();
+
+    // Refills empty loaded magazine from the depot, returns false if depot has no full ones
+    bool _Reload(size_class &cls, class_cache &cache);
+
+    // Replaces full loaded magazine with an empty one from the depot
+    void _Unload(size_class &cls, class_cache &cache);
+
+    // Moves chunks within [begin, end) out of the magazine to found
+    static void _TakeChunks(magazine *mag, const char *begin, const char *end, std::vector<void *> &found);
+
+    // Cuts new chunk out of the class slab, gets new slab if needed
+    void *_Carve(std::size_t cls_idx);
+
+    void _InitClasses(double factor);
+
+    SlabCache _slabs;
+
+    // Size class of each slab, indexed by SlabCache#Index
+    std::unique_ptr<std::atomic<uint8_t>[]> _slab_class;
+
+    // Chunk size of each class, ascending
+    std::vector<std::size_t> _class_sizes;
+
+    std::unique_ptr<size_class[]> _classes;
+
+    std::unique_ptr<thread_slot[]> _threads;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_H
@@ -1,10 +1,119 @@
 #ifndef AFINA_CONCURRENCY_CORE_LOCAL_H
 #define AFINA_CONCURRENCY_CORE_LOCAL_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <sched.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class CoreLocal {};
+/**
+ * # Value per CPU
+ * Slot for each CPU, each one padded to a cache line. Thread works with the slot of the CPU it runs on,
+ * found by sched_getcpu(), which glibc answers from rseq area or vDSO without a system call. So threads on
+ * different cores never write the same cache line, and reader goes over all slots to aggregate them.
+ *
+ * Thread could be moved to another CPU right after the slot is picked, two threads could end up in the same
+ * slot then. So T must tolerate concurrent access by itself, as std::atomic does, the slot only makes that
+ * rare enough to cost nothing.
+ *
+ * That is thread safe implementation, as far as T is
+ */
+template <typename T> class CoreLocal {
+public:
+    CoreLocal() : _count(1) {
+        // Configured CPUs rather than online ones, as CPU could go online later
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        while (_count < static_cast<std::size_t>(cpus)) {
+            _count *= 2;
+        }
+
+        // new doesn't respect alignment above the fundamental one until C++17
+        void *mem = nullptr;
+        if (posix_memalign(&mem, kCacheLine, sizeof(slot) * _count) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<slot *>(mem);
+        for (std::size_t i = 0; i < _count; ++i) {
+            new (&_slots[i]) slot();
+        }
+    }
+
+    ~CoreLocal() {
+        for (std::size_t i = 0; i < _count; ++i) {
+            _slots[i].~slot();
+        }
+        std::free(_slots);
+    }
+
+    CoreLocal(const CoreLocal &) = delete;
+    CoreLocal &operator=(const CoreLocal &) = delete;
+
+    /**
+     * Slot of the CPU calling thread runs on
+     */
+    T &local() { return _slots[_Cpu()].value; }
+
+    /**
+     * Folds slots of all CPUs with f, starting from init. Slots keep changing meanwhile, so each value is
+     * seen at some moment of the call, that isn't a snapshot
+     */
+    template <typename R, typename F> R Aggregate(R init, F f) const {
+        for (std::size_t i = 0; i < _count; ++i) {
+            init = f(init, _slots[i].value);
+        }
+        return init;
+    }
+
+    std::size_t size() const { return _count; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    struct alignas(kCacheLine) slot {
+        slot() : value() {}
+
+        T value;
+    };
+
+    std::size_t _Cpu() const {
+        int cpu = sched_getcpu();
+        return cpu < 0 ? 0 : static_cast<std::size_t>(cpu) & (_count - 1);
+    }
+
+    // Array of _count slots aligned to kCacheLine, power of two
+    slot *_slots;
+    std::size_t _count;
+};
+
+/**
+ * # Counter sharded per CPU
+ * Add costs a relaxed atomic add on the cache line no other core writes to, Sum goes over all CPUs. Meant
+ * for always on statistics: hits, evictions, bytes, commands and so on.
+ *
+ * That is thread safe implementation
+ */
+class CoreCounter {
+public:
+    CoreCounter() {}
+
+    void Add(uint64_t n = 1) { _slots.local().fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Sum() const {
+        return _slots.Aggregate(uint64_t(0), [](uint64_t sum, const std::atomic<uint64_t> &v) {
+            return sum + v.load(std::memory_order_relaxed);
+        });
+    }
+
+private:
+    CoreLocal<std::atomic<uint64_t>> _slots;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -1,10 +1,177 @@
 #ifndef AFINA_CONCURRENCY_FLAT_COMBINE_H
 #define AFINA_CONCURRENCY_FLAT_COMBINE_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <thread>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename Op> class FlatCombine {};
+/**
+ * # Flat combining
+ * Executes operations on a data structure that isn't thread safe, one at a time. Instead of taking a lock
+ * itself each thread publishes its operation into a slot and the thread that got combiner lock executes
+ * all published operations in a batch, while the rest wait for their results. So the structure stays hot
+ * in cache of a single core and lock cache line goes back and forth once per batch, not once per call.
+ *
+ * Op is called with no arguments on the combiner thread, and must write its result to where the caller
+ * reads it from after Execute returns. Exception thrown by Op is passed back to the caller of Execute.
+ *
+ * Thread prefers the slot it was given on the first call, and looks for another one if that is taken, so
+ * any number of threads could use it. Slot holds a pointer to request living on the waiting thread stack.
+ *
+ * That is thread safe implementation
+ */
+template <typename Op> class FlatCombine {
+public:
+    /**
+     * @param slots number of publication slots, rounded up to power of two. Twice the number of cores if 0
+     */
+    explicit FlatCombine(std::size_t slots = 0) : _slot_count(1), _locked(false) {
+        if (slots == 0) {
+            slots = 2 * std::max(1u, std::thread::hardware_concurrency());
+        }
+        while (_slot_count < slots) {
+            _slot_count *= 2;
+        }
+
+        // new doesn't respect alignment above the fundamental one until C++17
+        void *mem = nullptr;
+        if (posix_memalign(&mem, kCacheLine, sizeof(slot) * _slot_count) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<slot *>(mem);
+        for (std::size_t i = 0; i < _slot_count; ++i) {
+            new (&_slots[i]) slot();
+        }
+    }
+
+    ~FlatCombine() {
+        for (std::size_t i = 0; i < _slot_count; ++i) {
+            _slots[i].~slot();
+        }
+        std::free(_slots);
+    }
+
+    FlatCombine(const FlatCombine &) = delete;
+    FlatCombine &operator=(const FlatCombine &) = delete;
+
+    /**
+     * Executes op, maybe on another thread, and returns once it is done
+     */
+    void Execute(Op &op) {
+        request req(op);
+        _Publish(req);
+
+        for (std::size_t spins = 0; !req.done.load(std::memory_order_acquire); ++spins) {
+            if (try_lock()) {
+                _Combine();
+                unlock();
+            } else if (spins >= kSpins) {
+                std::this_thread::yield();
+            }
+        }
+
+        if (req.error) {
+            std::rethrow_exception(req.error);
+        }
+    }
+
+    /**
+     * Takes combiner lock, so that nothing is executed until unlock. Published operations wait meanwhile
+     */
+    void lock() {
+        while (!try_lock()) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() { _locked.store(false, std::memory_order_release); }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    // Waiting thread checks the result that many times before it starts to yield
+    static constexpr std::size_t kSpins = 64;
+
+    // Combiner goes over slots again while the previous pass found something, but at most that many times
+    static constexpr std::size_t kPasses = 4;
+
+    struct request {
+        explicit request(Op &op_) : op(op_), done(false) {}
+
+        Op &op;
+        std::atomic<bool> done;
+        std::exception_ptr error;
+    };
+
+    struct alignas(kCacheLine) slot {
+        slot() : req(nullptr) {}
+
+        std::atomic<request *> req;
+    };
+
+    // Puts request into the preferred slot of the thread or the next free one
+    void _Publish(request &req) {
+        // Threads are spread over slots round robin in order of their first call
+        static std::atomic<std::size_t> next(0);
+        static thread_local std::size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+
+        for (std::size_t i = idx;; ++i) {
+            request *expected = nullptr;
+            std::atomic<request *> &s = _slots[i & (_slot_count - 1)].req;
+            if (s.load(std::memory_order_relaxed) == nullptr &&
+                s.compare_exchange_strong(expected, &req, std::memory_order_release)) {
+                return;
+            }
+            if (((i - idx + 1) & (_slot_count - 1)) == 0) {
+                // All slots are taken, let the combiner free some
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Executes published requests, must be called with combiner lock held
+    void _Combine() {
+        for (std::size_t pass = 0; pass < kPasses; ++pass) {
+            bool found = false;
+            for (std::size_t i = 0; i < _slot_count; ++i) {
+                std::atomic<request *> &s = _slots[i].req;
+                if (s.load(std::memory_order_relaxed) == nullptr) {
+                    continue;
+                }
+
+                request *req = s.exchange(nullptr, std::memory_order_acquire);
+                try {
+                    req->op();
+                } catch (...) {
+                    req->error = std::current_exception();
+                }
+                req->done.store(true, std::memory_order_release);
+                found = true;
+            }
+            if (!found) {
+                break;
+            }
+        }
+    }
+
+    // Array of _slot_count slots aligned to kCacheLine, power of two
+    slot *_slots;
+    std::size_t _slot_count;
+
+    // Combiner lock, waiting threads read it before trying to take it
+    std::atomic<bool> _locked;
+};
 
 } // namespace Concurrency
 } // namespace Afina
@@ -0,0 +1,61 @@
+#ifndef AFINA_CONCURRENCY_SHARED_MUTEX_H
+#define AFINA_CONCURRENCY_SHARED_MUTEX_H
+
+#include <pthread.h>
+#include <system_error>
+
+namespace Afina {
+namespace Concurrency {
+
+/**
+ * # Readers-writer lock
+ * Any number of readers could hold lock at the same time, writer holds it exclusively. Satisfies
+ * Lockable, so std::unique_lock could be used for exclusive ownership, see SharedLock for the
+ * shared one.
+ *
+ * std::shared_mutex is C++17 only, so that is a thin wrapper over pthread rwlock
+ */
+class SharedMutex {
+public:
+    SharedMutex() {
+        int err = pthread_rwlock_init(&_lock, nullptr);
+        if (err != 0) {
+            throw std::system_error(err, std::system_category(), "pthread_rwlock_init");
+        }
+    }
+    ~SharedMutex() { pthread_rwlock_destroy(&_lock); }
+
+    void lock() { pthread_rwlock_wrlock(&_lock); }
+    bool try_lock() { return pthread_rwlock_trywrlock(&_lock) == 0; }
+    void unlock() { pthread_rwlock_unlock(&_lock); }
+
+    void lock_shared() { pthread_rwlock_rdlock(&_lock); }
+    bool try_lock_shared() { return pthread_rwlock_tryrdlock(&_lock) == 0; }
+    void unlock_shared() { pthread_rwlock_unlock(&_lock); }
+
+private:
+    SharedMutex(const SharedMutex &) = delete;
+    SharedMutex &operator=(const SharedMutex &) = delete;
+
+    pthread_rwlock_t _lock;
+};
+
+/**
+ * # Scoped shared ownership of SharedMutex
+ */
+class SharedLock {
+public:
+    explicit SharedLock(SharedMutex &mutex) : _mutex(mutex) { _mutex.lock_shared(); }
+    ~SharedLock() { _mutex.unlock_shared(); }
+
+private:
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+
+    SharedMutex &_mutex;
+};
+
+} // namespace Concurrency
+} // namespace Afina
+
+#endif // AFINA_CONCURRENCY_SHARED_MUTEX_H
@@ -1,10 +1,177 @@
 #ifndef AFINA_CONCURRENCY_THREAD_LOCAL_H
 #define AFINA_CONCURRENCY_THREAD_LOCAL_H
 
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace Afina {
 namespace Concurrency {
 
-template <typename T> class ThreadLocal {};
+/**
+ * # Object per thread and per instance
+ * Unlike thread_local, which is static, each ThreadLocal instance holds its own object for each thread, so
+ * it could be a member of a server, a storage or anything else created at runtime.
+ *
+ * Each instance gets an index, reused once the instance is gone, and each thread has a vector of objects
+ * indexed by it, so get() is a thread_local lookup and a vector access. Object is created on the first
+ * get() in the thread.
+ *
+ * Objects are destroyed when their thread exits, or when the instance is destroyed, whichever comes first.
+ * In the latter case objects of all threads are destroyed by the thread destroying the instance, so no
+ * thread must be using it at that moment. Destructor of T runs with no locks held, so it could use other
+ * ThreadLocal instances.
+ *
+ * Creation of objects, thread exit and ForEach are serialized on a single mutex shared by all instances,
+ * get() of an existing object takes no locks.
+ *
+ * That is thread safe implementation
+ */
+template <typename T> class ThreadLocal {
+public:
+    using Factory = std::function<T *()>;
+
+    ThreadLocal() : ThreadLocal([]() { return new T(); }) {}
+
+    /**
+     * @param factory creates object for a thread, called by that thread on the first get()
+     */
+    explicit ThreadLocal(Factory factory) : _factory(std::move(factory)) {
+        registry &r = _Registry();
+        std::unique_lock<std::mutex> lock(r.mutex);
+        if (r.free_ids.empty()) {
+            _id = r.next_id++;
+        } else {
+            _id = r.free_ids.back();
+            r.free_ids.pop_back();
+        }
+    }
+
+    ~ThreadLocal() {
+        std::vector<void *> objects;
+        {
+            registry &r = _Registry();
+            std::unique_lock<std::mutex> lock(r.mutex);
+            for (auto &it : _objects) {
+                it.first->slots[_id] = slot();
+                objects.push_back(it.second);
+            }
+            r.free_ids.push_back(_id);
+        }
+        for (void *object : objects) {
+            delete static_cast<T *>(object);
+        }
+    }
+
+    ThreadLocal(const ThreadLocal &) = delete;
+    ThreadLocal &operator=(const ThreadLocal &) = delete;
+
+    /**
+     * Object of the calling thread, created if there is none yet
+     */
+    T &get() {
+        thread_entry &entry = _Entry();
+        if (_id < entry.slots.size() && entry.slots[_id].object != nullptr) {
+            return *static_cast<T *>(entry.slots[_id].object);
+        }
+        return _Create(entry);
+    }
+
+    T *operator->() { return &get(); }
+    T &operator*() { return get(); }
+
+    /**
+     * Calls f for object of each live thread that has one. Threads could keep using their objects meanwhile,
+     * so T must tolerate that, but none of them is created or destroyed until ForEach returns
+     */
+    template <typename F> void ForEach(F f) {
+        registry &r = _Registry();
+        std::unique_lock<std::mutex> lock(r.mutex);
+        for (auto &it : _objects) {
+            f(*static_cast<T *>(it.second));
+        }
+    }
+
+private:
+    struct thread_entry;
+
+    // Object of one instance in the thread
+    struct slot {
+        slot() : object(nullptr), deleter(nullptr), objects(nullptr) {}
+
+        void *object;
+        void (*deleter)(void *object);
+
+        // Registry of the instance to remove object from once thread exits
+        std::unordered_map<thread_entry *, void *> *objects;
+    };
+
+    // Objects of the thread, indexed by instance id
+    struct thread_entry {
+        ~thread_entry() {
+            std::vector<slot> alive;
+            {
+                registry &r = _Registry();
+                std::unique_lock<std::mutex> lock(r.mutex);
+                for (auto &s : slots) {
+                    if (s.object != nullptr) {
+                        s.objects->erase(this);
+                        alive.push_back(s);
+                    }
+                }
+                slots.clear();
+            }
+            for (auto &s : alive) {
+                s.deleter(s.object);
+            }
+        }
+
+        std::vector<slot> slots;
+    };
+
+    // State shared by all instances of the same T
+    struct registry {
+        registry() : next_id(0) {}
+
+        std::mutex mutex;
+        std::size_t next_id;
+        std::vector<std::size_t> free_ids;
+    };
+
+    static registry &_Registry() {
+        static registry r;
+        return r;
+    }
+
+    static thread_entry &_Entry() {
+        static thread_local thread_entry entry;
+        return entry;
+    }
+
+    T &_Create(thread_entry &entry) {
+        T *object = _factory();
+        registry &r = _Registry();
+        std::unique_lock<std::mutex> lock(r.mutex);
+        if (entry.slots.size() <= _id) {
+            entry.slots.resize(_id + 1);
+        }
+        slot &s = entry.slots[_id];
+        s.object = object;
+        s.deleter = [](void *object) { delete static_cast<T *>(object); };
+        s.objects = &_objects;
+        _objects.emplace(&entry, object);
+        return *object;
+    }
+
+    Factory _factory;
+    std::size_t _id;
+
+    // Objects of all threads, guarded by the registry mutex
+    std::unordered_map<thread_entry *, void *> _objects;
+};
 
 } // namespace Concurrency
 } // namespace Afina
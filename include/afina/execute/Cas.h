@@ -0,0 +1,41 @@
+#ifndef AFINA_EXECUTE_CAS_H
+#define AFINA_EXECUTE_CAS_H
+
+#include <cstdint>
+#include <string>
+
+#include "InsertCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Check and set
+ * Stores data for the given key only if nobody else has updated it since the
+ * client last fetched it, client passes version of the value it got by "gets"
+ *
+ * Command must write result to the output, which could be:
+ * - "STORED", to indicate success.
+ * - "NOT_STORED" to indicate the data was not stored, but not because of an
+ * error.
+ * - "EXISTS" to indicate that the item has been modified since it was fetched.
+ * - "NOT_FOUND" to indicate that the item did not exist or has been deleted.
+ */
+class Cas : public InsertCommand {
+public:
+    Cas(const std::string &key, uint32_t flags, int32_t expire, uint64_t cas)
+        : InsertCommand(key, flags, expire), _cas(cas) {}
+    ~Cas() {}
+
+    inline const uint64_t cas() const { return _cas; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const uint64_t _cas;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_CAS_H
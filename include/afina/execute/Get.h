@@ -26,6 +26,10 @@ namespace Execute {
  * Where <key> is the key for the value, <bytes> is the number of bytes in the
  * value and <data> is the value text
  *
+ * Command built for "gets" adds version of the value to each item line, client
+ * passes it back into "cas":
+ * VALUE <key> <bytes> <cas unique>\r\n
+ *
  * If some of the keys appearing in a retrieval request are not sent back
  * by the server in the item list this means that the server does not
  * hold items with such keys (because they were never stored, or stored
@@ -34,15 +38,19 @@ namespace Execute {
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys, bool cas = false) : _keys(keys), _cas(cas) {}
     ~Get() {}
 
     inline const std::vector<std::string> &keys() const { return _keys; }
+    inline bool cas() const { return _cas; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
     std::vector<std::string> _keys;
+
+    // Whether versions of values are sent back
+    bool _cas;
 };
 
 } // namespace Execute
@@ -0,0 +1,47 @@
+#ifndef AFINA_EXECUTE_INCR_H
+#define AFINA_EXECUTE_INCR_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Change counter for the key
+ * Adds delta to the value of existing key, which must be decimal representation of
+ * 64-bit unsigned integer. Command built for "decr" subtracts delta instead, counter
+ * never goes below 0 then. Increment wraps around on overflow
+ *
+ * Command must write result to the output, which could be:
+ * - new value of the counter, to indicate success
+ * - "NOT_FOUND" to indicate that the item with this key was not found
+ * - "CLIENT_ERROR ..." if the value isn't a number
+ * - "SERVER_ERROR ..." if new value couldn't be stored
+ */
+class Incr : public Command {
+public:
+    Incr(const std::string &key, uint64_t delta, bool decrement = false)
+        : _key(key), _delta(delta), _decrement(decrement) {}
+    ~Incr() {}
+
+    inline const std::string &key() const { return _key; }
+    inline uint64_t delta() const { return _delta; }
+    inline bool decrement() const { return _decrement; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    const std::string _key;
+    const uint64_t _delta;
+
+    // Whether delta is subtracted
+    const bool _decrement;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INCR_H
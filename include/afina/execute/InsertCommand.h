@@ -2,6 +2,7 @@
 #define AFINA_EXECUTE_INSERT_COMMAND_H
 
 #include <cstdint>
+#include <ctime>
 #include <string>
 
 #include "Command.h"
@@ -22,7 +23,27 @@ public:
     inline const uint32_t flags() const { return _flags; }
     inline const int32_t expire() const { return _expire; }
 
+    /**
+     * Converts memcached exptime into the unix time value expires at, as Storage expects it. Zero means
+     * value never expires. Up to 30 days exptime is the number of seconds from now, anything bigger is
+     * the unix time already. Negative exptime makes value expired right away
+     */
+    std::time_t deadline() const {
+        if (_expire == 0) {
+            return 0;
+        }
+        if (_expire < 0) {
+            return -1;
+        }
+        if (_expire <= kMaxRelativeExpire) {
+            return std::time(nullptr) + _expire;
+        }
+        return _expire;
+    }
+
 protected:
+    static constexpr int32_t kMaxRelativeExpire = 60 * 60 * 24 * 30;
+
     const std::string _key;
     const uint32_t _flags;
     const int32_t _expire;
@@ -1,9 +1,12 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include <afina/concurrency/CoreLocal.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -17,6 +20,19 @@ namespace Network {
  */
 class Server {
 public:
+    /**
+     * Counters of the network activity, kept per CPU so that workers could bump them on each command
+     */
+    struct Stats {
+        // Connections accepted and commands executed
+        uint64_t connections;
+        uint64_t commands;
+
+        // Bytes read from the clients and sent back to them
+        uint64_t bytes_read;
+        uint64_t bytes_written;
+    };
+
     Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
         : pStorage(ps), pLogging(pl) {}
     virtual ~Server() {}
@@ -44,6 +60,10 @@ public:
      */
     virtual void Join() = 0;
 
+    Stats GetStats() const {
+        return Stats{_connections.Sum(), _commands.Sum(), _bytes_read.Sum(), _bytes_written.Sum()};
+    }
+
 protected:
     /**
      * Instance of backing storeage on which current server should execute
@@ -55,6 +75,14 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Counters reported by GetStats, implementations bump them as they go
+     */
+    Concurrency::CoreCounter _connections;
+    Concurrency::CoreCounter _commands;
+    Concurrency::CoreCounter _bytes_read;
+    Concurrency::CoreCounter _bytes_written;
 };
 
 } // namespace Network
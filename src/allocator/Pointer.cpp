@@ -3,12 +3,22 @@
 namespace Afina {
 namespace Allocator {
 
-Pointer::Pointer() {}
-Pointer::Pointer(const Pointer &) {}
-Pointer::Pointer(Pointer &&) {}
+Pointer::Pointer() : _handle(nullptr) {}
+Pointer::Pointer(const Pointer &other) : _handle(other._handle) {}
+Pointer::Pointer(Pointer &&other) : _handle(other._handle) { other._handle = nullptr; }
 
-Pointer &Pointer::operator=(const Pointer &) { return *this; }
-Pointer &Pointer::operator=(Pointer &&) { return *this; }
+Pointer &Pointer::operator=(const Pointer &other) {
+    _handle = other._handle;
+    return *this;
+}
+
+Pointer &Pointer::operator=(Pointer &&other) {
+    if (this != &other) {
+        _handle = other._handle;
+        other._handle = nullptr;
+    }
+    return *this;
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -1,40 +1,350 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+// Block sizes and addresses are multiples of that
+static constexpr size_t kAlign = sizeof(void *);
+
+// Smallest payload, so that any block could become a hole and hold list links
+static constexpr size_t kMinPayload = 2 * sizeof(void *);
+
+// How many holes of the best fitting bin are checked before going to the bigger bins
+static constexpr size_t kBinScan = 8;
+
+// How many steps defrag() makes between checks whether pass is over
+static constexpr size_t kDefragSteps = 64;
+
+struct Simple::block {
+    // Payload bytes after the header
+    size_t size;
+
+    // Table entry of the block, nullptr for holes
+    void **handle;
+
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+    block *next() { return reinterpret_cast<block *>(data() + size); }
+    size_t total() const { return sizeof(block) + size; }
+
+    // Hole list links live in the payload
+    block *&prev_hole() { return reinterpret_cast<block **>(data())[0]; }
+    block *&next_hole() { return reinterpret_cast<block **>(data())[1]; }
+};
+
+static size_t AlignSize(size_t size) {
+    size = (size + kAlign - 1) & ~(kAlign - 1);
+    return std::max(size, kMinPayload);
+}
+
+static size_t BinOf(size_t size) { return 63 - __builtin_clzll(size); }
+
+Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + kAlign - 1) & ~(kAlign - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(kAlign - 1);
+    if (end < begin) {
+        end = begin;
+    }
+
+    _heap = _top = reinterpret_cast<char *>(begin);
+    _table = _table_end = reinterpret_cast<void **>(end);
+    _free_handles = nullptr;
+    _free_bytes = 0;
+    std::fill(_bins, _bins + kBins, nullptr);
+    _defrag_pos = nullptr;
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    size_t size = AlignSize(N);
+    void **handle = _NewHandle();
+    if (handle == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for a new pointer");
+    }
+
+    block *b = _AllocBlock(size);
+    if (b == nullptr) {
+        *handle = _free_handles;
+        _free_handles = handle;
+        throw AllocError(AllocErrorType::NoMemory, "No room for " + std::to_string(N) + " bytes");
+    }
+
+    b->handle = handle;
+    *handle = b->data();
+    return Pointer(handle);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._handle == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    block *b = _BlockOf(p);
+    size_t size = AlignSize(N);
+    if (size <= b->size) {
+        _Shrink(b, size);
+        return;
+    }
+
+    // Grow in place over the following holes or the free space
+    _Absorb(b);
+    char *end = b->data() + size;
+    if (reinterpret_cast<char *>(b->next()) == _top && end <= reinterpret_cast<char *>(_table)) {
+        b->size = size;
+        _top = end;
+        return;
+    }
+    if (size <= b->size) {
+        _Shrink(b, size);
+        return;
+    }
+
+    block *moved = _AllocBlock(size);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for " + std::to_string(N) + " bytes");
+    }
+    std::memcpy(moved->data(), b->data(), b->size);
+    moved->handle = b->handle;
+    *moved->handle = moved->data();
+    _Release(b);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._handle == nullptr) {
+        return;
+    }
+
+    block *b = _BlockOf(p);
+    void **handle = b->handle;
+    _Release(b);
+
+    *handle = _free_handles;
+    _free_handles = handle;
+    p._handle = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    _defrag_pos = nullptr;
+    while (!defrag(kDefragSteps)) {
+    }
+}
+
+// See Simple.h
+bool Simple::defrag(size_t steps) {
+    if (_defrag_pos == nullptr) {
+        _defrag_pos = _heap;
+    }
+
+    for (; steps > 0; --steps) {
+        if (_defrag_pos >= _top) {
+            _defrag_pos = nullptr;
+            return true;
+        }
+
+        block *b = reinterpret_cast<block *>(_defrag_pos);
+        if (b->handle) {
+            _defrag_pos = reinterpret_cast<char *>(b->next());
+            continue;
+        }
+
+        _RemoveHole(b);
+        _Absorb(b);
+        block *next = b->next();
+        if (reinterpret_cast<char *>(next) == _top) {
+            // Hole reached the top, it becomes a part of the free space
+            _top = _defrag_pos;
+            _defrag_pos = nullptr;
+            return true;
+        }
+
+        // Slide the next used block down, the hole moves up right after it
+        size_t hole = b->total();
+        std::memmove(b, next, next->total());
+        *b->handle = b->data();
+
+        block *rest = b->next();
+        rest->size = hole - sizeof(block);
+        _defrag_pos = reinterpret_cast<char *>(rest);
+        _Release(rest);
+    }
+    return false;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    out << "blocks " << (_top - _heap) << " bytes, holes " << _free_bytes << " bytes, free "
+        << (reinterpret_cast<char *>(_table) - _top) << " bytes, table " << (_table_end - _table) << " entries"
+        << std::endl;
+
+    for (char *pos = _heap; pos < _top;) {
+        block *b = reinterpret_cast<block *>(pos);
+        out << (pos - _heap) << ": " << (b->handle ? "used " : "hole ") << b->size << std::endl;
+        pos = reinterpret_cast<char *>(b->next());
+    }
+    return out.str();
+}
+
+// See Simple.h
+size_t Simple::free_bytes() const { return _free_bytes + (reinterpret_cast<char *>(_table) - _top); }
+
+// See Simple.h
+size_t Simple::max_alloc() const {
+    size_t best = reinterpret_cast<char *>(_table) - _top;
+    best = best > sizeof(block) ? best - sizeof(block) : 0;
+    for (size_t bin = kBins; bin > 0; --bin) {
+        for (block *b = _bins[bin - 1]; b; b = b->next_hole()) {
+            best = std::max(best, b->size);
+        }
+        if (_bins[bin - 1]) {
+            break;
+        }
+    }
+    return best;
+}
+
+Simple::block *Simple::_AllocBlock(size_t size) {
+    block *b = _FindHole(size);
+    if (b) {
+        _RemoveHole(b);
+        b->handle = nullptr;
+        _Shrink(b, size);
+        return b;
+    }
+
+    if (_top + sizeof(block) + size > reinterpret_cast<char *>(_table)) {
+        return nullptr;
+    }
+    b = reinterpret_cast<block *>(_top);
+    b->size = size;
+    b->handle = nullptr;
+    _top += b->total();
+    return b;
+}
+
+void Simple::_Release(block *b) {
+    b->handle = nullptr;
+    _Absorb(b);
+    if (reinterpret_cast<char *>(b->next()) == _top) {
+        _top = reinterpret_cast<char *>(b);
+    } else {
+        _InsertHole(b);
+    }
+}
+
+void Simple::_Shrink(block *b, size_t size) {
+    if (reinterpret_cast<char *>(b->next()) == _top) {
+        b->size = size;
+        _top = reinterpret_cast<char *>(b->next());
+        return;
+    }
+    if (b->size < size + sizeof(block) + kMinPayload) {
+        // Too small for a block of its own, tail stays a part of b
+        return;
+    }
+
+    block *rest = reinterpret_cast<block *>(b->data() + size);
+    rest->size = b->size - size - sizeof(block);
+    b->size = size;
+    _Release(rest);
+}
+
+void Simple::_Absorb(block *b) {
+    char *begin = reinterpret_cast<char *>(b);
+    while (reinterpret_cast<char *>(b->next()) < _top && b->next()->handle == nullptr) {
+        block *next = b->next();
+        _RemoveHole(next);
+        b->size += next->total();
+    }
+
+    // Defrag pass must stay on a block boundary
+    if (_defrag_pos > begin && _defrag_pos < reinterpret_cast<char *>(b->next())) {
+        _defrag_pos = begin;
+    }
+}
+
+Simple::block *Simple::_FindHole(size_t size) {
+    // Holes of the same bin could be smaller, a few of them are checked
+    size_t bin = BinOf(size);
+    size_t scanned = 0;
+    for (block *b = _bins[bin]; b && scanned < kBinScan; b = b->next_hole(), ++scanned) {
+        if (b->size >= size) {
+            return b;
+        }
+    }
+
+    // Any hole of the bigger bins fits
+    for (++bin; bin < kBins; ++bin) {
+        if (_bins[bin]) {
+            return _bins[bin];
+        }
+    }
+    return nullptr;
+}
+
+void Simple::_InsertHole(block *b) {
+    b->handle = nullptr;
+    block *&head = _bins[BinOf(b->size)];
+    b->prev_hole() = nullptr;
+    b->next_hole() = head;
+    if (head) {
+        head->prev_hole() = b;
+    }
+    head = b;
+    _free_bytes += b->total();
+}
+
+void Simple::_RemoveHole(block *b) {
+    if (b->prev_hole()) {
+        b->prev_hole()->next_hole() = b->next_hole();
+    } else {
+        _bins[BinOf(b->size)] = b->next_hole();
+    }
+    if (b->next_hole()) {
+        b->next_hole()->prev_hole() = b->prev_hole();
+    }
+    _free_bytes -= b->total();
+}
+
+Simple::block *Simple::_BlockOf(const Pointer &p) const {
+    void **handle = p._handle;
+    if (handle < _table || handle >= _table_end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+
+    char *data = static_cast<char *>(*handle);
+    if (data < _heap + sizeof(block) || data > _top) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer was freed already");
+    }
+    block *b = reinterpret_cast<block *>(data - sizeof(block));
+    if (b->handle != handle) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer was freed already");
+    }
+    return b;
+}
+
+void **Simple::_NewHandle() {
+    if (_free_handles) {
+        void **handle = _free_handles;
+        _free_handles = static_cast<void **>(*handle);
+        return handle;
+    }
+    if (reinterpret_cast<char *>(_table - 1) < _top) {
+        return nullptr;
+    }
+    return --_table;
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -0,0 +1,400 @@
+#include <afina/allocator/Slab.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+constexpr std::size_t Slab::kDefaultSlabSize;
+constexpr std::size_t Slab::kNoClass;
+constexpr std::size_t Slab::kMinChunk;
+constexpr std::size_t Slab::kMagazineSize;
+constexpr std::size_t Slab::kThreadSlots;
+
+SlabCache::SlabCache(std::size_t memory_limit, std::size_t slab_size)
+    : _base(nullptr), _owned(true), _slab_size(slab_size),
+      _slab_count(std::min<std::size_t>(memory_limit / slab_size, UINT32_MAX - 1)), _bump(0), _free(0),
+      _next(new std::atomic<uint32_t>[_slab_count]), _used(0) {
+    if (_slab_count == 0) {
+        return;
+    }
+
+    // Address space only, pages are backed by memory on the first touch
+    void *base = mmap(nullptr, _slab_count * _slab_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        throw AllocError(AllocErrorType::NoMemory, std::string("Failed to reserve slabs: ") + std::strerror(errno));
+    }
+    _base = static_cast<char *>(base);
+}
+
+SlabCache::SlabCache(void *arena, std::size_t arena_size, std::size_t slab_size)
+    : _base(static_cast<char *>(arena)), _owned(false), _slab_size(slab_size),
+      _slab_count(std::min<std::size_t>(arena_size / slab_size, UINT32_MAX - 1)), _bump(0), _free(0),
+      _next(new std::atomic<uint32_t>[_slab_count]), _used(0) {}
+
+SlabCache::~SlabCache() {
+    if (_base && _owned) {
+        munmap(_base, _slab_count * _slab_size);
+    }
+}
+
+// See Slab.h
+void *SlabCache::Get() {
+    uint64_t head = _free.load(std::memory_order_acquire);
+    while (uint32_t(head) != 0) {
+        uint32_t idx = uint32_t(head) - 1;
+        uint64_t next = (((head >> 32) + 1) << 32) | _next[idx].load(std::memory_order_relaxed);
+        if (_free.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+            _used.fetch_add(1, std::memory_order_relaxed);
+            return _base + idx * _slab_size;
+        }
+    }
+
+    std::size_t idx = _bump.load(std::memory_order_relaxed);
+    while (idx < _slab_count && !_bump.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) {
+    }
+    if (idx >= _slab_count) {
+        return nullptr;
+    }
+    _used.fetch_add(1, std::memory_order_relaxed);
+    return _base + idx * _slab_size;
+}
+
+// See Slab.h
+void SlabCache::Put(void *slab) {
+    // Shared pages stay in the segment until they are removed explicitly
+    if (_owned || madvise(slab, _slab_size, MADV_REMOVE) != 0) {
+        madvise(slab, _slab_size, MADV_DONTNEED);
+    }
+
+    uint32_t idx = Index(slab);
+    uint64_t head = _free.load(std::memory_order_relaxed);
+    uint64_t top;
+    do {
+        _next[idx].store(uint32_t(head), std::memory_order_relaxed);
+        top = (((head >> 32) + 1) << 32) | (idx + 1);
+    } while (!_free.compare_exchange_weak(head, top, std::memory_order_release, std::memory_order_relaxed));
+    _used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// See Slab.h
+void SlabCache::Restore(const std::vector<bool> &taken) {
+    std::size_t bump = 0, used = 0;
+    for (std::size_t idx = 0; idx < _slab_count && idx < taken.size(); ++idx) {
+        if (taken[idx]) {
+            bump = idx + 1;
+            used++;
+        }
+    }
+
+    // Free slabs below the bump go to the stack, lower ones on top
+    uint32_t head = 0;
+    for (std::size_t idx = bump; idx-- > 0;) {
+        if (!taken[idx]) {
+            _next[idx].store(head, std::memory_order_relaxed);
+            head = idx + 1;
+        }
+    }
+    _free.store(head, std::memory_order_relaxed);
+    _bump.store(bump, std::memory_order_relaxed);
+    _used.store(used, std::memory_order_relaxed);
+}
+
+static std::size_t RoundToPages(std::size_t size) {
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+Slab::Slab(std::size_t memory_limit, std::size_t slab_size, double factor)
+    : _slabs(memory_limit, RoundToPages(std::max(slab_size, kMinChunk))),
+      _slab_class(new std::atomic<uint8_t>[_slabs.slab_count()]), _threads(new thread_slot[kThreadSlots]) {
+    _InitClasses(factor);
+}
+
+Slab::Slab(void *arena, std::size_t arena_size, std::size_t slab_size, double factor)
+    : _slabs(arena, arena_size, RoundToPages(std::max(slab_size, kMinChunk))),
+      _slab_class(new std::atomic<uint8_t>[_slabs.slab_count()]), _threads(new thread_slot[kThreadSlots]) {
+    _InitClasses(factor);
+}
+
+void Slab::_InitClasses(double factor) {
+    // Class index is kept in a byte, the last one is always the whole slab
+    std::size_t size = kMinChunk;
+    while (size < _slabs.slab_size() && _class_sizes.size() < 255) {
+        _class_sizes.push_back(size);
+        std::size_t next = std::size_t(size * factor + 7) & ~std::size_t(7);
+        size = std::max(next, size + 8);
+    }
+    _class_sizes.push_back(_slabs.slab_size());
+
+    _classes.reset(new size_class[_class_sizes.size()]);
+    for (std::size_t i = 0; i < kThreadSlots; ++i) {
+        _threads[i].caches.assign(_class_sizes.size(), class_cache{nullptr, nullptr});
+    }
+}
+
+Slab::~Slab() {
+    for (std::size_t i = 0; i < kThreadSlots; ++i) {
+        for (class_cache &cache : _threads[i].caches) {
+            delete cache.loaded;
+            delete cache.previous;
+        }
+    }
+    for (std::size_t i = 0; i < _class_sizes.size(); ++i) {
+        for (magazine *mag : _classes[i].full) {
+            delete mag;
+        }
+        for (magazine *mag : _classes[i].empty) {
+            delete mag;
+        }
+    }
+}
+
+// See Slab.h
+void *Slab::Allocate(std::size_t size) {
+    std::size_t idx = ClassOf(size);
+    if (idx == kNoClass) {
+        return nullptr;
+    }
+
+    thread_slot &slot = _threads[_ThreadSlot()];
+    while (slot.locked.exchange(true, std::memory_order_acquire)) {
+    }
+
+    void *ptr = nullptr;
+    class_cache &cache = slot.caches[idx];
+    if (cache.loaded == nullptr || cache.loaded->count == 0) {
+        if (cache.previous && cache.previous->count > 0) {
+            std::swap(cache.loaded, cache.previous);
+        } else {
+            _Reload(_classes[idx], cache);
+        }
+    }
+    if (cache.loaded && cache.loaded->count > 0) {
+        ptr = cache.loaded->chunks[--cache.loaded->count];
+    }
+    slot.locked.store(false, std::memory_order_release);
+
+    return ptr ? ptr : _Carve(idx);
+}
+
+// See Slab.h
+void Slab::Free(void *ptr) {
+    std::size_t idx = ClassOf(static_cast<const void *>(ptr));
+
+    thread_slot &slot = _threads[_ThreadSlot()];
+    while (slot.locked.exchange(true, std::memory_order_acquire)) {
+    }
+
+    class_cache &cache = slot.caches[idx];
+    if (cache.loaded == nullptr || cache.loaded->count == kMagazineSize) {
+        if (cache.previous && cache.previous->count == 0) {
+            std::swap(cache.loaded, cache.previous);
+        } else {
+            _Unload(_classes[idx], cache);
+        }
+    }
+    cache.loaded->chunks[cache.loaded->count++] = ptr;
+    slot.locked.store(false, std::memory_order_release);
+}
+
+// See Slab.h
+bool Slab::Restore(const std::vector<Chunk> &live) {
+    std::vector<Chunk> chunks(live);
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk &a, const Chunk &b) { return a.ptr < b.ptr; });
+
+    const char *base = _slabs.base();
+    std::size_t slab_size = _slabs.slab_size();
+    std::vector<std::size_t> classes(_slabs.slab_count(), kNoClass);
+    const char *prev_end = base;
+    for (const Chunk &chunk : chunks) {
+        const char *ptr = static_cast<const char *>(chunk.ptr);
+        std::size_t cls = ClassOf(chunk.size);
+        if (ptr < prev_end || cls == kNoClass || ptr >= base + _slabs.slab_count() * slab_size) {
+            return false;
+        }
+
+        std::size_t idx = _slabs.Index(ptr);
+        std::size_t offset = ptr - (base + idx * slab_size);
+        if (offset % _class_sizes[cls] != 0 || offset + _class_sizes[cls] > slab_size ||
+            (classes[idx] != kNoClass && classes[idx] != cls)) {
+            return false;
+        }
+        classes[idx] = cls;
+        prev_end = ptr + _class_sizes[cls];
+    }
+
+    std::vector<bool> taken(classes.size());
+    for (std::size_t idx = 0; idx < classes.size(); ++idx) {
+        taken[idx] = classes[idx] != kNoClass;
+    }
+    _slabs.Restore(taken);
+
+    // Every chunk of a taken slab that isn't live goes to the class depot
+    auto next_live = chunks.begin();
+    for (std::size_t idx = 0; idx < classes.size(); ++idx) {
+        if (!taken[idx]) {
+            continue;
+        }
+        _slab_class[idx].store(classes[idx], std::memory_order_relaxed);
+
+        size_class &cls = _classes[classes[idx]];
+        std::size_t size = _class_sizes[classes[idx]];
+        char *slab = _slabs.base() + idx * slab_size;
+        for (char *ptr = slab; ptr + size <= slab + slab_size; ptr += size) {
+            if (next_live != chunks.end() && next_live->ptr == ptr) {
+                ++next_live;
+                continue;
+            }
+            if (cls.full.empty() || cls.full.back()->count == kMagazineSize) {
+                cls.full.push_back(new magazine);
+                cls.full.back()->count = 0;
+            }
+            magazine *mag = cls.full.back();
+            mag->chunks[mag->count++] = ptr;
+        }
+    }
+    return true;
+}
+
+// See Slab.h
+bool Slab::Release(void *slab) {
+    char *begin = static_cast<char *>(slab);
+    char *end = begin + _slabs.slab_size();
+    std::size_t cls_idx = ClassOf(static_cast<const void *>(slab));
+    size_class &cls = _classes[cls_idx];
+    std::size_t size = _class_sizes[cls_idx];
+
+    // Class lock can't be held here: Allocate takes it while holding the thread one
+    std::vector<void *> found;
+    for (std::size_t i = 0; i < kThreadSlots; ++i) {
+        thread_slot &slot = _threads[i];
+        while (slot.locked.exchange(true, std::memory_order_acquire)) {
+        }
+        class_cache &cache = slot.caches[cls_idx];
+        _TakeChunks(cache.loaded, begin, end, found);
+        _TakeChunks(cache.previous, begin, end, found);
+        slot.locked.store(false, std::memory_order_release);
+    }
+
+    std::lock_guard<std::mutex> lock(cls.lock);
+    for (magazine *mag : cls.full) {
+        _TakeChunks(mag, begin, end, found);
+    }
+
+    // Only the part before carve position was ever handed out
+    std::size_t carved = (end - begin) / size;
+    if (cls.carve_end == end) {
+        carved = (cls.carve - begin) / size;
+    }
+
+    if (found.size() != carved) {
+        // Some chunk is still in use, everything found goes back to the depot
+        for (void *ptr : found) {
+            if (cls.full.empty() || cls.full.back()->count == kMagazineSize) {
+                cls.full.push_back(new magazine);
+                cls.full.back()->count = 0;
+            }
+            magazine *mag = cls.full.back();
+            mag->chunks[mag->count++] = ptr;
+        }
+        return false;
+    }
+
+    if (cls.carve_end == end) {
+        cls.carve = cls.carve_end = nullptr;
+    }
+    _slabs.Put(slab);
+    return true;
+}
+
+// See Slab.h
+std::size_t Slab::ClassOf(std::size_t size) const {
+    auto it = std::lower_bound(_class_sizes.begin(), _class_sizes.end(), size);
+    return it == _class_sizes.end() ? kNoClass : it - _class_sizes.begin();
+}
+
+std::size_t Slab::_ThreadSlot() {
+    static std::atomic<std::size_t> threads(0);
+    static thread_local std::size_t slot = threads.fetch_add(1, std::memory_order_relaxed) % kThreadSlots;
+    return slot;
+}
+
+bool Slab::_Reload(size_class &cls, class_cache &cache) {
+    std::lock_guard<std::mutex> lock(cls.lock);
+    if (cls.full.empty()) {
+        return false;
+    }
+    // Both magazines are empty here, one of them is kept as a spare
+    if (cache.previous) {
+        cls.empty.push_back(cache.previous);
+    }
+    cache.previous = cache.loaded;
+    cache.loaded = cls.full.back();
+    cls.full.pop_back();
+    return true;
+}
+
+void Slab::_Unload(size_class &cls, class_cache &cache) {
+    std::lock_guard<std::mutex> lock(cls.lock);
+    // Both magazines are full here (or missing), one of them goes to the depot
+    if (cache.previous) {
+        cls.full.push_back(cache.previous);
+    }
+    cache.previous = cache.loaded;
+    if (cls.empty.empty()) {
+        cache.loaded = new magazine;
+        cache.loaded->count = 0;
+    } else {
+        cache.loaded = cls.empty.back();
+        cls.empty.pop_back();
+    }
+}
+
+void Slab::_TakeChunks(magazine *mag, const char *begin, const char *end, std::vector<void *> &found) {
+    if (mag == nullptr) {
+        return;
+    }
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < mag->count; ++i) {
+        char *ptr = static_cast<char *>(mag->chunks[i]);
+        if (ptr >= begin && ptr < end) {
+            found.push_back(ptr);
+        } else {
+            mag->chunks[kept++] = ptr;
+        }
+    }
+    mag->count = kept;
+}
+
+void *Slab::_Carve(std::size_t cls_idx) {
+    size_class &cls = _classes[cls_idx];
+    std::size_t size = _class_sizes[cls_idx];
+
+    std::lock_guard<std::mutex> lock(cls.lock);
+    if (std::size_t(cls.carve_end - cls.carve) < size) {
+        char *slab = static_cast<char *>(_slabs.Get());
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        _slab_class[_slabs.Index(slab)].store(cls_idx, std::memory_order_relaxed);
+        cls.carve = slab;
+        cls.carve_end = slab + _slabs.slab_size();
+    }
+
+    void *ptr = cls.carve;
+    cls.carve += size;
+    return ptr;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,29 @@
+#include <afina/Storage.h>
+#include <afina/execute/Cas.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "cas" means "store this data but only if no one else has updated since I last fetched it."
+void Cas::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Cas(" << _key << ", " << _cas << "): " << args << std::endl;
+    switch (storage.CompareAndSwap(_key, args, deadline(), _cas)) {
+    case Storage::CasResult::kStored:
+        out = "STORED";
+        break;
+    case Storage::CasResult::kNotStored:
+        out = "NOT_STORED";
+        break;
+    case Storage::CasResult::kExists:
+        out = "EXISTS";
+        break;
+    default:
+        out = "NOT_FOUND";
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -26,18 +26,24 @@ void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
     copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
     std::cout << "Get(" << keyStream.str() << ")" << std::endl;
 
-    std::stringstream outStream;
-
-    std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
-            continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+    // All keys are looked up in one batch, values are appended to the response right from the storage
+    // memory, the only copy made
+    out.clear();
+    if (_cas) {
+        storage.MultiViewCas(_keys, [&out](const std::string &key, const char *value, std::size_t size, uint64_t cas) {
+            out.append("VALUE ").append(key).append(" 0 ").append(std::to_string(size));
+            out.append(" ").append(std::to_string(cas)).append("\r\n");
+            out.append(value, size).append("\r\n");
+        });
+    } else {
+        // Each key is hashed here once, storage layers below reuse the hash, see KeyRef
+        std::vector<KeyRef> refs(_keys.begin(), _keys.end());
+        storage.MultiView(refs, [&out](const KeyRef &key, const char *value, std::size_t size) {
+            out.append("VALUE ").append(key.data, key.size).append(" 0 ").append(std::to_string(size)).append("\r\n");
+            out.append(value, size).append("\r\n");
+        });
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
@@ -0,0 +1,40 @@
+#include <afina/Storage.h>
+#include <afina/execute/Incr.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+/* memcached protocol:
+
+incr <key> <value>\r\n
+decr <key> <value>\r\n
+
+The response is the new value of the item's data, "NOT_FOUND" if there is no such item
+
+*/
+
+void Incr::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << (_decrement ? "Decr(" : "Incr(") << _key << ", " << _delta << ")" << std::endl;
+    uint64_t value = 0;
+    Storage::IncrResult result =
+        _decrement ? storage.Decrement(_key, _delta, value) : storage.Increment(_key, _delta, value);
+    switch (result) {
+    case Storage::IncrResult::kUpdated:
+        out = std::to_string(value);
+        break;
+    case Storage::IncrResult::kNotNumber:
+        out = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+        break;
+    case Storage::IncrResult::kNotStored:
+        out = "SERVER_ERROR out of memory storing object";
+        break;
+    default:
+        out = "NOT_FOUND";
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -8,7 +8,24 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Each counter sent by the server looks like this:
+
+STAT <name> <value>\r\n
+
+After all the counters have been transmitted, the server sends the string
+"END\r\n"
+
+*/
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    out.clear();
+    storage.Report([&out](const std::string &name, uint64_t value) {
+        out.append("STAT ").append(name).append(" ").append(std::to_string(value)).append("\r\n");
+    });
+    out.append("END"); // networking layer should add the last \r\n
+}
 
 } // namespace Execute
 } // namespace Afina
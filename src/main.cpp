@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -11,6 +12,7 @@
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/allocator/Slab.h>
 #include <afina/logging/Service.h>
 #include <afina/network/Server.h>
 
@@ -21,8 +23,16 @@
 #include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
 
+#include "storage/ClockLRU.h"
+#include "storage/CommandLog.h"
+#include "storage/HashLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/MmapStorage.h"
 #include "storage/SimpleLRU.h"
+#include "storage/Snapshotter.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/TieredLRU.h"
+#include "storage/TinyLFU.h"
 #include "storage/StripedLRU.h"
 
 using namespace Afina;
@@ -52,16 +62,136 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Bytes of keys and values storage is able to hold, admission policy is sized by it
+        std::size_t capacity = 1024;
+        if (options.count("warm") > 0 && storage_type != "st_hash") {
+            throw std::runtime_error("Warm restart is supported by st_hash storage only");
+        }
         if (storage_type == "st_lru") {
             storage = std::make_shared<Afina::Backend::SimpleLRU>();
+        } else if (storage_type == "st_hash") {
+            if (options.count("warm") > 0) {
+                // Items live in shared memory that survives restart, picked up again on start
+                std::size_t memory = 64;
+                if (options.count("memory") > 0) {
+                    memory = options["memory"].as<std::size_t>();
+                }
+                capacity = memory * 1024 * 1024;
+                storage = std::make_shared<Afina::Backend::HashLRU>(options["warm"].as<std::string>(), capacity);
+            } else if (options.count("memory") > 0) {
+                // Items live in slabs, memory limit is a hard ceiling for them
+                capacity = options["memory"].as<std::size_t>() * 1024 * 1024;
+                storage = std::make_shared<Afina::Backend::HashLRU>(std::make_shared<Afina::Allocator::Slab>(capacity));
+            } else {
+                storage = std::make_shared<Afina::Backend::HashLRU>();
+            }
+        } else if (storage_type == "mt_tiered") {
+            // Memory limit is for the RAM tier, entries evicted from it are demoted to the file
+            if (options.count("tier-file") == 0) {
+                throw std::runtime_error("Tiered storage needs --tier-file");
+            }
+            std::size_t memory = 64, disk = 1024;
+            if (options.count("memory") > 0) {
+                memory = options["memory"].as<std::size_t>();
+            }
+            if (options.count("tier-size") > 0) {
+                disk = options["tier-size"].as<std::size_t>();
+            }
+            // Both tiers together hold entries, the file one keeps whatever RAM one can't
+            capacity = (memory + disk) * 1024 * 1024;
+            storage = std::make_shared<Afina::Backend::TieredLRU>(options["tier-file"].as<std::string>(),
+                                                                  memory * 1024 * 1024, disk * 1024 * 1024);
+        } else if (storage_type == "mmap") {
+            // Items live in the file and stay there between runs
+            if (options.count("mmap-file") == 0) {
+                throw std::runtime_error("Mmap storage needs --mmap-file");
+            }
+            std::size_t size = 1024;
+            if (options.count("mmap-size") > 0) {
+                size = options["mmap-size"].as<std::size_t>();
+            }
+            storage = std::make_shared<Afina::Backend::MmapStorage>(options["mmap-file"].as<std::string>(),
+                                                                    size * 1024 * 1024);
         } else if (storage_type == "mt_lru") {
             storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
         } else if (storage_type == "mt_slru") {
-            storage = std::make_shared<Afina::Backend::StripedLRU>(std::move(Afina::Backend::StripedLRU::Create_StripedLRU()));
+            // Memory limit is split between stripes
+            capacity = 4 * 1024;
+            if (options.count("memory") > 0) {
+                capacity = options["memory"].as<std::size_t>() * 1024 * 1024;
+            }
+            storage = std::make_shared<Afina::Backend::StripedLRU>(
+                std::move(Afina::Backend::StripedLRU::Create_StripedLRU(capacity)));
+        } else if (storage_type == "mt_clock") {
+            storage = std::make_shared<Afina::Backend::ClockLRU>();
+        } else if (storage_type == "mt_lockfree") {
+            storage = std::make_shared<Afina::Backend::LockFreeHash>();
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
+        // Step 1.1: configure admission policy on top of storage
+        std::string admission_type = "none";
+        if (options.count("admission") > 0) {
+            admission_type = options["admission"].as<std::string>();
+        }
+
+        if (admission_type != "none" && (options.count("warm") > 0 || storage_type == "mmap")) {
+            // Policy state isn't persistent, it would never learn about restored keys
+            throw std::runtime_error("Admission policy can't be used with persistent storage");
+        }
+        if (admission_type == "tinylfu") {
+            storage = std::make_shared<Afina::Backend::TinyLFU>(storage, capacity);
+        } else if (admission_type != "none") {
+            throw std::runtime_error("Unknown admission type");
+        }
+
+        // Step 1.2: save storage to disk in background and load it back on start
+        if (options.count("snapshot") > 0 && options.count("log") > 0) {
+            throw std::runtime_error("Snapshot and command log are alternatives, choose one");
+        }
+        if (storage_type == "mmap" && (options.count("snapshot") > 0 || options.count("log") > 0)) {
+            // Forked copy of shared mapping keeps changing, and the file is persistent anyway
+            throw std::runtime_error("Mmap storage can't be used with snapshot or command log");
+        }
+        // Periodic snapshot and log compaction fork from their own thread while the server keeps changing the
+        // storage, so it must stop all the changes for the moment of fork, see Storage::Freeze
+        bool freezable = storage_type != "st_lru" && storage_type != "st_hash" && storage_type != "mt_lockfree";
+        bool periodic = options.count("snapshot-period") > 0 && options["snapshot-period"].as<unsigned>() > 0;
+        if (!freezable && (options.count("log") > 0 || (options.count("snapshot") > 0 && periodic))) {
+            throw std::runtime_error("Storage can't be frozen for periodic snapshot or command log, use mt_lru");
+        }
+        if (options.count("log") > 0) {
+            std::string fsync = "everysec";
+            if (options.count("log-fsync") > 0) {
+                fsync = options["log-fsync"].as<std::string>();
+            }
+
+            Afina::Backend::CommandLog::FsyncPolicy policy;
+            if (fsync == "always") {
+                policy = Afina::Backend::CommandLog::FsyncPolicy::kAlways;
+            } else if (fsync == "everysec") {
+                policy = Afina::Backend::CommandLog::FsyncPolicy::kEverySec;
+            } else if (fsync == "never") {
+                policy = Afina::Backend::CommandLog::FsyncPolicy::kNever;
+            } else {
+                throw std::runtime_error("Unknown log fsync policy");
+            }
+            storage = std::make_shared<Afina::Backend::CommandLog>(storage, options["log"].as<std::string>(), policy);
+        } else if (options.count("snapshot") > 0) {
+            unsigned period = 0;
+            if (options.count("snapshot-period") > 0) {
+                period = options["snapshot-period"].as<unsigned>();
+            }
+            // Single threaded storages can't take entries from several loader threads
+            std::size_t load_threads = 1;
+            if (storage_type.compare(0, 3, "mt_") == 0) {
+                load_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            storage = std::make_shared<Afina::Backend::Snapshotter>(storage, options["snapshot"].as<std::string>(),
+                                                                    period, load_threads);
+        }
+
         // Step 2: Configure network
         std::string network_type = "st_block";
         if (options.count("network") > 0) {
@@ -105,6 +235,14 @@ public:
         server->Stop();
         server->Join();
 
+        // Counters are lost with the process, so the last values are left in the log
+        Afina::Network::Server::Stats stats = server->GetStats();
+        log->warn("Network served {} connections, {} commands, read {} bytes, wrote {} bytes", stats.connections,
+                  stats.commands, stats.bytes_read, stats.bytes_written);
+        storage->Report([&log](const std::string &name, uint64_t value) { log->warn("Storage {}: {}", name, value); });
+
+        // Nobody uses storage anymore, restartable one leaves its shared memory clean for the next start
+        log->warn("Stop storage");
         storage->Stop();
         logService->Stop();
     }
@@ -134,6 +272,29 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("a,admission", "Admission policy on top of storage: none or tinylfu",
+                              cxxopts::value<std::string>());
+        options.add_options()("m,memory",
+                              "Megabytes of st_hash slab memory, of mt_slru stripes or of mt_tiered RAM tier",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("warm", "Shared memory segment st_hash keeps items in to survive restart, like /afina",
+                              cxxopts::value<std::string>());
+        options.add_options()("tier-file", "File mt_tiered storage demotes cold entries to",
+                              cxxopts::value<std::string>());
+        options.add_options()("tier-size", "Megabytes of mt_tiered file, 1024 by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("mmap-file", "File mmap storage keeps items in between runs",
+                              cxxopts::value<std::string>());
+        options.add_options()("mmap-size", "Megabytes of mmap storage file, 1024 by default",
+                              cxxopts::value<std::size_t>());
+        options.add_options()("snapshot", "File to save storage into on snapshot command and load it from on start",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-period", "Seconds between automatic snapshots, 0 to disable. Needs storage with a lock",
+                              cxxopts::value<unsigned>());
+        options.add_options()("log", "Append-only log of mutations to replay on start. Needs storage with a lock",
+                              cxxopts::value<std::string>());
+        options.add_options()("log-fsync", "When log is synced to disk: always, everysec or never",
+                              cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
@@ -138,6 +138,7 @@ void ServerImpl::OnRun(int server_socket) {
             }
             else {
                 _sockets.insert(client_socket);
+                _connections.Add();
                 std::thread worker = std::thread(&ServerImpl::WorkerThread, this, client_socket);
                 worker.detach();
             }
@@ -174,6 +175,7 @@ void ServerImpl::WorkerThread(int client_socket) {
         char client_buffer[4096];
         while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
             _logger->debug("Got {} bytes from socket", readed_bytes);
+            _bytes_read.Add(readed_bytes);
 
             // Single block of data readed from the socket could trigger inside actions a multiple times,
             // for example:
@@ -225,12 +227,14 @@ void ServerImpl::WorkerThread(int client_socket) {
                         argument_for_command.resize(argument_for_command.size() - 2);
                     }
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
+                    _commands.Add();
 
                     // Send response
                     result += "\r\n";
                     if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                         throw std::runtime_error("Failed to send response");
                     }
+                    _bytes_written.Add(result.size());
 
                     // Prepare for the next command
                     command_to_execute.reset();
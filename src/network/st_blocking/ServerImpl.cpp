@@ -139,6 +139,7 @@ void ServerImpl::OnRun() {
         if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
             continue;
         }
+        _connections.Add();
 
         // Got new connection
         if (_logger->should_log(spdlog::level::debug)) {
@@ -170,6 +171,7 @@ void ServerImpl::OnRun() {
             char client_buffer[4096];
             while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
                 _logger->debug("Got {} bytes from socket", readed_bytes);
+                _bytes_read.Add(readed_bytes);
 
                 // Single block of data readed from the socket could trigger inside actions a multiple times,
                 // for example:
@@ -221,12 +223,14 @@ void ServerImpl::OnRun() {
                             argument_for_command.resize(argument_for_command.size() - 2);
                         }
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
+                        _commands.Add();
 
                         // Send response
                         result += "\r\n";
                         if (send(client_socket, result.data(), result.size(), 0) <= 0) {
                             throw std::runtime_error("Failed to send response");
                         }
+                        _bytes_written.Add(result.size());
 
                         // Prepare for the next command
                         command_to_execute.reset();
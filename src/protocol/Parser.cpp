@@ -6,10 +6,14 @@
 
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/Snapshot.h>
 #include <afina/execute/Stats.h>
 
 namespace Afina {
@@ -28,11 +32,13 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::sName: {
             if (c == ' ' || c == '\r') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                if (name == "set" || name == "add" || name == "append" || name == "prepend" || name == "cas") {
                     state = State::spKey;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
-                } else if (name == "stats") {
+                } else if (name == "incr" || name == "decr") {
+                    state = State::siKey;
+                } else if (name == "stats" || name == "snapshot") {
                     state = State::sLF;
                     continue;
                 } else {
@@ -77,6 +83,44 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::siKey: {
+            if (c == ' ') {
+                state = State::siDeltaStart;
+                keys.push_back(curKey);
+            } else if (c == '\r' || c == '\n') {
+                throw std::runtime_error("Client provides no delta to change counter by");
+            } else {
+                curKey.push_back(c);
+            }
+            break;
+        }
+
+        case State::siDeltaStart: {
+            if (c >= '0' && c <= '9') {
+                delta = (c - '0');
+                state = State::siDelta;
+            } else {
+                throw std::runtime_error("Delta field must be a decimal number");
+            }
+            break;
+        }
+
+        case State::siDelta: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t v = (delta * 10) + (c - '0');
+                if (v / 10 != delta) {
+                    // Overflow
+                    throw std::runtime_error("Delta field overflow");
+                }
+                delta = v;
+            } else {
+                throw std::runtime_error("Delta field must be a decimal number");
+            }
+            break;
+        }
+
         case State::spFlags: {
             if (c == ' ') {
                 negative = false;
@@ -127,9 +171,13 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         }
 
         case State::spBytes: {
-            if (c == '\r') {
+            if (c == '\r' && name == "cas") {
+                throw std::runtime_error("Client provides no cas unique to compare with");
+            } else if (c == '\r') {
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
+            } else if (c == ' ' && name == "cas") {
+                state = State::spCasStart;
             } else if (c >= '0' && c <= '9') {
                 uint32_t b = (bytes * 10) + (c - '0');
                 if (b < bytes) {
@@ -141,6 +189,30 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::spCasStart: {
+            if (c >= '0' && c <= '9') {
+                cas = (c - '0');
+                state = State::spCas;
+            } else {
+                throw std::runtime_error("Cas unique field must be a decimal number");
+            }
+            break;
+        }
+
+        case State::spCas: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t v = (cas * 10) + (c - '0');
+                if (v / 10 != cas) {
+                    // Overflow
+                    throw std::runtime_error("Cas unique field overflow");
+                }
+                cas = v;
+            }
+            break;
+        }
+
         case State::sLF: {
             if (c == '\n') {
                 parse_complete = true;
@@ -174,10 +246,18 @@ std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
         return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
     } else if (name == "append") {
         return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+    } else if (name == "prepend") {
+        return std::unique_ptr<Execute::Command>(new Execute::Prepend(keys[0], flags, exprtime));
+    } else if (name == "cas") {
+        return std::unique_ptr<Execute::Command>(new Execute::Cas(keys[0], flags, exprtime, cas));
+    } else if (name == "get" || name == "gets") {
+        return std::unique_ptr<Execute::Command>(new Execute::Get(keys, name == "gets"));
+    } else if (name == "incr" || name == "decr") {
+        return std::unique_ptr<Execute::Command>(new Execute::Incr(keys[0], delta, name == "decr"));
     } else if (name == "stats") {
         return std::unique_ptr<Execute::Command>(new Execute::Stats());
+    } else if (name == "snapshot") {
+        return std::unique_ptr<Execute::Command>(new Execute::Snapshot());
     } else {
         throw std::runtime_error("Unsupported command");
     }
@@ -193,6 +273,8 @@ void Parser::Reset() {
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    cas = 0;
+    delta = 0;
 }
 
 } // namespace Protocol
@@ -0,0 +1,405 @@
+#include "ClockLRU.h"
+
+#include <functional>
+#include <mutex>
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t ClockLRU::kReclaimBudget;
+
+ClockLRU::ClockLRU(size_t max_size) : _max_size(max_size), _curr_size(0), _cas(0), _hand(0), _timers(_Now()) {}
+
+ClockLRU::~ClockLRU() {
+    for (clock_entry *entry : _ring) {
+        delete entry;
+    }
+}
+
+// See ClockLRU.h
+bool ClockLRU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0); }
+
+// See ClockLRU.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value) { return PutIfAbsent(key, value, 0); }
+
+// See ClockLRU.h
+bool ClockLRU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0); }
+
+// See ClockLRU.h
+bool ClockLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    clock_entry *entry = _Lookup(ref, now);
+    if (expire != 0 && expire <= now) {
+        // Value is never visible, only the old one has to go
+        if (entry) {
+            _Remove(entry);
+        }
+        return true;
+    }
+    if (entry) {
+        return _UpdateEntry(entry, value, expire);
+    }
+    return _InsertEntry(key, value, ref.hash, expire);
+}
+
+// See ClockLRU.h
+bool ClockLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    if (_Lookup(ref, now)) {
+        return false;
+    }
+    if (expire != 0 && expire <= now) {
+        return true;
+    }
+    return _InsertEntry(key, value, ref.hash, expire);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    clock_entry *entry = _Lookup(ref, now);
+    if (!entry) {
+        return false;
+    }
+    if (expire != 0 && expire <= now) {
+        _Remove(entry);
+        return true;
+    }
+    return _UpdateEntry(entry, value, expire);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Append(const std::string &key, const std::string &data) { return _ExtendEntry(key, data, false); }
+
+// See ClockLRU.h
+bool ClockLRU::Prepend(const std::string &key, const std::string &data) { return _ExtendEntry(key, data, true); }
+
+// See ClockLRU.h
+Storage::IncrResult ClockLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _IncrementEntry(key, delta, false, value);
+}
+
+// See ClockLRU.h
+Storage::IncrResult ClockLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _IncrementEntry(key, delta, true, value);
+}
+
+// See ClockLRU.h
+bool ClockLRU::Delete(const std::string &key) { return Delete(KeyRef(key)); }
+
+// See ClockLRU.h
+bool ClockLRU::Delete(const KeyRef &key) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    clock_entry *entry = _Lookup(key, _Now());
+    if (!entry) {
+        return false;
+    }
+    _Remove(entry);
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::Get(const std::string &key, std::string &value) { return Get(KeyRef(key), value); }
+
+// See ClockLRU.h
+bool ClockLRU::Get(const KeyRef &key, std::string &value) {
+    Concurrency::SharedLock lock(_mutex);
+    clock_entry *entry = _Find(key, _Now());
+    if (!entry) {
+        _misses.Add();
+        return false;
+    }
+    _hits.Add();
+    entry->referenced.store(true, std::memory_order_relaxed);
+    value = entry->value;
+    return true;
+}
+
+// See ClockLRU.h
+bool ClockLRU::View(const std::string &key, const Visitor &visitor) { return View(KeyRef(key), visitor); }
+
+// See ClockLRU.h
+bool ClockLRU::View(const KeyRef &key, const Visitor &visitor) {
+    Concurrency::SharedLock lock(_mutex);
+    clock_entry *entry = _Find(key, _Now());
+    if (!entry) {
+        _misses.Add();
+        return false;
+    }
+    _hits.Add();
+    entry->referenced.store(true, std::memory_order_relaxed);
+    visitor(entry->value.data(), entry->value.size());
+    return true;
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::vector<KeyRef> refs(keys.begin(), keys.end());
+    return _MultiFind(refs, [&keys, &visitor](std::size_t i, const clock_entry *entry) {
+        visitor(keys[i], entry->value.data(), entry->value.size());
+    });
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    return _MultiFind(keys, [&keys, &visitor](std::size_t i, const clock_entry *entry) {
+        visitor(keys[i], entry->value.data(), entry->value.size());
+    });
+}
+
+// See ClockLRU.h
+std::size_t ClockLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::time_t now = _Now();
+    Concurrency::SharedLock lock(_mutex);
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        clock_entry *entry = _Find(key, now);
+        if (entry) {
+            entry->referenced.store(true, std::memory_order_relaxed);
+            visitor(key, entry->value.data(), entry->value.size(), entry->cas);
+            found++;
+        }
+    }
+    _hits.Add(found);
+    _misses.Add(keys.size() - found);
+    return found;
+}
+
+// See ClockLRU.h
+Storage::CasResult ClockLRU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                            uint64_t cas) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    clock_entry *entry = _Lookup(ref, now);
+    if (!entry) {
+        return CasResult::kNotFound;
+    }
+    if (entry->cas != cas) {
+        return CasResult::kExists;
+    }
+    if (expire != 0 && expire <= now) {
+        _Remove(entry);
+        return CasResult::kStored;
+    }
+    return _UpdateEntry(entry, value, expire) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See ClockLRU.h
+void ClockLRU::Freeze() { _mutex.lock(); }
+
+// See ClockLRU.h
+void ClockLRU::Thaw() { _mutex.unlock(); }
+
+// See ClockLRU.h
+bool ClockLRU::Scan(const Scanner &scanner) {
+    std::time_t now = _Now();
+    for (clock_entry *entry : _ring) {
+        if (entry && !entry->Expired(now)) {
+            scanner(entry->key.data(), entry->key.size(), entry->value.data(), entry->value.size(), entry->expire);
+        }
+    }
+    return true;
+}
+
+// See ClockLRU.h
+void ClockLRU::Report(const Reporter &reporter) {
+    Stats stats = GetStats();
+    reporter("bytes", stats.size);
+    reporter("limit_maxbytes", stats.max_size);
+    reporter("get_hits", stats.hits);
+    reporter("get_misses", stats.misses);
+    reporter("evictions", stats.evictions);
+}
+
+// See ClockLRU.h
+ClockLRU::Stats ClockLRU::GetStats() const {
+    Concurrency::SharedLock lock(_mutex);
+    return Stats{_curr_size, _max_size, _hits.Sum(), _misses.Sum(), _evictions.Sum()};
+}
+
+std::time_t ClockLRU::_Now() { return std::time(nullptr); }
+
+ClockLRU::clock_entry *ClockLRU::_Find(const KeyRef &key, std::time_t now) const {
+    clock_entry *entry = _index.Find(key.hash, [&key](const clock_entry &entry) { return key == entry.key; });
+    if (entry && entry->Expired(now)) {
+        return nullptr;
+    }
+    return entry;
+}
+
+ClockLRU::clock_entry *ClockLRU::_Lookup(const KeyRef &key, std::time_t now) {
+    clock_entry *entry = _index.Find(key.hash, [&key](const clock_entry &entry) { return key == entry.key; });
+    if (entry && entry->Expired(now)) {
+        _Remove(entry);
+        return nullptr;
+    }
+    return entry;
+}
+
+void ClockLRU::_Reclaim(std::time_t now, std::size_t budget) {
+    _timers.Advance(now, budget, [this, now](const expiry &timer) {
+        // Timer could belong to an entry that was removed or got an earlier timer since then
+        clock_entry *entry = _index.Find(timer.hash, [&timer](const clock_entry &entry) {
+            return &entry == timer.entry && entry.timer == timer.deadline;
+        });
+        if (entry == nullptr) {
+            return;
+        }
+        entry->timer = 0;
+        if (entry->Expired(now)) {
+            _Remove(entry);
+        } else {
+            // Expire time moved forward meanwhile
+            _SetExpire(entry, entry->expire);
+        }
+    });
+}
+
+void ClockLRU::_SetExpire(clock_entry *entry, std::time_t expire) {
+    // Entry has a single pending timer at most, see HashLRU::_SetExpire
+    if (expire != 0 && (entry->timer == 0 || expire < entry->timer)) {
+        _timers.Schedule(expire, expiry{entry, entry->hash, expire});
+        entry->timer = expire;
+    }
+    entry->expire = expire;
+}
+
+std::size_t ClockLRU::_MultiFind(const std::vector<KeyRef> &keys,
+                                 const std::function<void(std::size_t i, const clock_entry *entry)> &visitor) {
+    std::time_t now = _Now();
+    Concurrency::SharedLock lock(_mutex);
+    for (auto &key : keys) {
+        _index.Prefetch(key.hash);
+    }
+
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        clock_entry *entry = _Find(keys[i], now);
+        if (entry) {
+            entry->referenced.store(true, std::memory_order_relaxed);
+            visitor(i, entry);
+            found++;
+        }
+    }
+    _hits.Add(found);
+    _misses.Add(keys.size() - found);
+    return found;
+}
+
+void ClockLRU::_Remove(clock_entry *entry) {
+    _ring[entry->slot] = nullptr;
+    _free_slots.push_back(entry->slot);
+    _index.Erase(entry->hash, entry);
+    _curr_size -= entry->key.size() + entry->value.size();
+    delete entry;
+}
+
+void ClockLRU::_Evict(std::size_t new_size, const clock_entry *keep) {
+    // Each revolution clears all reference bits, so the loop ends in at most two of them
+    while (new_size + _curr_size > _max_size) {
+        if (_hand >= _ring.size()) {
+            _hand = 0;
+        }
+
+        clock_entry *entry = _ring[_hand++];
+        if (entry == nullptr || entry == keep) {
+            continue;
+        }
+        if (entry->referenced.load(std::memory_order_relaxed)) {
+            entry->referenced.store(false, std::memory_order_relaxed);
+        } else {
+            _Remove(entry);
+            _evictions.Add();
+        }
+    }
+}
+
+bool ClockLRU::_UpdateEntry(clock_entry *entry, const std::string &value, std::time_t expire) {
+    if (entry->key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (value.size() > entry->value.size()) {
+        _Evict(value.size() - entry->value.size(), entry);
+    }
+    _curr_size -= entry->value.size();
+    _curr_size += value.size();
+    entry->value = value;
+    entry->cas = ++_cas;
+    _SetExpire(entry, expire);
+    entry->referenced.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool ClockLRU::_ExtendEntry(const std::string &key, const std::string &data, bool front) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    clock_entry *entry = _Lookup(ref, now);
+    if (!entry || entry->key.size() + entry->value.size() + data.size() > _max_size) {
+        return false;
+    }
+    _Evict(data.size(), entry);
+    if (front) {
+        entry->value.insert(0, data);
+    } else {
+        entry->value.append(data);
+    }
+    entry->cas = ++_cas;
+    _curr_size += data.size();
+    entry->referenced.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+Storage::IncrResult ClockLRU::_IncrementEntry(const std::string &key, uint64_t delta, bool decrement,
+                                              uint64_t &value) {
+    KeyRef ref(key);
+    std::time_t now = _Now();
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Reclaim(now, kReclaimBudget);
+    clock_entry *entry = _Lookup(ref, now);
+    if (!entry) {
+        return IncrResult::kNotFound;
+    }
+    if (!_ApplyDelta(entry->value.data(), entry->value.size(), delta, decrement, value)) {
+        return IncrResult::kNotNumber;
+    }
+    bool updated = _UpdateEntry(entry, std::to_string(value), entry->expire);
+    return updated ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+bool ClockLRU::_InsertEntry(const std::string &key, const std::string &value, uint64_t hash, std::time_t expire) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    _Evict(key.size() + value.size(), nullptr);
+
+    clock_entry *entry = new clock_entry(key, value, hash);
+    entry->cas = ++_cas;
+    _SetExpire(entry, expire);
+    if (_free_slots.empty()) {
+        entry->slot = _ring.size();
+        _ring.push_back(entry);
+    } else {
+        entry->slot = _free_slots.back();
+        _free_slots.pop_back();
+        _ring[entry->slot] = entry;
+    }
+    _index.Insert(hash, entry);
+    _curr_size += key.size() + value.size();
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,235 @@
+#ifndef AFINA_STORAGE_CLOCK_LRU_H
+#define AFINA_STORAGE_CLOCK_LRU_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/SharedMutex.h>
+
+#include "HashIndex.h"
+#include "TimerWheel.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # CLOCK (second chance) implementation
+ * LRU approximation where a hit only raises the entry's reference bit instead of moving it to the list
+ * head. Entries sit in a ring of slots, and eviction sweeps a hand over that ring: referenced entry loses
+ * its bit and survives one more revolution, unreferenced one gets evicted.
+ *
+ * Since reads never change the structure, Get/View/MultiView run under a shared lock and proceed in
+ * parallel, only writers take the lock exclusively.
+ *
+ * Entry could have expire time. Readers treat expired entry as missing, writers remove it once they come
+ * across it, and each write advances TimerWheel a few steps to remove the ones nobody asks for.
+ *
+ * That is thread safe implementation
+ */
+class ClockLRU : public Afina::Storage {
+public:
+    /**
+     * Counters of the cache state. Hits and misses are counted per CPU, so concurrent readers don't share
+     * a cache line for them
+     */
+    struct Stats {
+        // Bytes of keys and values stored and the limit on them
+        std::size_t size;
+        std::size_t max_size;
+
+        // Lookups that found/didn't find the key
+        uint64_t hits;
+        uint64_t misses;
+
+        // Entries dropped to make room for the new ones
+        uint64_t evictions;
+    };
+
+    ClockLRU(size_t max_size = 1024);
+    ~ClockLRU();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    void Freeze() override;
+
+    // Implements Afina::Storage interface
+    void Thaw() override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Implements Afina::Storage interface
+    void Report(const Reporter &reporter) override;
+
+    Stats GetStats() const;
+
+private:
+    // Timer wheel steps made by each write
+    static constexpr std::size_t kReclaimBudget = 4;
+
+    struct clock_entry {
+        clock_entry(const std::string &key_, const std::string &value_, uint64_t hash_)
+            : key(key_), value(value_), hash(hash_), cas(0), expire(0), timer(0), referenced(true), slot(0) {}
+
+        bool Expired(std::time_t now) const { return expire != 0 && expire <= now; }
+
+        const std::string key;
+        std::string value;
+        const uint64_t hash;
+
+        // Version of the value, changed by writers only
+        uint64_t cas;
+
+        // Unix time entry expires at, 0 if never
+        std::time_t expire;
+
+        // Deadline of the entry timer pending in _timers, 0 if there is none
+        std::time_t timer;
+
+        // Set on each access, cleared by the clock hand. Readers set it concurrently under the shared lock
+        std::atomic<bool> referenced;
+
+        // Position in the ring
+        std::size_t slot;
+    };
+
+    // Timer of the entry, entry is only compared by address as it could be destroyed already. It is the one
+    // pending for the entry if clock_entry#timer is the deadline
+    struct expiry {
+        const clock_entry *entry;
+        uint64_t hash;
+        std::time_t deadline;
+    };
+
+    static std::time_t _Now();
+
+    // Returns entry of the key, nullptr if there is none or it is expired
+    clock_entry *_Find(const KeyRef &key, std::time_t now) const;
+
+    // Same as _Find, but expired entry is removed. Must be called with the lock held exclusively
+    clock_entry *_Lookup(const KeyRef &key, std::time_t now);
+
+    // Removes expired entries found by the timer wheel making at most budget steps of it
+    void _Reclaim(std::time_t now, std::size_t budget);
+
+    void _SetExpire(clock_entry *entry, std::time_t expire);
+
+    // Looks up all the keys under a single shared lock, calls visitor with position of each key found and its entry
+    std::size_t _MultiFind(const std::vector<KeyRef> &keys,
+                           const std::function<void(std::size_t i, const clock_entry *entry)> &visitor);
+
+    void _Remove(clock_entry *entry);
+
+    // Sweeps clock hand until there is room for new_size more bytes, entry keep is never evicted
+    void _Evict(std::size_t new_size, const clock_entry *keep);
+
+    bool _UpdateEntry(clock_entry *entry, const std::string &value, std::time_t expire);
+
+    // Adds data to the end or to the front of the entry value
+    bool _ExtendEntry(const std::string &key, const std::string &data, bool front);
+
+    IncrResult _IncrementEntry(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    bool _InsertEntry(const std::string &key, const std::string &value, uint64_t hash, std::time_t expire);
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be not greater than the _max_size
+    std::size_t _max_size;
+    std::size_t _curr_size;
+
+    // The last version given to a value
+    uint64_t _cas;
+
+    // Clock ring, nullptr marks free slot
+    std::vector<clock_entry *> _ring;
+
+    // Free slots of the ring to be reused by new entries
+    std::vector<std::size_t> _free_slots;
+
+    // Position of the clock hand in the ring
+    std::size_t _hand;
+
+    Concurrency::CoreCounter _hits;
+    Concurrency::CoreCounter _misses;
+    Concurrency::CoreCounter _evictions;
+
+    // Index of entries from ring above, allows fast random access to elements by clock_entry#key
+    HashIndex<clock_entry> _index;
+
+    // Entries with expire time, by their clock_entry#expire
+    TimerWheel<expiry> _timers;
+
+    // Exclusive for writers, shared for readers
+    mutable Concurrency::SharedMutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CLOCK_LRU_H
@@ -0,0 +1,75 @@
+#ifndef AFINA_STORAGE_CODEC_H
+#define AFINA_STORAGE_CODEC_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Helpers for on-disk formats
+ * Fixed size integers are little endian, varints are LEB128: 7 bits per byte, high bit set on all bytes
+ * but the last one
+ */
+inline void PutU32(std::string &out, uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = char(value >> (8 * i));
+    }
+    out.append(bytes, 4);
+}
+
+inline uint32_t GetU32(const char *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= uint32_t(uint8_t(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline void PutVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+// Reads varint and moves in past it, returns false if varint runs over end
+inline bool GetVarint(const char *&in, const char *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = uint8_t(*in++);
+        value |= uint64_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Writes all bytes retrying short writes, throws std::system_error on failure
+inline void WriteAll(int fd, const char *data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to write");
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CODEC_H
@@ -0,0 +1,534 @@
+#include "CommandLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Codec.h"
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+// Body size and its CRC32C
+static constexpr std::size_t kRecordHeader = 2 * sizeof(uint32_t);
+
+// Compaction child flushes dump by pieces of that size
+static constexpr std::size_t kDumpBuffer = 1024 * 1024;
+
+// How often writer checks whether compaction child is done
+static constexpr std::chrono::milliseconds kCompactionPoll(20);
+
+static std::string RewritePath(const std::string &path) { return path + ".rewrite"; }
+
+CommandLog::CommandLog(std::shared_ptr<Afina::Storage> storage, const std::string &path, FsyncPolicy policy,
+                       std::size_t compact_size)
+    : _storage(storage), _path(path), _policy(policy), _compact_size(compact_size), _fd(-1), _file_size(0),
+      _compacted_size(0), _replayed(0), _appended(0), _synced(0), _compaction(Compaction::kIdle),
+      _child(0), _compactions(0), _compacted(false), _failed(false), _running(false) {}
+
+CommandLog::~CommandLog() { Stop(); }
+
+// See CommandLog.h
+void CommandLog::Start() {
+    _storage->Start();
+    unlink(RewritePath(_path).c_str());
+
+    std::size_t valid = _Replay();
+    _fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to open " + _path);
+    }
+    if (ftruncate(_fd, valid) != 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to truncate " + _path);
+    }
+    _file_size = valid;
+    _compacted_size = valid;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _running = true;
+    _thread = std::thread(&CommandLog::_Run, this);
+}
+
+// See CommandLog.h
+void CommandLog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _wake.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _storage->Stop();
+}
+
+// See CommandLog.h
+bool CommandLog::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->Put(key, value, expire)) {
+            return false;
+        }
+        // Value is invisible right away, see Storage::Put
+        seq = expire < 0 ? _Append(Op::kDelete, key, "", 0) : _Append(Op::kPut, key, value, expire);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+bool CommandLog::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->PutIfAbsent(key, value, expire)) {
+            return false;
+        }
+        seq = expire < 0 ? _Append(Op::kDelete, key, "", 0) : _Append(Op::kPut, key, value, expire);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+bool CommandLog::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->Set(key, value, expire)) {
+            return false;
+        }
+        seq = expire < 0 ? _Append(Op::kDelete, key, "", 0) : _Append(Op::kPut, key, value, expire);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+Storage::CasResult CommandLog::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                              uint64_t cas) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        CasResult result = _storage->CompareAndSwap(key, value, expire, cas);
+        if (result != CasResult::kStored) {
+            return result;
+        }
+        seq = expire < 0 ? _Append(Op::kDelete, key, "", 0) : _Append(Op::kPut, key, value, expire);
+    }
+    return _Wait(seq) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See CommandLog.h
+bool CommandLog::Delete(const std::string &key) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->Delete(key)) {
+            return false;
+        }
+        seq = _Append(Op::kDelete, key, "", 0);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+bool CommandLog::Append(const std::string &key, const std::string &data) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->Append(key, data)) {
+            return false;
+        }
+        seq = _Append(Op::kAppend, key, data, 0);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+bool CommandLog::Prepend(const std::string &key, const std::string &data) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        if (!_storage->Prepend(key, data)) {
+            return false;
+        }
+        seq = _Append(Op::kPrepend, key, data, 0);
+    }
+    return _Wait(seq);
+}
+
+// See CommandLog.h
+Storage::IncrResult CommandLog::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        IncrResult result = _storage->Increment(key, delta, value);
+        if (result != IncrResult::kUpdated) {
+            return result;
+        }
+        seq = _Append(Op::kIncrement, key, std::to_string(delta), 0);
+    }
+    return _Wait(seq) ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+// See CommandLog.h
+Storage::IncrResult CommandLog::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_KeyLock(key));
+        IncrResult result = _storage->Decrement(key, delta, value);
+        if (result != IncrResult::kUpdated) {
+            return result;
+        }
+        seq = _Append(Op::kDecrement, key, std::to_string(delta), 0);
+    }
+    return _Wait(seq) ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+// See CommandLog.h
+bool CommandLog::Compact() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        return false;
+    }
+
+    uint64_t started = _compactions;
+    if (_compaction == Compaction::kIdle) {
+        _compaction = Compaction::kRequested;
+        _wake.notify_one();
+    }
+    _done.wait(lock, [this, started] { return _compactions > started || !_running; });
+    return _compactions > started && _compacted;
+}
+
+void CommandLog::_Encode(std::string &out, Op op, const std::string &key, const std::string &value,
+                         std::time_t expire) {
+    std::size_t header = out.size();
+    out.append(kRecordHeader, '\0');
+    out.push_back(char(op));
+    PutVarint(out, key.size());
+    PutVarint(out, value.size());
+    PutVarint(out, uint64_t(std::max<std::time_t>(expire, 0)));
+    out.append(key).append(value);
+
+    std::size_t body = header + kRecordHeader;
+    std::string fields;
+    PutU32(fields, uint32_t(out.size() - body));
+    PutU32(fields, Crc32c(0, out.data() + body, out.size() - body));
+    out.replace(header, kRecordHeader, fields);
+}
+
+std::mutex &CommandLog::_KeyLock(const std::string &key) { return _key_locks[HashKey(key) % kKeyLocks]; }
+
+uint64_t CommandLog::_Append(Op op, const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running || _failed) {
+        return 0;
+    }
+
+    std::size_t offset = _pending.size();
+    _Encode(_pending, op, key, value, expire);
+    if (_compaction == Compaction::kRunning) {
+        _rewrite.append(_pending, offset, std::string::npos);
+    }
+
+    // Writer is either busy with the previous batch or sleeping, then wake it up
+    if (offset == 0) {
+        _wake.notify_one();
+    }
+    return ++_appended;
+}
+
+bool CommandLog::_Wait(uint64_t seq) {
+    if (_policy != FsyncPolicy::kAlways) {
+        return true;
+    }
+
+    // Nothing is logged before Start and after Stop
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this, seq] { return _synced >= seq || _failed; });
+    return seq == 0 ? !_failed : _synced >= seq;
+}
+
+std::size_t CommandLog::_Replay() {
+    _replayed = 0;
+    int fd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        throw std::system_error(errno, std::system_category(), "Failed to open " + _path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::system_error(errno, std::system_category(), "Failed to stat " + _path);
+    }
+    std::size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "Failed to map " + _path);
+    }
+
+    const char *data = static_cast<const char *>(mem);
+    const char *end = data + size;
+    const char *pos = data;
+    std::time_t now = std::time(nullptr);
+    std::string key, value;
+    while (end - pos >= std::ptrdiff_t(kRecordHeader)) {
+        uint32_t body_size = GetU32(pos);
+        if (std::size_t(end - pos) - kRecordHeader < body_size) {
+            break;
+        }
+        const char *in = pos + kRecordHeader;
+        const char *body_end = in + body_size;
+        if (Crc32c(0, in, body_size) != GetU32(pos + 4) || body_size == 0) {
+            break;
+        }
+
+        Op op = Op(uint8_t(*in++));
+        uint64_t key_size, value_size, expire;
+        if (!GetVarint(in, body_end, key_size) || !GetVarint(in, body_end, value_size) ||
+            !GetVarint(in, body_end, expire) || uint64_t(body_end - in) != key_size + value_size) {
+            break;
+        }
+        key.assign(in, key_size);
+        value.assign(in + key_size, value_size);
+
+        if (op == Op::kAppend) {
+            _storage->Append(key, value);
+        } else if (op == Op::kPrepend) {
+            _storage->Prepend(key, value);
+        } else if (op == Op::kIncrement || op == Op::kDecrement) {
+            uint64_t delta = std::strtoull(value.c_str(), nullptr, 10), counter;
+            if (op == Op::kIncrement) {
+                _storage->Increment(key, delta, counter);
+            } else {
+                _storage->Decrement(key, delta, counter);
+            }
+        } else if (op == Op::kDelete || (expire != 0 && std::time_t(expire) <= now)) {
+            _storage->Delete(key);
+        } else {
+            _storage->Put(key, value, std::time_t(expire));
+        }
+        _replayed++;
+        pos = body_end;
+    }
+
+    munmap(mem, size);
+    return pos - data;
+}
+
+void CommandLog::_Run() {
+    auto last_sync = std::chrono::steady_clock::now();
+    bool dirty = false;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        auto has_work = [this] { return !_pending.empty() || !_running || _compaction == Compaction::kRequested; };
+        if (_compaction == Compaction::kRunning) {
+            _wake.wait_for(lock, kCompactionPoll, has_work);
+        } else if (dirty && _policy == FsyncPolicy::kEverySec) {
+            _wake.wait_until(lock, last_sync + std::chrono::seconds(1), has_work);
+        } else {
+            _wake.wait(lock, has_work);
+        }
+
+        std::string batch;
+        batch.swap(_pending);
+        uint64_t seq = _appended;
+        bool stopping = !_running;
+        bool failed = _failed;
+        Compaction compaction = _compaction;
+        lock.unlock();
+
+        // One write and at most one sync for everything appended since the previous batch
+        try {
+            if (!batch.empty() && !failed) {
+                WriteAll(_fd, batch.data(), batch.size());
+                _file_size += batch.size();
+                dirty = true;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            bool sync = _policy == FsyncPolicy::kAlways || stopping ||
+                        (_policy == FsyncPolicy::kEverySec && now - last_sync >= std::chrono::seconds(1));
+            if (dirty && sync && !failed) {
+                if (fdatasync(_fd) != 0) {
+                    throw std::system_error(errno, std::system_category(), "Failed to sync");
+                }
+                dirty = false;
+                last_sync = now;
+            }
+        } catch (const std::exception &) {
+            failed = true;
+        }
+
+        if (compaction == Compaction::kRunning) {
+            _FinishCompaction(stopping);
+        } else if (!stopping && !failed &&
+                   (compaction == Compaction::kRequested ||
+                    (_file_size >= _compact_size && _file_size >= 2 * _compacted_size))) {
+            _StartCompaction();
+        }
+
+        lock.lock();
+        if (!dirty) {
+            _synced = std::max(_synced, seq);
+        }
+        _failed = _failed || failed;
+        if (stopping && _compaction == Compaction::kRequested) {
+            _compaction = Compaction::kIdle;
+        }
+        _done.notify_all();
+
+        if (stopping && _pending.empty() && _compaction == Compaction::kIdle) {
+            break;
+        }
+    }
+}
+
+bool CommandLog::_StartCompaction() {
+    // Mutation and its record are done under the key lock, so with all of them held each mutation is either
+    // in the frozen storage and not kept aside, or the other way round, never in both
+    for (std::size_t i = 0; i < kKeyLocks; ++i) {
+        _key_locks[i].lock();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rewrite.clear();
+        _compaction = Compaction::kRunning;
+    }
+
+    // Records appended after that point are kept aside, child takes everything before from the storage
+    _storage->Freeze();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int status = 0;
+        try {
+            std::string tmp = RewritePath(_path);
+            int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                _exit(1);
+            }
+
+            std::string buffer;
+            bool scanned = _storage->Scan([&](const char *key, std::size_t key_size, const char *value,
+                                              std::size_t value_size, std::time_t expire) {
+                _Encode(buffer, Op::kPut, std::string(key, key_size), std::string(value, value_size), expire);
+                if (buffer.size() >= kDumpBuffer) {
+                    WriteAll(fd, buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            });
+            WriteAll(fd, buffer.data(), buffer.size());
+            if (!scanned || fsync(fd) != 0) {
+                status = 1;
+            }
+            close(fd);
+        } catch (const std::exception &) {
+            status = 1;
+        }
+        _exit(status);
+    }
+    _storage->Thaw();
+    for (std::size_t i = kKeyLocks; i-- > 0;) {
+        _key_locks[i].unlock();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (pid < 0) {
+        _rewrite.clear();
+        _compaction = Compaction::kIdle;
+        _compacted = false;
+        _compacted_size = _file_size;
+        _compactions++;
+        return false;
+    }
+    _child = pid;
+    return true;
+}
+
+void CommandLog::_FinishCompaction(bool wait) {
+    int status;
+    pid_t pid;
+    do {
+        pid = waitpid(_child, &status, wait ? 0 : WNOHANG);
+    } while (pid < 0 && errno == EINTR);
+    if (pid == 0) {
+        return;
+    }
+
+    std::string tmp = RewritePath(_path);
+    bool succeeded = pid == _child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    int fd = succeeded ? open(tmp.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC) : -1;
+
+    std::string tail;
+    std::size_t unwritten;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _child = 0;
+        _compaction = Compaction::kIdle;
+        tail.swap(_rewrite);
+
+        // Batches are taken by this thread only, so old log has all of the tail but what is pending now
+        unwritten = _pending.size();
+        seq = _appended;
+    }
+
+    // Pending records stay until the new log is in place, if it never is they go to the old one as usual
+    bool flushed = false;
+    if (fd >= 0) {
+        try {
+            WriteAll(fd, tail.data(), tail.size());
+            if (fdatasync(fd) != 0 || rename(tmp.c_str(), _path.c_str()) != 0) {
+                throw std::system_error(errno, std::system_category(), "Failed to replace log");
+            }
+            close(_fd);
+            _fd = fd;
+            _file_size = lseek(fd, 0, SEEK_END);
+            flushed = true;
+        } catch (const std::exception &) {
+            close(fd);
+            unlink(tmp.c_str());
+            fd = -1;
+        }
+    } else {
+        unlink(tmp.c_str());
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (flushed) {
+        // Records appended since the tail was taken follow the ones written with it
+        _pending.erase(0, unwritten);
+        _synced = std::max(_synced, seq);
+    }
+    _compacted = flushed;
+    _compacted_size = _file_size;
+    _compactions++;
+    _done.notify_all();
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,229 @@
+#ifndef AFINA_STORAGE_COMMAND_LOG_H
+#define AFINA_STORAGE_COMMAND_LOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Append-only log of mutations
+ * Wraps any storage backend and records every successful mutation into a log file, which is replayed on
+ * Start to rebuild the storage. All execute commands reach the storage through Put, PutIfAbsent, Set,
+ * CompareAndSwap, Delete, Append, Prepend, Increment and Decrement, so the log sits right on that boundary.
+ * Records are logged in the form of the result rather than the request: conditional insert or swap that
+ * succeeded is logged as a plain put, the one that failed isn't logged at all, so replay is deterministic
+ * whatever is in the storage. Versions are not logged, replayed values get new ones. Successful append is
+ * logged as the data added, not the whole value, so that record doesn't grow with the value. Counter change
+ * is logged as the delta, so that replay keeps expire time of the counter.
+ *
+ * Each record is u32 body size and u32 CRC32C of the body, then the body: u8 operation, varint key size,
+ * varint value size, varint expire time, key and value bytes. Replay stops at the first torn or corrupted
+ * record, which could only be the tail written at the moment of a crash, and cuts it off.
+ *
+ * Group commit: callers only append records to the pending buffer, a dedicated writer thread takes the
+ * whole buffer at once and makes a single write and, depending on the policy, a single fsync for it. With
+ * kAlways policy callers wait until the batch with their record is synced, so each mutation is durable once
+ * it returns, and concurrent callers share one fsync. kEverySec syncs at most once a second and callers
+ * never wait, up to a second of mutations could be lost. kNever leaves syncing to the OS.
+ *
+ * Mutation and its record are ordered by a lock striped by key, so that log order of changes of the same
+ * key is the order they were applied in.
+ *
+ * Compaction: once the log gets compact_size bytes and twice the size it had after the previous compaction,
+ * the writer forks a child that scans the frozen storage into a new log, the same way Snapshotter does.
+ * Records appended meanwhile are kept aside and added to the new log once child is done, then new log
+ * replaces the old one. So replay time stays proportional to the live dataset rather than to the history.
+ *
+ * That is thread safe implementation as long as the wrapped storage is
+ */
+class CommandLog : public Afina::Storage {
+public:
+    enum class FsyncPolicy { kAlways, kEverySec, kNever };
+
+    CommandLog(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+               FsyncPolicy policy = FsyncPolicy::kEverySec, std::size_t compact_size = 64 * 1024 * 1024);
+    ~CommandLog();
+
+    void Start() override;
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return Put(key, value, 0); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return PutIfAbsent(key, value, 0);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return Set(key, value, 0); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface, key is copied out to be logged by Delete above
+    bool Delete(const KeyRef &key) override { return Delete(key.str()); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override { return _storage->View(key, visitor); }
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override { return _storage->View(key, visitor); }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override {
+        return _storage->MultiView(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override {
+        return _storage->MultiView(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override {
+        return _storage->MultiViewCas(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    void Freeze() override { _storage->Freeze(); }
+
+    // Implements Afina::Storage interface
+    void Thaw() override { _storage->Thaw(); }
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override { return _storage->Scan(scanner); }
+
+    // Implements Afina::Storage interface
+    void Report(const Reporter &reporter) override { _storage->Report(reporter); }
+
+    /**
+     * Rewrites log from the live dataset right now and waits until it is done, returns false if it failed
+     */
+    bool Compact();
+
+    /**
+     * Number of records replayed by the last Start
+     */
+    std::size_t replayed() const { return _replayed; }
+
+private:
+    enum class Op : uint8_t { kPut = 1, kDelete = 2, kAppend = 3, kPrepend = 4, kIncrement = 5, kDecrement = 6 };
+
+    enum class Compaction { kIdle, kRequested, kRunning };
+
+    // Number of locks mutations are ordered by
+    static constexpr std::size_t kKeyLocks = 64;
+
+    static void _Encode(std::string &out, Op op, const std::string &key, const std::string &value,
+                        std::time_t expire);
+
+    std::mutex &_KeyLock(const std::string &key);
+
+    // Adds record to the pending batch, returns its sequence number or 0 if nothing is logged
+    uint64_t _Append(Op op, const std::string &key, const std::string &value, std::time_t expire);
+
+    // Waits until record is synced if policy says so, returns false if it couldn't be made durable
+    bool _Wait(uint64_t seq);
+
+    // Applies log file to the wrapped storage, cuts torn tail off. Returns size of the valid part
+    std::size_t _Replay();
+
+    // Writer thread loop
+    void _Run();
+
+    // Forks a child that dumps the storage into a new log, returns false if fork failed
+    bool _StartCompaction();
+
+    // Reaps compaction child if it is done and switches to the new log, blocks until then if wait is set
+    void _FinishCompaction(bool wait);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::string _path;
+    const FsyncPolicy _policy;
+    const std::size_t _compact_size;
+
+    std::mutex _key_locks[kKeyLocks];
+
+    // Log file, owned by the writer thread once started
+    int _fd;
+    std::size_t _file_size;
+    std::size_t _compacted_size;
+    std::size_t _replayed;
+
+    // Guards fields below
+    std::mutex _mutex;
+
+    // Wakes writer up
+    std::condition_variable _wake;
+
+    // Wakes up callers waiting for their records to be synced or for compaction to finish
+    std::condition_variable _done;
+
+    // Records not written yet, sequence number of the last one appended and of the last one synced
+    std::string _pending;
+    uint64_t _appended;
+    uint64_t _synced;
+
+    // Records appended since compaction started, they go to the new log
+    std::string _rewrite;
+    Compaction _compaction;
+    pid_t _child;
+
+    // Number of compactions finished and whether the last one succeeded
+    uint64_t _compactions;
+    bool _compacted;
+
+    // Set once writing to the log failed, nothing is logged after that
+    bool _failed;
+
+    bool _running;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_COMMAND_LOG_H
@@ -0,0 +1,180 @@
+#ifndef AFINA_STORAGE_EPOCH_H
+#define AFINA_STORAGE_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Epoch based memory reclamation
+ * Lets lock-free structures free nodes that other threads could still be reading. Each operation on the
+ * structure runs inside of a Guard, which announces the global epoch it has seen. Node removed from the
+ * structure is not freed right away but retired: it is stamped with the current epoch and kept aside.
+ * Global epoch advances only once every thread inside of a Guard has seen the current one, so after two
+ * advances nobody could hold a pointer to the node anymore and it gets freed.
+ *
+ * Threads take one of kSlots slots for the duration of a Guard, slot keeps the announced epoch and the
+ * nodes retired through it. Slot is picked by a per thread hint, so normally each thread keeps using own
+ * slot and taking it is a single uncontended CAS. Nodes left in slot by an exited thread are freed by the
+ * next one that picks it up, or on destruction.
+ *
+ * That is thread safe implementation
+ */
+class Epoch {
+public:
+    using Deleter = void (*)(void *);
+
+    /**
+     * # Critical section
+     * Pointers read from the structure stay valid until Guard is destroyed
+     */
+    class Guard {
+    public:
+        explicit Guard(Epoch &epoch) : _epoch(epoch), _slot(epoch._Enter()) {}
+        ~Guard() { _epoch._Leave(_slot); }
+
+        /**
+         * Schedules ptr to be freed by deleter once no thread could see it
+         */
+        void Retire(void *ptr, Deleter deleter) { _epoch._Retire(_slot, ptr, deleter); }
+
+    private:
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+
+        Epoch &_epoch;
+        std::size_t _slot;
+    };
+
+    Epoch() : _global(kFirstEpoch) {
+        // new doesn't respect alignment above the fundamental one until C++17
+        void *mem = nullptr;
+        if (posix_memalign(&mem, kCacheLine, sizeof(slot) * kSlots) != 0) {
+            throw std::bad_alloc();
+        }
+        _slots = static_cast<slot *>(mem);
+        for (std::size_t i = 0; i < kSlots; ++i) {
+            new (&_slots[i]) slot();
+        }
+    }
+
+    ~Epoch() {
+        for (std::size_t i = 0; i < kSlots; ++i) {
+            for (auto &node : _slots[i].retired) {
+                node.deleter(node.ptr);
+            }
+            _slots[i].~slot();
+        }
+        std::free(_slots);
+    }
+
+private:
+    Epoch(const Epoch &) = delete;
+    Epoch &operator=(const Epoch &) = delete;
+
+    static constexpr std::size_t kSlots = 128;
+    static constexpr std::size_t kCacheLine = 64;
+
+    // Announced by slot which isn't in a critical section
+    static constexpr uint64_t kIdle = 0;
+    static constexpr uint64_t kFirstEpoch = 1;
+
+    // Retired nodes count which triggers reclamation attempt
+    static constexpr std::size_t kCollectEvery = 64;
+
+    struct retired_node {
+        uint64_t epoch;
+        void *ptr;
+        Deleter deleter;
+    };
+
+    struct alignas(kCacheLine) slot {
+        std::atomic<bool> taken{false};
+        std::atomic<uint64_t> announced{kIdle};
+
+        // Owned by the thread which has taken slot
+        std::vector<retired_node> retired;
+    };
+
+    static std::size_t &_Hint() {
+        static std::atomic<std::size_t> threads(0);
+        static thread_local std::size_t hint = threads.fetch_add(1, std::memory_order_relaxed);
+        return hint;
+    }
+
+    std::size_t _Enter() {
+        std::size_t &hint = _Hint();
+        for (std::size_t i = hint;; ++i) {
+            slot &s = _slots[i % kSlots];
+            if (!s.taken.load(std::memory_order_relaxed) && !s.taken.exchange(true, std::memory_order_acquire)) {
+                hint = i % kSlots;
+                break;
+            }
+        }
+
+        // Announcement must be visible before any pointer is read, re-check in case epoch moved meanwhile
+        slot &s = _slots[hint];
+        uint64_t epoch = _global.load(std::memory_order_seq_cst);
+        uint64_t seen;
+        do {
+            seen = epoch;
+            s.announced.store(seen, std::memory_order_seq_cst);
+            epoch = _global.load(std::memory_order_seq_cst);
+        } while (epoch != seen);
+        return hint;
+    }
+
+    void _Leave(std::size_t idx) {
+        slot &s = _slots[idx];
+        s.announced.store(kIdle, std::memory_order_release);
+        s.taken.store(false, std::memory_order_release);
+    }
+
+    void _Retire(std::size_t idx, void *ptr, Deleter deleter) {
+        slot &s = _slots[idx];
+        s.retired.push_back(retired_node{_global.load(std::memory_order_seq_cst), ptr, deleter});
+        if (s.retired.size() % kCollectEvery == 0) {
+            _Collect(s);
+        }
+    }
+
+    // Tries to advance global epoch, then frees nodes of the slot retired at least two epochs ago: threads
+    // that could see such a node were in epoch E-1 or E back then, and all of them have left since
+    void _Collect(slot &s) {
+        uint64_t epoch = _global.load(std::memory_order_seq_cst);
+        bool all_seen = true;
+        for (std::size_t i = 0; i < kSlots && all_seen; ++i) {
+            uint64_t announced = _slots[i].announced.load(std::memory_order_seq_cst);
+            all_seen = announced == kIdle || announced == epoch;
+        }
+        if (all_seen && _global.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst)) {
+            epoch++;
+        }
+
+        std::size_t kept = 0;
+        for (auto &node : s.retired) {
+            if (node.epoch + 2 <= epoch) {
+                node.deleter(node.ptr);
+            } else {
+                s.retired[kept++] = node;
+            }
+        }
+        s.retired.resize(kept);
+    }
+
+    std::atomic<uint64_t> _global;
+
+    // Array of kSlots slots aligned to kCacheLine
+    slot *_slots;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EPOCH_H
@@ -0,0 +1,437 @@
+#include "ExtentStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <aio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Codec.h"
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t ExtentStore::kDefaultExtentSize;
+constexpr std::size_t ExtentStore::kRecordHeader;
+
+// Reads submitted by a single lio_listio call
+static constexpr std::size_t kReadBatch = 64;
+
+static void ReadAt(int fd, char *data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, data, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::system_error(n < 0 ? errno : EIO, std::system_category(), "Failed to read extent");
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+static void WriteAt(int fd, const char *data, std::size_t size, off_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to write extent");
+        }
+        data += n;
+        size -= n;
+        offset += n;
+    }
+}
+
+ExtentStore::ExtentStore(const std::string &path, std::size_t capacity, std::size_t extent_size)
+    : _extent_size(extent_size), _path(path), _fd(-1), _extents(capacity / extent_size, extent{0, 0, 0}), _active(0),
+      _generation(0), _live_bytes(0), _compactions(0), _drops(0) {
+    if (_extents.size() < 2) {
+        throw std::invalid_argument("Extent store needs room for two extents at least");
+    }
+
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to open " + path);
+    }
+
+    // Lower extents are taken first
+    for (std::size_t idx = _extents.size(); idx-- > 1;) {
+        _free.push_back(idx);
+    }
+    _extents[_active].generation = ++_generation;
+    _buffer.reserve(_extent_size);
+}
+
+ExtentStore::~ExtentStore() {
+    close(_fd);
+    unlink(_path.c_str());
+}
+
+// See ExtentStore.h
+bool ExtentStore::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    // Old value must not survive failed Put either
+    Delete(key);
+    if (expire != 0 && expire <= std::time(nullptr)) {
+        return true;
+    }
+
+    std::size_t size = kRecordHeader + key.size() + value.size();
+    if (size > _extent_size) {
+        return false;
+    }
+    if (_buffer.size() + size > _extent_size) {
+        _Roll(size);
+    }
+    _index[key] = _Append(key, value, expire);
+    return true;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Contains(const std::string &key) { return _Lookup(key, std::time(nullptr)) != _index.end(); }
+
+// See ExtentStore.h
+uint64_t ExtentStore::Version(const std::string &key) const {
+    auto it = _index.find(key);
+    return it == _index.end() ? 0 : _Version(it->second);
+}
+
+// See ExtentStore.h
+std::time_t ExtentStore::Expire(const std::string &key) const {
+    auto it = _index.find(key);
+    return it == _index.end() ? 0 : it->second.expire;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Delete(const std::string &key) {
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+    location loc = it->second;
+    _index.erase(it);
+    _Release(loc);
+    return true;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Get(const std::string &key, std::string &value) {
+    std::vector<Fetch> fetch(1);
+    if (!Locate(key, fetch[0])) {
+        return false;
+    }
+    Load(fetch);
+    return Take(fetch[0], value);
+}
+
+// See ExtentStore.h
+std::size_t ExtentStore::MultiGet(const std::vector<std::string> &keys, const Visitor &visitor) {
+    std::vector<Fetch> fetches(keys.size());
+    std::size_t located = 0;
+    for (auto &key : keys) {
+        located += Locate(key, fetches[located]);
+    }
+    fetches.resize(located);
+    Load(fetches);
+
+    std::size_t found = 0;
+    std::string value;
+    for (auto &fetch : fetches) {
+        if (Take(fetch, value)) {
+            visitor(fetch.key, value);
+            found++;
+        }
+    }
+    return found;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Locate(const std::string &key, Fetch &fetch) {
+    auto it = _Lookup(key, std::time(nullptr));
+    if (it == _index.end()) {
+        return false;
+    }
+    const location &loc = it->second;
+    fetch.key = key;
+    fetch.expire = loc.expire;
+    fetch.version = _Version(loc);
+    fetch.offset = uint64_t(loc.extent) * _extent_size + loc.offset;
+    fetch.size = loc.size;
+    fetch.loaded = loc.extent == _active;
+    if (fetch.loaded) {
+        fetch.record.assign(_buffer, loc.offset, loc.size);
+    } else {
+        fetch.record.clear();
+    }
+    return true;
+}
+
+// See ExtentStore.h
+void ExtentStore::Load(std::vector<Fetch> &fetches) const {
+    std::vector<Fetch *> pending;
+    for (auto &fetch : fetches) {
+        if (!fetch.loaded) {
+            fetch.record.resize(fetch.size);
+            pending.push_back(&fetch);
+        }
+    }
+
+    // Single record is read synchronously, more of them are read from disk at once
+    std::vector<struct aiocb> cbs(std::min(pending.size(), kReadBatch));
+    for (std::size_t start = 0; start < pending.size() && pending.size() > 1; start += kReadBatch) {
+        std::size_t end = std::min(pending.size(), start + kReadBatch);
+        std::vector<struct aiocb *> batch;
+        for (std::size_t i = start; i < end; ++i) {
+            struct aiocb &cb = cbs[i - start];
+            std::memset(&cb, 0, sizeof(cb));
+            cb.aio_fildes = _fd;
+            cb.aio_offset = off_t(pending[i]->offset);
+            cb.aio_nbytes = pending[i]->size;
+            cb.aio_buf = &pending[i]->record[0];
+            cb.aio_lio_opcode = LIO_READ;
+            cb.aio_sigevent.sigev_notify = SIGEV_NONE;
+            batch.push_back(&cb);
+        }
+
+        // Failure of the whole call is checked per request, the ones that didn't go are read synchronously
+        lio_listio(LIO_WAIT, batch.data(), batch.size(), nullptr);
+        for (std::size_t i = start; i < end; ++i) {
+            struct aiocb &cb = cbs[i - start];
+            pending[i]->loaded = aio_error(&cb) == 0 && aio_return(&cb) == ssize_t(pending[i]->size);
+        }
+    }
+
+    for (Fetch *fetch : pending) {
+        if (fetch->loaded) {
+            continue;
+        }
+        try {
+            ReadAt(_fd, &fetch->record[0], fetch->size, off_t(fetch->offset));
+            fetch->loaded = true;
+        } catch (const std::system_error &) {
+        }
+    }
+}
+
+// See ExtentStore.h
+bool ExtentStore::Take(const Fetch &fetch, std::string &value) {
+    // Record place is never reused while the entry is there, so the same version means bytes are of this entry
+    if (Version(fetch.key) != fetch.version) {
+        return false;
+    }
+    std::string stored;
+    if (!fetch.loaded || !_Decode(fetch.record.data(), fetch.record.size(), stored, value) || stored != fetch.key) {
+        Delete(fetch.key);
+        return false;
+    }
+    return true;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Scan(const Storage::Scanner &scanner) {
+    std::vector<uint32_t> order;
+    for (uint32_t idx = 0; idx < _extents.size(); ++idx) {
+        if (_extents[idx].used > 0 || idx == _active) {
+            order.push_back(idx);
+        }
+    }
+    std::sort(order.begin(), order.end(),
+              [this](uint32_t a, uint32_t b) { return _extents[a].generation < _extents[b].generation; });
+
+    std::time_t now = std::time(nullptr);
+    for (uint32_t idx : order) {
+        _ForEachLive(idx, [this, &scanner, now](const std::string &key, const std::string &value) {
+            const location &loc = _index.find(key)->second;
+            if (!loc.Expired(now)) {
+                scanner(key.data(), key.size(), value.data(), value.size(), loc.expire);
+            }
+        });
+    }
+    return true;
+}
+
+// See ExtentStore.h
+bool ExtentStore::Compact() {
+    std::size_t room = _extent_size - _buffer.size();
+    uint32_t victim = _active;
+    for (uint32_t idx = 0; idx < _extents.size(); ++idx) {
+        const extent &ext = _extents[idx];
+        if (idx != _active && ext.used > 0 && ext.live * 2 <= _extent_size && ext.live <= room &&
+            (victim == _active || ext.live < _extents[victim].live)) {
+            victim = idx;
+        }
+    }
+    if (victim == _active) {
+        return false;
+    }
+
+    // Live records fit into the active extent, so appends never roll it over. Expired ones are dropped
+    std::time_t now = std::time(nullptr);
+    _ForEachLive(victim, [this, now](const std::string &key, const std::string &value) {
+        auto it = _index.find(key);
+        location &loc = it->second;
+        _extents[loc.extent].live -= loc.size;
+        _live_bytes -= loc.size;
+        if (loc.Expired(now)) {
+            _index.erase(it);
+        } else {
+            loc = _Append(key, value, loc.expire);
+        }
+    });
+    _Free(victim);
+    _compactions++;
+    return true;
+}
+
+// See ExtentStore.h
+ExtentStore::Stats ExtentStore::GetStats() const {
+    std::size_t used = 0;
+    for (uint32_t idx = 0; idx < _extents.size(); ++idx) {
+        used += _extents[idx].used > 0 || idx == _active;
+    }
+    return Stats{_index.size(), _live_bytes, used, _extents.size(), _compactions, _drops};
+}
+
+bool ExtentStore::_Decode(const char *record, std::size_t size, std::string &key, std::string &value) {
+    if (size < kRecordHeader) {
+        return false;
+    }
+    uint32_t key_size = GetU32(record + 4);
+    uint32_t value_size = GetU32(record + 8);
+    if (size - kRecordHeader < std::size_t(key_size) + value_size ||
+        Crc32c(0, record + 4, 8 + std::size_t(key_size) + value_size) != GetU32(record)) {
+        return false;
+    }
+    key.assign(record + kRecordHeader, key_size);
+    value.assign(record + kRecordHeader + key_size, value_size);
+    return true;
+}
+
+uint64_t ExtentStore::_Version(const location &loc) const {
+    // Generations only grow and offsets within one of them never repeat
+    return (uint64_t(1) << 63) | (_extents[loc.extent].generation << 32) | loc.offset;
+}
+
+ExtentStore::location ExtentStore::_Append(const std::string &key, const std::string &value, std::time_t expire) {
+    location loc{_active, uint32_t(_buffer.size()), uint32_t(kRecordHeader + key.size() + value.size()), expire};
+    _buffer.append(4, '\0');
+    PutU32(_buffer, key.size());
+    PutU32(_buffer, value.size());
+    _buffer.append(key).append(value);
+
+    std::string crc;
+    PutU32(crc, Crc32c(0, _buffer.data() + loc.offset + 4, loc.size - 4));
+    _buffer.replace(loc.offset, 4, crc);
+
+    _extents[_active].used = _buffer.size();
+    _extents[_active].live += loc.size;
+    _live_bytes += loc.size;
+    return loc;
+}
+
+std::unordered_map<std::string, ExtentStore::location>::iterator ExtentStore::_Lookup(const std::string &key,
+                                                                                    std::time_t now) {
+    auto it = _index.find(key);
+    if (it != _index.end() && it->second.Expired(now)) {
+        location loc = it->second;
+        _index.erase(it);
+        _Release(loc);
+        return _index.end();
+    }
+    return it;
+}
+
+void ExtentStore::_Release(const location &loc) {
+    extent &ext = _extents[loc.extent];
+    ext.live -= loc.size;
+    _live_bytes -= loc.size;
+    if (ext.live == 0 && loc.extent != _active) {
+        _Free(loc.extent);
+    }
+}
+
+void ExtentStore::_Roll(std::size_t size) {
+    WriteAt(_fd, _buffer.data(), _buffer.size(), off_t(_active) * _extent_size);
+    _buffer.clear();
+    if (_extents[_active].live == 0) {
+        _Free(_active);
+    }
+
+    if (_free.empty()) {
+        uint32_t oldest = 0;
+        for (uint32_t idx = 1; idx < _extents.size(); ++idx) {
+            if (_extents[idx].generation < _extents[oldest].generation) {
+                oldest = idx;
+            }
+        }
+        _Drop(oldest);
+    }
+
+    _active = _free.back();
+    _free.pop_back();
+    _extents[_active] = extent{0, 0, ++_generation};
+
+    // Fresh extent has room for a half of another one, minus the record that is about to be appended
+    if (_extent_size - size >= _extent_size / 2) {
+        Compact();
+    }
+}
+
+void ExtentStore::_Free(uint32_t idx) {
+    _extents[idx] = extent{0, 0, 0};
+    _free.push_back(idx);
+#ifdef FALLOC_FL_PUNCH_HOLE
+    fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off_t(idx) * _extent_size, _extent_size);
+#endif
+}
+
+void ExtentStore::_Drop(uint32_t idx) {
+    _ForEachLive(idx, [this](const std::string &key, const std::string &) {
+        auto it = _index.find(key);
+        _live_bytes -= it->second.size;
+        _index.erase(it);
+    });
+    _drops++;
+    _Free(idx);
+}
+
+void ExtentStore::_ForEachLive(uint32_t idx, const Visitor &visitor) {
+    std::string data;
+    if (idx == _active) {
+        data = _buffer;
+    } else {
+        data.resize(_extents[idx].used);
+        try {
+            ReadAt(_fd, &data[0], data.size(), off_t(idx) * _extent_size);
+        } catch (const std::system_error &) {
+            data.clear();
+        }
+    }
+
+    std::string key, value;
+    for (std::size_t offset = 0; offset + kRecordHeader <= data.size();) {
+        std::size_t size = kRecordHeader + std::size_t(GetU32(&data[offset + 4])) + GetU32(&data[offset + 8]);
+        if (size > data.size() - offset || !_Decode(&data[offset], size, key, value)) {
+            break;
+        }
+
+        // Record is live if index still points to it
+        auto it = _index.find(key);
+        if (it != _index.end() && it->second.extent == idx && it->second.offset == offset) {
+            visitor(key, value);
+        }
+        offset += size;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
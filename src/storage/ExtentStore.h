@@ -0,0 +1,237 @@
+#ifndef AFINA_STORAGE_EXTENT_STORE_H
+#define AFINA_STORAGE_EXTENT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Log structured store of cold entries
+ * File of capacity bytes split into extents of extent_size bytes each. Entries are appended to the active
+ * extent, which is buffered in memory and written out at once when full, then the next free extent becomes
+ * active. Only the key and the location of each entry are kept in memory.
+ *
+ * Each record is u32 CRC32C, u32 key size, u32 value size, then key and value bytes. The checksum covers
+ * sizes and bytes, so record read from a reused extent or a damaged disk is never taken for the entry.
+ *
+ * Entries replaced or deleted leave dead records behind. Extent that has no live records left is freed
+ * right away and its space is given back to the file system. Each time a new extent becomes active the
+ * sparsest sealed one, if at most a half of it is live, is compacted: its live records are copied into the
+ * active extent and it is freed. If there are no free extents anyway, the oldest one is dropped with all
+ * its entries, so the store works as a FIFO cache once it is full.
+ *
+ * Expire time of an entry is kept in memory next to its location. Lookup that finds entry expired deletes
+ * it, and compaction drops expired records instead of copying them.
+ *
+ * Content doesn't survive the store, file is truncated on open and removed on destruction.
+ *
+ * That is NOT thread safe implementaiton!! Though Load doesn't touch the store state, so that the lock that
+ * guards the store needn't be held while the disk is busy, see Locate
+ */
+class ExtentStore {
+public:
+    /**
+     * Counters of the store state
+     */
+    struct Stats {
+        // Number of entries and bytes of their records
+        std::size_t entries;
+        std::size_t live_bytes;
+
+        // Extents with records, including the active one
+        std::size_t extents_used;
+        std::size_t extents_total;
+
+        // Extents compacted and dropped while still having live records
+        uint64_t compactions;
+        uint64_t drops;
+    };
+
+    /**
+     * Entry record on its way from the file, see Locate
+     */
+    struct Fetch {
+        std::string key;
+        std::time_t expire;
+
+        // Version of the entry the record belongs to, see Version
+        uint64_t version;
+
+        // Place of the record in the file
+        uint64_t offset;
+        uint32_t size;
+
+        // Bytes of the record, they are in place once loaded is set
+        std::string record;
+        bool loaded;
+    };
+
+    using Visitor = std::function<void(const std::string &key, const std::string &value)>;
+
+    static constexpr std::size_t kDefaultExtentSize = 4 * 1024 * 1024;
+
+    /**
+     * @param path of the file to keep entries in, it is created or truncated
+     * @param capacity bytes of the file, rounded down to extents
+     * @param extent_size bytes of extent, biggest record must fit one
+     */
+    ExtentStore(const std::string &path, std::size_t capacity, std::size_t extent_size = kDefaultExtentSize);
+    ~ExtentStore();
+
+    ExtentStore(const ExtentStore &) = delete;
+    ExtentStore &operator=(const ExtentStore &) = delete;
+
+    /**
+     * Stores entry replacing the previous one with the same key, returns false if it doesn't fit an
+     * extent. Entry with expire time in the past only deletes the previous one, see Storage::Put. Throws
+     * std::system_error if file couldn't be written
+     */
+    bool Put(const std::string &key, const std::string &value, std::time_t expire = 0);
+
+    /**
+     * Returns true if there is entry with the key, deletes it if it is expired
+     */
+    bool Contains(const std::string &key);
+
+    /**
+     * Returns version of the entry record, 0 if there is none. Each Put writes record to a new place, so
+     * version changes every time entry is stored, and also when compaction moves it. Versions have the top
+     * bit set
+     */
+    uint64_t Version(const std::string &key) const;
+
+    /**
+     * Returns expire time of the entry, 0 if it never expires or there is no such entry
+     */
+    std::time_t Expire(const std::string &key) const;
+
+    bool Delete(const std::string &key);
+
+    /**
+     * Reads value of the entry, returns false if there is none or its record is damaged
+     */
+    bool Get(const std::string &key, std::string &value);
+
+    /**
+     * Same as Get for a set of keys: reads for all the keys are issued at once with asynchronous I/O and
+     * proceed in parallel, so that a batch costs about one disk round trip instead of one per key. Visitor
+     * is called for each entry found, returns number of them
+     */
+    std::size_t MultiGet(const std::vector<std::string> &keys, const Visitor &visitor);
+
+    /**
+     * Get split into three steps, so that others may use the store while the disk is busy. Locate finds where
+     * the entry record is, returns false if there is no entry. Record that is still in memory is copied right
+     * away, so the fetch is loaded already
+     */
+    bool Locate(const std::string &key, Fetch &fetch);
+
+    /**
+     * Reads records of all the fetches not loaded yet, the same way MultiGet does. Store itself isn't
+     * touched, so the call may go concurrently with any other one
+     */
+    void Load(std::vector<Fetch> &fetches) const;
+
+    /**
+     * Decodes value of the fetched record. Returns false if entry has changed or moved since Locate, or if
+     * the record couldn't be read or is damaged, the latter entry is deleted
+     */
+    bool Take(const Fetch &fetch, std::string &value);
+
+    /**
+     * Reads all entries in order of extents, see Storage::Scan
+     */
+    bool Scan(const Storage::Scanner &scanner);
+
+    /**
+     * Compacts the sparsest sealed extent if at most a half of it is live and its live records fit into
+     * the active extent. Returns true if some extent was compacted
+     */
+    bool Compact();
+
+    Stats GetStats() const;
+
+private:
+    // Place of the entry record
+    struct location {
+        bool Expired(std::time_t now) const { return expire != 0 && expire <= now; }
+
+        uint32_t extent;
+        uint32_t offset;
+        uint32_t size;
+
+        // Unix time entry expires at, 0 if never
+        std::time_t expire;
+    };
+
+    struct extent {
+        // Bytes of records written and of the live ones among them
+        std::size_t used;
+        std::size_t live;
+
+        // Order extent became active in, the oldest one is dropped first
+        uint64_t generation;
+    };
+
+    // Sizes and checksum in front of each record
+    static constexpr std::size_t kRecordHeader = 3 * sizeof(uint32_t);
+
+    // Decodes record, returns false if it is damaged
+    static bool _Decode(const char *record, std::size_t size, std::string &key, std::string &value);
+
+    // See Version
+    uint64_t _Version(const location &loc) const;
+
+    // Appends record to the active extent, which has room for it
+    location _Append(const std::string &key, const std::string &value, std::time_t expire);
+
+    // Same as _index.find, but expired entry is deleted and never returned
+    std::unordered_map<std::string, location>::iterator _Lookup(const std::string &key, std::time_t now);
+
+    // Marks record as dead, frees extent once nothing is live there
+    void _Release(const location &loc);
+
+    // Writes active extent out and makes a free one active, extent of size bytes must fit into it
+    void _Roll(std::size_t size);
+
+    // Returns extent to the free list, all its records are dead
+    void _Free(uint32_t idx);
+
+    // Drops all entries stored in extent and frees it
+    void _Drop(uint32_t idx);
+
+    // Calls visitor for each live record in the extent, in order they were appended
+    void _ForEachLive(uint32_t idx, const Visitor &visitor);
+
+    const std::size_t _extent_size;
+    std::string _path;
+    int _fd;
+
+    std::vector<extent> _extents;
+    std::vector<uint32_t> _free;
+
+    // Active extent and its content that isn't written yet
+    uint32_t _active;
+    std::string _buffer;
+    uint64_t _generation;
+
+    std::unordered_map<std::string, location> _index;
+    std::size_t _live_bytes;
+
+    uint64_t _compactions;
+    uint64_t _drops;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EXTENT_STORE_H
@@ -0,0 +1,139 @@
+#include "FlatCombineLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Put(const std::string &key, const std::string &value) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Put(key, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::PutIfAbsent(key, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Set(const std::string &key, const std::string &value) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Set(key, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Put(key, value, expire); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::PutIfAbsent(key, value, expire); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Set(key, value, expire); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Append(const std::string &key, const std::string &data) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Append(key, data); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Prepend(const std::string &key, const std::string &data) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Prepend(key, data); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+Storage::IncrResult FlatCombineLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    IncrResult result;
+    _Run([&]() { result = SimpleLRU::Increment(key, delta, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+Storage::IncrResult FlatCombineLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    IncrResult result;
+    _Run([&]() { result = SimpleLRU::Decrement(key, delta, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Delete(const std::string &key) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Delete(key); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::Get(const std::string &key, std::string &value) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::Get(key, value); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+bool FlatCombineLRU::View(const std::string &key, const Visitor &visitor) {
+    bool result;
+    _Run([&]() { result = SimpleLRU::View(key, visitor); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+std::size_t FlatCombineLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::size_t result;
+    _Run([&]() { result = SimpleLRU::MultiView(keys, visitor); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+std::size_t FlatCombineLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::size_t result;
+    _Run([&]() { result = SimpleLRU::MultiViewCas(keys, visitor); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+Storage::CasResult FlatCombineLRU::CompareAndSwap(const std::string &key, const std::string &value,
+                                                  std::time_t expire, uint64_t cas) {
+    CasResult result;
+    _Run([&]() { result = SimpleLRU::CompareAndSwap(key, value, expire, cas); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+SimpleLRU::Stats FlatCombineLRU::GetStats() const {
+    Stats result;
+    _Run([&]() { result = SimpleLRU::GetStats(); });
+    return result;
+}
+
+// See FlatCombineLRU.h
+void FlatCombineLRU::SetMaxSize(std::size_t max_size) {
+    _Run([&]() { SimpleLRU::SetMaxSize(max_size); });
+}
+
+// See FlatCombineLRU.h
+std::time_t FlatCombineLRU::Expire(const std::string &key) const {
+    std::time_t result;
+    _Run([&]() { result = SimpleLRU::Expire(key); });
+    return result;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,125 @@
+#ifndef AFINA_STORAGE_FLAT_COMBINE_LRU_H
+#define AFINA_STORAGE_FLAT_COMBINE_LRU_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU driven by flat combining
+ * Same as ThreadSafeSimplLRU, but instead of taking the mutex each call is published to
+ * Concurrency::FlatCombine and executed by whichever thread is combining at the moment. Under contention a
+ * single thread runs long batches of calls, so the list and the index stay in its cache, rather than move
+ * to the core of each caller in turn.
+ *
+ * Visitors run on the combiner thread while the caller waits, they must not call the storage.
+ *
+ * That is thread safe implementation
+ */
+class FlatCombineLRU : public SimpleLRU {
+public:
+    FlatCombineLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ~FlatCombineLRU() {}
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // see SimpleLRU.h
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // see SimpleLRU.h
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override;
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // see SimpleLRU.h
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // see SimpleLRU.h
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // see SimpleLRU.h, KeyRef is copied into a string and passed to the methods above
+    using SimpleLRU::Delete;
+    using SimpleLRU::Get;
+    using SimpleLRU::View;
+    using SimpleLRU::MultiView;
+
+    // see SimpleLRU.h
+    void Freeze() override { _combiner.lock(); }
+
+    // see SimpleLRU.h
+    void Thaw() override { _combiner.unlock(); }
+
+    // see SimpleLRU.h
+    Stats GetStats() const;
+
+    // see SimpleLRU.h
+    void SetMaxSize(std::size_t max_size);
+
+    // see SimpleLRU.h
+    std::time_t Expire(const std::string &key) const;
+
+private:
+    // Type erased call published to the combiner, doesn't allocate unlike std::function
+    struct call {
+        void (*run)(void *fn);
+        void *fn;
+
+        void operator()() { run(fn); }
+    };
+
+    // Executes fn through the combiner
+    template <typename F> void _Run(F &&fn) const {
+        using type = typename std::remove_reference<F>::type;
+        call op{[](void *f) { (*static_cast<type *>(f))(); }, &fn};
+        _combiner.Execute(op);
+    }
+
+    mutable Concurrency::FlatCombine<call> _combiner;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FLAT_COMBINE_LRU_H
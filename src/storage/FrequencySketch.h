@@ -0,0 +1,102 @@
+#ifndef AFINA_STORAGE_FREQUENCY_SKETCH_H
+#define AFINA_STORAGE_FREQUENCY_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Count-min sketch of access frequencies
+ * Estimates how many times each key hash was seen recently. Four rows of 4-bit saturating counters are
+ * indexed by independent mixes of the hash; estimate is the minimum among the rows, so collisions could
+ * only overestimate a frequency.
+ *
+ * Popularity must follow the workload, so once the number of recorded accesses reaches sample size every
+ * counter gets halved ("aging"), and old history fades away exponentially.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class FrequencySketch {
+public:
+    /**
+     * @param capacity expected number of distinct items in the cache
+     */
+    FrequencySketch(std::size_t capacity) : _additions(0) {
+        std::size_t width = 64;
+        while (width < capacity) {
+            width <<= 1;
+        }
+        _mask = width - 1;
+        _sample_size = 10 * width;
+        // 16 counters of 4 bits packed into each word
+        _table.assign(width * kRows / 16, 0);
+    }
+
+    /**
+     * Records one more access of the given hash
+     */
+    void Increment(uint64_t hash) {
+        bool added = false;
+        for (std::size_t row = 0; row < kRows; ++row) {
+            std::size_t idx = _Index(hash, row);
+            uint64_t &word = _table[idx >> 4];
+            std::size_t shift = (idx & 15) << 2;
+            if (((word >> shift) & 0xf) != 0xf) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+
+        if (added && ++_additions == _sample_size) {
+            _Reset();
+        }
+    }
+
+    /**
+     * Returns estimated number of recent accesses of the given hash, at most 15
+     */
+    unsigned Frequency(uint64_t hash) const {
+        unsigned freq = 0xf;
+        for (std::size_t row = 0; row < kRows; ++row) {
+            std::size_t idx = _Index(hash, row);
+            unsigned count = (_table[idx >> 4] >> ((idx & 15) << 2)) & 0xf;
+            freq = count < freq ? count : freq;
+        }
+        return freq;
+    }
+
+private:
+    static constexpr std::size_t kRows = 4;
+
+    // Counter of the given row for the hash, rows are laid one after another
+    std::size_t _Index(uint64_t hash, std::size_t row) const {
+        static const uint64_t seeds[kRows] = {0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull, 0x9ae16a3b2f90404full,
+                                              0xcbf29ce484222325ull};
+        uint64_t h = (hash + seeds[row]) * seeds[row];
+        h ^= h >> 32;
+        return row * (_mask + 1) + (h & _mask);
+    }
+
+    // Halves all counters at once: shift each word and drop bits that crossed counter boundaries
+    void _Reset() {
+        for (uint64_t &word : _table) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        _additions /= 2;
+    }
+
+    std::vector<uint64_t> _table;
+    std::size_t _mask;
+
+    // Accesses recorded since the last aging and the number that triggers it
+    std::size_t _additions;
+    std::size_t _sample_size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FREQUENCY_SKETCH_H
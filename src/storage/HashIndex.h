@@ -0,0 +1,224 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Open addressing hash index
+ * Robin Hood hash table that maps a 64-bit key hash to the node owning the key. Index doesn't own nodes
+ * and knows nothing about keys: lookups take a predicate that checks whether a node holds the key being
+ * searched, and removal is done by node identity.
+ *
+ * Each slot keeps full hash next to the node pointer so probing compares 16 byte slots laying one after
+ * another and touches node memory only when hashes are equal.
+ *
+ * Growth is incremental: once table gets too dense, a new table twice as big becomes current one and
+ * entries from the old table are migrated a few slots per mutating call. Until migration is done lookups
+ * check both tables. That way no single request pays for rehashing the whole index.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+template <typename Node> class HashIndex {
+public:
+    HashIndex(std::size_t capacity = 16) : _size(0), _migrate_pos(0) {
+        std::size_t cap = 16;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        _cur.Reset(cap);
+    }
+
+    /**
+     * Returns node with the given hash for which predicate eq(node) returns true, nullptr if there is no
+     * such node in the index
+     */
+    template <typename Eq> Node *Find(uint64_t hash, Eq eq) const {
+        Node *node = _cur.Find(hash, eq);
+        if (node == nullptr && _old.slots) {
+            node = _old.Find(hash, eq);
+        }
+        return node;
+    }
+
+    /**
+     * Adds node into index. Caller guarantees that there is no node with the same key in the index yet
+     */
+    void Insert(uint64_t hash, Node *node) {
+        _Migrate();
+        if ((_cur.used + 1) * 8 > (_cur.mask + 1) * 7) {
+            _Grow();
+        }
+        _cur.Insert(hash, node);
+        _size++;
+    }
+
+    /**
+     * Removes given node from index, returns false if node wasn't indexed
+     */
+    bool Erase(uint64_t hash, const Node *node) {
+        _Migrate();
+        if (_cur.Erase(hash, node) || (_old.slots && _old.Erase(hash, node))) {
+            _size--;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Hints CPU to start loading slot where lookup of the given hash begins
+     */
+    void Prefetch(uint64_t hash) const { __builtin_prefetch(&_cur.slots[hash & _cur.mask]); }
+
+    void Clear() {
+        _cur.Reset(16);
+        _old.Reset(0);
+        _size = 0;
+        _migrate_pos = 0;
+    }
+
+    std::size_t size() const { return _size; }
+
+    // Number of slots allocated in all tables
+    std::size_t capacity() const { return (_cur.mask + 1) + (_old.slots ? _old.mask + 1 : 0); }
+
+private:
+    // How many old slots get examined for each mutating call during migration
+    static constexpr std::size_t kMigrateStep = 16;
+
+    struct Slot {
+        uint64_t hash;
+        Node *node;
+    };
+
+    struct Table {
+        std::unique_ptr<Slot[]> slots;
+        std::size_t mask = 0;
+        std::size_t used = 0;
+
+        void Reset(std::size_t cap) {
+            slots.reset(cap ? new Slot[cap]() : nullptr);
+            mask = cap ? cap - 1 : 0;
+            used = 0;
+        }
+
+        // Distance from the slot where hash would like to live to the slot at pos
+        std::size_t Distance(uint64_t hash, std::size_t pos) const { return (pos - (hash & mask)) & mask; }
+
+        template <typename Eq> Node *Find(uint64_t hash, Eq &eq) const {
+            std::size_t pos = hash & mask;
+            for (std::size_t dist = 0;; dist++, pos = (pos + 1) & mask) {
+                const Slot &slot = slots[pos];
+                if (slot.node == nullptr || Distance(slot.hash, pos) < dist) {
+                    return nullptr;
+                }
+                if (slot.hash == hash && eq(*slot.node)) {
+                    return slot.node;
+                }
+            }
+        }
+
+        void Insert(uint64_t hash, Node *node) {
+            Slot entry{hash, node};
+            std::size_t pos = hash & mask;
+            for (std::size_t dist = 0;; dist++, pos = (pos + 1) & mask) {
+                Slot &slot = slots[pos];
+                if (slot.node == nullptr) {
+                    slot = entry;
+                    used++;
+                    return;
+                }
+
+                // Rich slot gives its place to the poor entry, which continues probing
+                std::size_t slot_dist = Distance(slot.hash, pos);
+                if (slot_dist < dist) {
+                    std::swap(slot, entry);
+                    dist = slot_dist;
+                }
+            }
+        }
+
+        bool Erase(uint64_t hash, const Node *node) {
+            std::size_t pos = hash & mask;
+            for (std::size_t dist = 0;; dist++, pos = (pos + 1) & mask) {
+                const Slot &slot = slots[pos];
+                if (slot.node == nullptr || Distance(slot.hash, pos) < dist) {
+                    return false;
+                }
+                if (slot.node == node) {
+                    EraseAt(pos);
+                    return true;
+                }
+            }
+        }
+
+        // Backward shift deletion: no tombstones, probe sequences stay as short as possible
+        void EraseAt(std::size_t pos) {
+            std::size_t next = (pos + 1) & mask;
+            while (slots[next].node != nullptr && Distance(slots[next].hash, next) != 0) {
+                slots[pos] = slots[next];
+                pos = next;
+                next = (next + 1) & mask;
+            }
+            slots[pos] = Slot{0, nullptr};
+            used--;
+        }
+    };
+
+    void _Grow() {
+        // Migration is always finished long before the current table gets dense, but be defensive
+        while (_old.slots) {
+            _Migrate();
+        }
+        _old = std::move(_cur);
+        _cur.Reset((_old.mask + 1) * 2);
+        _migrate_pos = 0;
+    }
+
+    // Moves a few entries from the old table into the current one. Slots before _migrate_pos are always
+    // empty, so backward shift never drags an entry behind the cursor
+    void _Migrate() {
+        if (!_old.slots) {
+            return;
+        }
+
+        for (std::size_t step = 0; step < kMigrateStep && _migrate_pos <= _old.mask; step++) {
+            Slot &slot = _old.slots[_migrate_pos];
+            if (slot.node == nullptr) {
+                _migrate_pos++;
+                continue;
+            }
+            _cur.Insert(slot.hash, slot.node);
+            _old.EraseAt(_migrate_pos);
+        }
+
+        if (_migrate_pos > _old.mask) {
+            _old.Reset(0);
+            _migrate_pos = 0;
+        }
+    }
+
+    // Number of indexed nodes
+    std::size_t _size;
+
+    // Table new entries go to
+    Table _cur;
+
+    // Table being migrated into _cur, empty unless growth is in progress
+    Table _old;
+
+    // First slot of _old that could be non empty
+    std::size_t _migrate_pos;
+};
+
+template <typename Node> constexpr std::size_t HashIndex<Node>::kMigrateStep;
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,711 @@
+#include "HashLRU.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t HashLRU::kPrefetchDistance;
+constexpr std::size_t HashLRU::kReclaimBudget;
+constexpr std::size_t HashLRU::kEvictDepth;
+constexpr uint64_t HashLRU::kWarmLayout;
+
+HashLRU::HashLRU(size_t max_size)
+    : _max_size(max_size), _curr_size(0), _cas(0), _lru_head(nullptr), _lru_tail(nullptr), _timers(_Now()) {}
+
+HashLRU::HashLRU(std::shared_ptr<Allocator::Slab> slab)
+    : _max_size(std::numeric_limits<std::size_t>::max()), _curr_size(0), _cas(0), _lru_head(nullptr),
+      _lru_tail(nullptr), _timers(_Now()), _slab(std::move(slab)) {}
+
+HashLRU::HashLRU(const std::string &segment, std::size_t memory_limit)
+    : _max_size(std::numeric_limits<std::size_t>::max()), _curr_size(0), _cas(0), _lru_head(nullptr),
+      _lru_tail(nullptr), _timers(_Now()),
+      _segment(new WarmSegment(segment, memory_limit,
+                               (kWarmLayout << 48) | (uint64_t(sizeof(Item)) << 32) |
+                                   (Allocator::Slab::kDefaultSlabSize >> 12))),
+      _slab(std::make_shared<Allocator::Slab>(_segment->arena(), _segment->arena_size())) {}
+
+HashLRU::~HashLRU() {
+    while (_lru_head) {
+        Item *next = _lru_head->next;
+        _FreeItem(_lru_head);
+        _lru_head = next;
+    }
+}
+
+// See HashLRU.h
+void HashLRU::Start() {
+    if (_segment && _segment->warm()) {
+        _Restore();
+    }
+}
+
+// See HashLRU.h
+void HashLRU::Stop() {
+    if (!_segment) {
+        return;
+    }
+
+    // Index goes from the tail, so that pushing items to the head one by one restores the order
+    const char *arena = static_cast<const char *>(_segment->arena());
+    std::vector<uint64_t> index;
+    index.reserve(_lru_index.size());
+    for (Item *node = _lru_tail; node; node = node->prev) {
+        index.push_back(reinterpret_cast<const char *>(node) - arena);
+    }
+    _segment->MarkClean(index);
+}
+
+// See HashLRU.h
+bool HashLRU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0); }
+
+// See HashLRU.h
+bool HashLRU::PutIfAbsent(const std::string &key, const std::string &value) { return PutIfAbsent(key, value, 0); }
+
+// See HashLRU.h
+bool HashLRU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0); }
+
+// See HashLRU.h
+bool HashLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    KeyRef ref(key);
+    Item *node = _Lookup(ref, now);
+    uint32_t exptime = _Exptime(expire);
+    if (exptime != 0 && exptime <= now) {
+        // Value is never visible, only the old one has to go
+        if (node) {
+            _Remove(node);
+        }
+        return true;
+    }
+
+    if (node) {
+        return _UpdateNode(node, value, exptime);
+    }
+    return _InsertNode(key, value, ref.hash, exptime);
+}
+
+// See HashLRU.h
+bool HashLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    KeyRef ref(key);
+    if (_Lookup(ref, now)) {
+        return false;
+    }
+    uint32_t exptime = _Exptime(expire);
+    if (exptime != 0 && exptime <= now) {
+        return true;
+    }
+    return _InsertNode(key, value, ref.hash, exptime);
+}
+
+// See HashLRU.h
+bool HashLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    if (!node) {
+        return false;
+    }
+    uint32_t exptime = _Exptime(expire);
+    if (exptime != 0 && exptime <= now) {
+        _Remove(node);
+        return true;
+    }
+    return _UpdateNode(node, value, exptime);
+}
+
+// See HashLRU.h
+bool HashLRU::Append(const std::string &key, const std::string &data) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    return node && _ExtendNode(node, data, false);
+}
+
+// See HashLRU.h
+bool HashLRU::Prepend(const std::string &key, const std::string &data) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    return node && _ExtendNode(node, data, true);
+}
+
+// See HashLRU.h
+Storage::IncrResult HashLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    return node ? _IncrementNode(node, delta, false, value) : IncrResult::kNotFound;
+}
+
+// See HashLRU.h
+Storage::IncrResult HashLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    return node ? _IncrementNode(node, delta, true, value) : IncrResult::kNotFound;
+}
+
+// See HashLRU.h
+bool HashLRU::Delete(const std::string &key) { return Delete(KeyRef(key)); }
+
+// See HashLRU.h
+bool HashLRU::Delete(const KeyRef &key) {
+    Item *node = _Lookup(key, _Now());
+    if (!node) {
+        return false;
+    }
+    _Remove(node);
+    return true;
+}
+
+// See HashLRU.h
+bool HashLRU::Get(const std::string &key, std::string &value) { return Get(KeyRef(key), value); }
+
+// See HashLRU.h
+bool HashLRU::Get(const KeyRef &key, std::string &value) {
+    Item *node = _Lookup(key, _Now());
+    if (!node) {
+        return false;
+    }
+    char digits[kCounterDigits];
+    std::size_t size;
+    const char *text = _Text(node, digits, size);
+    value.assign(text, size);
+    _MoveToHead(node);
+    return true;
+}
+
+// See HashLRU.h
+bool HashLRU::View(const std::string &key, const Visitor &visitor) { return View(KeyRef(key), visitor); }
+
+// See HashLRU.h
+bool HashLRU::View(const KeyRef &key, const Visitor &visitor) {
+    Item *node = _Lookup(key, _Now());
+    if (!node) {
+        return false;
+    }
+    char digits[kCounterDigits];
+    std::size_t size;
+    const char *text = _Text(node, digits, size);
+    visitor(text, size);
+    _MoveToHead(node);
+    return true;
+}
+
+// See HashLRU.h
+std::size_t HashLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::vector<KeyRef> refs(keys.begin(), keys.end());
+    return _MultiLookup(refs, [&keys, &visitor](std::size_t i, const Item *node) {
+        char digits[kCounterDigits];
+        std::size_t size;
+        const char *text = _Text(node, digits, size);
+        visitor(keys[i], text, size);
+    });
+}
+
+// See HashLRU.h
+std::size_t HashLRU::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    return _MultiLookup(keys, [&keys, &visitor](std::size_t i, const Item *node) {
+        char digits[kCounterDigits];
+        std::size_t size;
+        const char *text = _Text(node, digits, size);
+        visitor(keys[i], text, size);
+    });
+}
+
+// See HashLRU.h
+std::size_t HashLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::vector<KeyRef> refs(keys.begin(), keys.end());
+    return _MultiLookup(refs, [&keys, &visitor](std::size_t i, const Item *node) {
+        char digits[kCounterDigits];
+        std::size_t size;
+        const char *text = _Text(node, digits, size);
+        visitor(keys[i], text, size, node->cas);
+    });
+}
+
+// See HashLRU.h
+Storage::CasResult HashLRU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                           uint64_t cas) {
+    uint32_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+
+    Item *node = _Lookup(key, now);
+    if (!node) {
+        return CasResult::kNotFound;
+    }
+    if (node->cas != cas) {
+        return CasResult::kExists;
+    }
+    uint32_t exptime = _Exptime(expire);
+    if (exptime != 0 && exptime <= now) {
+        _Remove(node);
+        return CasResult::kStored;
+    }
+    return _UpdateNode(node, value, exptime) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See HashLRU.h
+bool HashLRU::Scan(const Scanner &scanner) {
+    uint32_t now = _Now();
+    char digits[kCounterDigits];
+    for (Item *node = _lru_tail; node; node = node->prev) {
+        if (!node->Expired(now)) {
+            std::size_t size;
+            const char *text = _Text(node, digits, size);
+            scanner(node->Key(), node->key_size, text, size, node->exptime);
+        }
+    }
+    return true;
+}
+
+// See HashLRU.h
+void HashLRU::Reclaim(std::size_t budget) { _Reclaim(_Now(), budget); }
+
+const char *HashLRU::_Text(const Item *node, char *digits, std::size_t &size) {
+    if (!node->counter) {
+        size = node->value_size;
+        return node->Value();
+    }
+
+    uint64_t counter;
+    std::memcpy(&counter, node->Value(), sizeof(counter));
+    char *end = digits + kCounterDigits;
+    char *pos = end;
+    do {
+        *--pos = char('0' + counter % 10);
+        counter /= 10;
+    } while (counter != 0);
+    size = end - pos;
+    return pos;
+}
+
+uint32_t HashLRU::_Now() { return uint32_t(std::time(nullptr)); }
+
+uint32_t HashLRU::_Exptime(std::time_t expire) {
+    if (expire == 0) {
+        return 0;
+    }
+    // Anything before the epoch is long gone, but 0 is taken by "never"
+    if (expire < 0) {
+        return 1;
+    }
+    return uint32_t(std::min<std::time_t>(expire, std::numeric_limits<uint32_t>::max()));
+}
+
+Item *HashLRU::_Find(const KeyRef &key) const {
+    return _lru_index.Find(key.hash, [&key](const Item &node) { return node.KeyEquals(key.data, key.size); });
+}
+
+Item *HashLRU::_Lookup(const KeyRef &key, uint32_t now) {
+    Item *node = _Find(key);
+    if (node && node->Expired(now)) {
+        _Remove(node);
+        return nullptr;
+    }
+    return node;
+}
+
+std::size_t HashLRU::_MultiLookup(const std::vector<KeyRef> &keys,
+                                  const std::function<void(std::size_t i, const Item *node)> &visitor) {
+    // Index slots for the next kPrefetchDistance keys are being loaded while current key is looked up
+    std::size_t ahead = std::min(keys.size(), kPrefetchDistance);
+    for (std::size_t i = 0; i < ahead; ++i) {
+        _lru_index.Prefetch(keys[i].hash);
+    }
+
+    uint32_t now = _Now();
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (i + kPrefetchDistance < keys.size()) {
+            _lru_index.Prefetch(keys[i + kPrefetchDistance].hash);
+        }
+
+        Item *node = _Lookup(keys[i], now);
+        if (node) {
+            visitor(i, node);
+            _MoveToHead(node);
+            found++;
+        }
+    }
+    return found;
+}
+
+void HashLRU::_Reclaim(uint32_t now, std::size_t budget) {
+    _timers.Advance(now, budget, [this, now](const expiry &timer) {
+        // Timer could belong to a node that was removed or got an earlier timer since then
+        Item *node = _lru_index.Find(timer.hash, [&timer](const Item &node) { return node.timer == timer.deadline; });
+        if (node == nullptr) {
+            return;
+        }
+        node->timer = 0;
+        if (node->Expired(now)) {
+            _Remove(node);
+        } else {
+            // Expire time moved forward meanwhile
+            _SetExpire(node, node->exptime);
+        }
+    });
+}
+
+void HashLRU::_SetExpire(Item *node, uint32_t exptime) {
+    // Item has a single pending timer at most: the later one is rescheduled once the earlier fires, so a hot
+    // item which gets a new expire time each second doesn't pile timers up
+    if (exptime != 0 && (node->timer == 0 || exptime < node->timer)) {
+        _timers.Schedule(exptime, expiry{node->hash, exptime});
+        node->timer = exptime;
+    }
+    node->exptime = exptime;
+}
+
+void HashLRU::_Unlink(Item *node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        _lru_head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        _lru_tail = node->prev;
+    }
+    node->prev = node->next = nullptr;
+}
+
+void HashLRU::_PushHead(Item *node) {
+    node->prev = nullptr;
+    node->next = _lru_head;
+    if (_lru_head) {
+        _lru_head->prev = node;
+    } else {
+        _lru_tail = node;
+    }
+    _lru_head = node;
+}
+
+void HashLRU::_MoveToHead(Item *node) {
+    if (node == _lru_head) {
+        return;
+    }
+    _Unlink(node);
+    _PushHead(node);
+}
+
+void HashLRU::_Remove(Item *node) {
+    _Unlink(node);
+    _lru_index.Erase(node->hash, node);
+    _curr_size -= node->Size();
+    _FreeItem(node);
+}
+
+void HashLRU::_DeleteTail(std::size_t new_size) {
+    while (_lru_tail && new_size + _curr_size > _max_size) {
+        _Remove(_lru_tail);
+    }
+}
+
+void HashLRU::_Replace(Item *old_node, Item *node) {
+    // Pending timer finds the copy by hash
+    node->timer = old_node->timer;
+    node->prev = old_node->prev;
+    node->next = old_node->next;
+    if (node->prev) {
+        node->prev->next = node;
+    } else {
+        _lru_head = node;
+    }
+    if (node->next) {
+        node->next->prev = node;
+    } else {
+        _lru_tail = node;
+    }
+
+    _lru_index.Erase(old_node->hash, old_node);
+    _lru_index.Insert(node->hash, node);
+    _FreeItem(old_node);
+}
+
+bool HashLRU::_UpdateNode(Item *node, const std::string &value, uint32_t exptime) {
+    if (node->key_size + value.size() > _max_size) {
+        return false;
+    }
+    _MoveToHead(node);
+    // node is in the head now, so it is the last one to be evicted and it is never evicted because
+    // key + value fits into _max_size
+    if (value.size() > node->value_size) {
+        _DeleteTail(value.size() - node->value_size);
+    }
+
+    // Value is overwritten in place if it fits the same memory, otherwise the whole item gets reallocated
+    bool in_place = value.size() == node->value_size;
+    if (_slab && !in_place) {
+        in_place = _slab->ClassOf(Item::AllocSize(node->key_size, value.size())) == _slab->ClassOf(node);
+    }
+    if (in_place) {
+        _curr_size -= node->value_size;
+        _curr_size += value.size();
+        node->value_size = value.size();
+        node->counter = 0;
+        std::memcpy(node->Value(), value.data(), value.size());
+    } else {
+        Item *replacement = _NewItem(node->Key(), node->key_size, value.data(), value.size(), node->hash, node);
+        if (replacement == nullptr) {
+            return false;
+        }
+        _curr_size -= node->value_size;
+        _curr_size += value.size();
+        _Replace(node, replacement);
+        _SetExpire(replacement, exptime);
+        replacement->cas = ++_cas;
+        return true;
+    }
+    _SetExpire(node, exptime);
+    node->cas = ++_cas;
+    return true;
+}
+
+bool HashLRU::_ExtendNode(Item *node, const std::string &data, bool front) {
+    if (node->counter) {
+        // Data is added to the digits, so counter turns back into text first
+        char digits[kCounterDigits];
+        std::size_t size;
+        const char *text = _Text(node, digits, size);
+        if (!_UpdateNode(node, std::string(text, size), node->exptime)) {
+            return false;
+        }
+        node = _lru_head;
+    }
+
+    std::size_t value_size = node->value_size + data.size();
+    if (node->key_size + value_size > _max_size) {
+        return false;
+    }
+    _MoveToHead(node);
+    // node is in the head now and fits into _max_size, so it is never evicted, see _UpdateNode
+    _DeleteTail(data.size());
+
+    std::size_t size = Item::AllocSize(node->key_size, value_size);
+    if (!_slab && value_size > node->capacity) {
+        // Capacity at least doubles, so a run of appends reallocates log(n) times rather than on each call.
+        // Realloc grows block in place or remaps pages of a big one, either way value isn't copied by hand
+        std::size_t capacity = std::min<std::size_t>(2 * std::size_t(node->capacity), _max_size - node->key_size);
+        capacity = std::max(value_size, std::min<std::size_t>(capacity, std::numeric_limits<uint32_t>::max()));
+        _Unlink(node);
+        _lru_index.Erase(node->hash, node);
+        void *mem = std::realloc(static_cast<void *>(node), Item::AllocSize(node->key_size, capacity));
+        if (mem == nullptr) {
+            _PushHead(node);
+            _lru_index.Insert(node->hash, node);
+            throw std::bad_alloc();
+        }
+        node = static_cast<Item *>(mem);
+        node->capacity = capacity;
+        _PushHead(node);
+        _lru_index.Insert(node->hash, node);
+    } else if (_slab && _slab->ClassOf(size) != _slab->ClassOf(node)) {
+        // Value is copied once per size class it grows through, not on each call
+        void *mem = _AllocItem(size, node);
+        if (mem == nullptr) {
+            return false;
+        }
+        Item *grown = Item::Init(mem, node->Key(), node->key_size, node->Value(), node->value_size, node->hash);
+        grown->exptime = node->exptime;
+        _Replace(node, grown);
+        node = grown;
+    }
+
+    if (front) {
+        std::memmove(node->Value() + data.size(), node->Value(), node->value_size);
+        std::memcpy(node->Value(), data.data(), data.size());
+    } else {
+        std::memcpy(node->Value() + node->value_size, data.data(), data.size());
+    }
+    node->value_size = value_size;
+    node->cas = ++_cas;
+    _curr_size += data.size();
+    return true;
+}
+
+Storage::IncrResult HashLRU::_IncrementNode(Item *node, uint64_t delta, bool decrement, uint64_t &value) {
+    if (node->counter) {
+        uint64_t counter;
+        std::memcpy(&counter, node->Value(), sizeof(counter));
+        value = _AddDelta(counter, delta, decrement);
+        std::memcpy(node->Value(), &value, sizeof(value));
+        node->cas = ++_cas;
+        _MoveToHead(node);
+        return IncrResult::kUpdated;
+    }
+
+    if (!_ApplyDelta(node->Value(), node->value_size, delta, decrement, value)) {
+        return IncrResult::kNotNumber;
+    }
+    // From now on counter is changed right in the item, without parsing and printing digits each time
+    if (!_UpdateNode(node, std::string(reinterpret_cast<const char *>(&value), sizeof(value)), node->exptime)) {
+        return IncrResult::kNotStored;
+    }
+    _lru_head->counter = 1;
+    return IncrResult::kUpdated;
+}
+
+bool HashLRU::_InsertNode(const std::string &key, const std::string &value, uint64_t hash, uint32_t exptime) {
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    _DeleteTail(key.size() + value.size());
+    Item *node = _NewItem(key.data(), key.size(), value.data(), value.size(), hash, nullptr);
+    if (node == nullptr) {
+        return false;
+    }
+    _SetExpire(node, exptime);
+    node->cas = ++_cas;
+    _PushHead(node);
+    _lru_index.Insert(hash, node);
+    _curr_size += key.size() + value.size();
+    return true;
+}
+
+void *HashLRU::_AllocItem(std::size_t size, const Item *keep) {
+    if (!_slab) {
+        void *mem = std::malloc(size);
+        if (mem == nullptr) {
+            throw std::bad_alloc();
+        }
+        return mem;
+    }
+
+    std::size_t cls = _slab->ClassOf(size);
+    if (cls == Allocator::Slab::kNoClass) {
+        return nullptr;
+    }
+
+    // Memory ceiling reached: only an item of the same size class frees a chunk the new one fits into
+    void *mem = _slab->Allocate(size);
+    bool moved = false;
+    while (mem == nullptr) {
+        Item *victim = _lru_tail;
+        for (std::size_t depth = 0; victim && depth < kEvictDepth; ++depth, victim = victim->prev) {
+            if (victim != keep && _slab->ClassOf(victim) == cls) {
+                break;
+            }
+        }
+        if (victim && victim != keep && _slab->ClassOf(victim) == cls) {
+            _Remove(victim);
+        } else if (moved || !_MoveSlab(keep)) {
+            return nullptr;
+        } else {
+            // Class has a free slab now, the same is not tried twice for a single item
+            moved = true;
+        }
+        mem = _slab->Allocate(size);
+    }
+    return mem;
+}
+
+bool HashLRU::_MoveSlab(const Item *keep) {
+    // Slab of the least recently used item is emptied, whatever class it is of
+    Item *tail = _lru_tail;
+    while (tail && tail == keep) {
+        tail = tail->prev;
+    }
+    if (tail == nullptr) {
+        return false;
+    }
+    void *slab = _slab->SlabOf(tail);
+    if (keep && _slab->SlabOf(keep) == slab) {
+        return false;
+    }
+
+    for (Item *node = _lru_tail; node;) {
+        Item *prev = node->prev;
+        if (_slab->SlabOf(node) == slab) {
+            _Remove(node);
+        }
+        node = prev;
+    }
+    return _slab->Release(slab);
+}
+
+Item *HashLRU::_NewItem(const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                        uint64_t hash, const Item *keep) {
+    void *mem = _AllocItem(Item::AllocSize(key_size, value_size), keep);
+    if (mem == nullptr) {
+        return nullptr;
+    }
+    return Item::Init(mem, key, key_size, value, value_size, hash);
+}
+
+void HashLRU::_FreeItem(Item *node) {
+    if (_slab) {
+        _slab->Free(node);
+    } else {
+        Item::Destroy(node);
+    }
+}
+
+void HashLRU::_Restore() {
+    std::vector<uint64_t> index = _segment->TakeIndex();
+    char *arena = static_cast<char *>(_segment->arena());
+    std::size_t arena_size = _segment->arena_size();
+    uint32_t now = _Now();
+
+    // Expired and duplicate items are left out, so their chunks become free
+    std::vector<Allocator::Slab::Chunk> chunks;
+    chunks.reserve(index.size());
+    bool valid = true;
+    for (uint64_t offset : index) {
+        if (offset > arena_size - sizeof(Item)) {
+            valid = false;
+            break;
+        }
+        Item *node = reinterpret_cast<Item *>(arena + offset);
+        std::size_t size = Item::AllocSize(node->key_size, node->value_size);
+        if (size > arena_size - offset) {
+            valid = false;
+            break;
+        }
+
+        // Hash function could be different in the new binary
+        KeyRef key(node->Key(), node->key_size);
+        node->hash = key.hash;
+        if (node->Expired(now) || _Find(key)) {
+            continue;
+        }
+        _PushHead(node);
+        _lru_index.Insert(node->hash, node);
+        _curr_size += node->Size();
+        _cas = std::max(_cas, node->cas);
+        chunks.push_back(Allocator::Slab::Chunk{node, size});
+    }
+
+    if (!valid || !_slab->Restore(chunks)) {
+        // Index doesn't match the arena, nothing could be trusted
+        _lru_index.Clear();
+        _lru_head = _lru_tail = nullptr;
+        _curr_size = 0;
+        _cas = 0;
+        return;
+    }
+    // Timers of the previous storage are gone with it
+    for (Item *node = _lru_tail; node; node = node->prev) {
+        node->timer = 0;
+        _SetExpire(node, node->exptime);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
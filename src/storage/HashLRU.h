@@ -0,0 +1,252 @@
+#ifndef AFINA_STORAGE_HASH_LRU_H
+#define AFINA_STORAGE_HASH_LRU_H
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Slab.h>
+
+#include "HashIndex.h"
+#include "Item.h"
+#include "TimerWheel.h"
+#include "WarmSegment.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash index based implementation
+ * Same LRU policy as SimpleLRU, but nodes are looked up through open addressing HashIndex instead of
+ * std::map, so every operation costs O(1) probes over a flat array instead of O(log n) string
+ * comparisons spread over the heap. Each node is a single allocation Item, see Item.h
+ *
+ * Items could have expire time kept right in the Item header. Expired item is dropped lazily by the
+ * first access that finds it, and actively by the TimerWheel: each mutating call advances it by a few
+ * steps and frees items which are due, so memory of expired items that nobody asks for is reclaimed
+ * without a full scan and without latency spikes.
+ *
+ * Counter changed by Increment/Decrement is kept in the item as binary uint64_t, so the next changes are
+ * done in place without parsing and printing digits. Readers still get decimal text.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class HashLRU : public Afina::Storage {
+public:
+    HashLRU(size_t max_size = 1024);
+
+    /**
+     * Items are allocated from the given slab allocator instead of malloc, so the memory limit is the hard
+     * ceiling of the allocator, with all the overheads counted. Once it is reached, the least recently used
+     * item of the same size class as the new one is evicted, see Allocator::Slab. If there is none near the
+     * LRU tail, the slab of the tail item is emptied and moved to the class of the new item. Allocator could
+     * be shared by several storages, but slabs holding items of another storage never move
+     */
+    HashLRU(std::shared_ptr<Allocator::Slab> slab);
+
+    /**
+     * Same as above, but slab allocator takes memory_limit bytes from the named shared memory segment that
+     * outlives the process, see WarmSegment. Stop leaves index of all items in the segment, and Start of the
+     * next process with the same segment picks them up with their LRU order instead of starting empty. So
+     * restart of the server costs a pass over the index rather than the whole cache warm up
+     *
+     * Storage must not be changed after Stop
+     */
+    HashLRU(const std::string &segment, std::size_t memory_limit);
+    ~HashLRU();
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    /**
+     * Frees expired items found by the timer wheel making at most budget steps of it. Mutating calls
+     * do the same with kReclaimBudget, owner could call it in idle time to reclaim memory faster
+     */
+    void Reclaim(std::size_t budget);
+
+private:
+    // How many keys ahead MultiView prefetches index slots
+    static constexpr std::size_t kPrefetchDistance = 8;
+
+    // Timer wheel steps made by each mutating call
+    static constexpr std::size_t kReclaimBudget = 4;
+
+    // How many items from the LRU tail are checked for the right size class when allocator is full
+    static constexpr std::size_t kEvictDepth = 32;
+
+    // Version of the items layout in WarmSegment, must change along with Item and slab geometry
+    static constexpr uint64_t kWarmLayout = 5;
+
+    // Timer of the item, it is the one pending for the item with that hash whose Item#timer is the deadline.
+    // So item replaced by a copy keeps its timer, and timers of removed items match nothing
+    struct expiry {
+        uint64_t hash;
+        uint32_t deadline;
+    };
+
+    static uint32_t _Now();
+
+    // Returns value of the node as text, counter is printed into digits buffer of kCounterDigits bytes
+    static const char *_Text(const Item *node, char *digits, std::size_t &size);
+
+    // Converts Storage expire time into Item#exptime
+    static uint32_t _Exptime(std::time_t expire);
+
+    Item *_Find(const KeyRef &key) const;
+
+    // Same as _Find, but expired node is removed and never returned
+    Item *_Lookup(const KeyRef &key, uint32_t now);
+
+    // Looks up all the keys prefetching index ahead, calls visitor with position of each key found and its node,
+    // then moves the node to the head
+    std::size_t _MultiLookup(const std::vector<KeyRef> &keys,
+                             const std::function<void(std::size_t i, const Item *node)> &visitor);
+
+    void _Reclaim(uint32_t now, std::size_t budget);
+
+    void _SetExpire(Item *node, uint32_t exptime);
+
+    void _Unlink(Item *node);
+
+    void _PushHead(Item *node);
+
+    void _MoveToHead(Item *node);
+
+    void _Remove(Item *node);
+
+    // Evicts nodes from the tail until there is room for new_size more bytes
+    void _DeleteTail(std::size_t new_size);
+
+    // Puts node into the place of old one both in the list and in the index, old node gets destroyed
+    void _Replace(Item *old_node, Item *node);
+
+    bool _UpdateNode(Item *node, const std::string &value, uint32_t exptime);
+
+    bool _InsertNode(const std::string &key, const std::string &value, uint64_t hash, uint32_t exptime);
+
+    // Adds data to the end or to the front of the node value
+    bool _ExtendNode(Item *node, const std::string &data, bool front);
+
+    // Changes counter of the node, the first change turns decimal value into binary counter, see Item#counter
+    IncrResult _IncrementNode(Item *node, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Allocates memory for item of the given size evicting others if needed, but never the keep one. Returns
+    // nullptr if there is no room
+    void *_AllocItem(std::size_t size, const Item *keep);
+
+    // Evicts all items of the slab the least recently used item lives in, but not the keep one, and gives the
+    // slab back to the allocator, so that a size class without free chunks could take it. That is a pass over
+    // the whole list, done only once memory ceiling is reached and the LRU tail has no item of the right class
+    bool _MoveSlab(const Item *keep);
+
+    // Same as _AllocItem, but builds item there
+    Item *_NewItem(const char *key, std::size_t key_size, const char *value, std::size_t value_size, uint64_t hash,
+                   const Item *keep);
+
+    void _FreeItem(Item *node);
+
+    // Picks up items left in the warm segment by the previous process
+    void _Restore();
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be not greater than the _max_size
+    std::size_t _max_size;
+    std::size_t _curr_size;
+
+    // The last version given to a value
+    uint64_t _cas;
+
+    // Most recently used node
+    Item *_lru_head;
+
+    // Least recently used node, the first one to be evicted
+    Item *_lru_tail;
+
+    // Index of nodes from list above, allows fast random access to elements by Item#Key
+    HashIndex<Item> _lru_index;
+
+    // Items with expire time, by their Item#exptime
+    TimerWheel<expiry> _timers;
+
+    // Shared memory items are allocated from if storage is restartable
+    std::unique_ptr<WarmSegment> _segment;
+
+    // Allocator of items, malloc is used if there is none
+    std::shared_ptr<Allocator::Slab> _slab;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_LRU_H
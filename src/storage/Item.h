@@ -0,0 +1,116 @@
+#ifndef AFINA_STORAGE_ITEM_H
+#define AFINA_STORAGE_ITEM_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Cache item
+ * Header, key bytes and value bytes live in one contiguous allocation:
+ *
+ * +------+------+------+-----+----------+------------+----------+---------+-------+---------+-----+-------+
+ * | prev | next | hash | cas | key_size | value_size | capacity | exptime | timer | counter | key | value |
+ * +------+------+------+-----+----------+------------+----------+---------+-------+---------+-----+-------+
+ *
+ * Links are intrusive, so an item is the LRU list node itself, and a lookup that hits touches one or two
+ * cache lines: header together with the key to compare, and then the value to copy out.
+ *
+ * Items are created and destroyed only through Create/Destroy, or built by Init in memory that came from
+ * some other allocator
+ */
+struct Item {
+    Item *prev;
+    Item *next;
+    uint64_t hash;
+
+    // Version of the value, see Storage::CompareAndSwap
+    uint64_t cas;
+
+    uint32_t key_size;
+    uint32_t value_size;
+
+    // Value bytes the allocation has room for, appends grow it ahead of value_size so they don't realloc each time
+    uint32_t capacity;
+
+    // Unix time item expires at, 0 if it never does
+    uint32_t exptime;
+
+    // Deadline of the item timer pending in the owner's TimerWheel, 0 if there is none
+    uint32_t timer;
+
+    // Non zero if value is a counter kept as binary uint64_t rather than decimal digits
+    uint32_t counter;
+
+    char *Key() { return reinterpret_cast<char *>(this + 1); }
+    const char *Key() const { return reinterpret_cast<const char *>(this + 1); }
+
+    char *Value() { return Key() + key_size; }
+    const char *Value() const { return Key() + key_size; }
+
+    // Number of payload bytes accounted against storage limits
+    std::size_t Size() const { return std::size_t(key_size) + value_size; }
+
+    bool Expired(uint32_t now) const { return exptime != 0 && exptime <= now; }
+
+    bool KeyEquals(const char *key, std::size_t size) const {
+        return size == key_size && std::memcmp(Key(), key, key_size) == 0;
+    }
+
+    // Number of bytes item with the given key and value occupies
+    static std::size_t AllocSize(std::size_t key_size, std::size_t value_size) {
+        return sizeof(Item) + key_size + value_size;
+    }
+
+    /**
+     * Builds new unlinked item holding copy of the given key/value pair in memory of AllocSize bytes
+     */
+    static Item *Init(void *mem, const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                      uint64_t hash) {
+        Item *item = static_cast<Item *>(mem);
+        item->prev = item->next = nullptr;
+        item->hash = hash;
+        item->cas = 0;
+        item->key_size = key_size;
+        item->value_size = value_size;
+        item->capacity = value_size;
+        item->exptime = 0;
+        item->timer = 0;
+        item->counter = 0;
+        std::memcpy(item->Key(), key, key_size);
+        std::memcpy(item->Value(), value, value_size);
+        return item;
+    }
+
+    /**
+     * Allocates new unlinked item holding copy of the given key/value pair
+     */
+    static Item *Create(const char *key, std::size_t key_size, const char *value, std::size_t value_size,
+                        uint64_t hash) {
+        void *mem = std::malloc(AllocSize(key_size, value_size));
+        if (mem == nullptr) {
+            throw std::bad_alloc();
+        }
+        return Init(mem, key, key_size, value, value_size, hash);
+    }
+
+    static Item *Create(const std::string &key, const std::string &value, uint64_t hash) {
+        return Create(key.data(), key.size(), value.data(), value.size(), hash);
+    }
+
+    static void Destroy(Item *item) { std::free(item); }
+
+private:
+    Item() = delete;
+    ~Item() = delete;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ITEM_H
@@ -0,0 +1,52 @@
+#ifndef AFINA_STORAGE_KEY_HASH_H
+#define AFINA_STORAGE_KEY_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <afina/KeyRef.h>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+// Keys are hashed by HashKey, see afina/KeyRef.h
+using Afina::HashKey;
+
+/**
+ * CRC32C (Castagnoli) of the given bytes, continues from crc of the preceding ones, 0 to start. Hardware
+ * one with SSE 4.2, bitwise otherwise. Used to check data written to disk
+ */
+inline uint32_t Crc32c(uint32_t crc, const char *data, std::size_t size) {
+    crc = ~crc;
+#ifdef __SSE4_2__
+    uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = uint32_t(crc64);
+    for (; size > 0; ++data, --size) {
+        crc = _mm_crc32_u8(crc, uint8_t(*data));
+    }
+#else
+    for (; size > 0; ++data, --size) {
+        crc ^= uint8_t(*data);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+        }
+    }
+#endif
+    return ~crc;
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_KEY_HASH_H
@@ -0,0 +1,539 @@
+#include "LockFreeHash.h"
+
+#include <functional>
+
+namespace Afina {
+namespace Backend {
+
+static std::size_t BucketCount(std::size_t max_size, std::size_t bytes_per_bucket) {
+    std::size_t count = 16;
+    while (count < max_size / bytes_per_bucket && count < (std::size_t(1) << 30)) {
+        count *= 2;
+    }
+    return count;
+}
+
+LockFreeHash::LockFreeHash(size_t max_size)
+    : _max_size(max_size), _curr_size(0), _cas(0),
+      _buckets(new std::atomic<uintptr_t>[BucketCount(max_size, kBytesPerBucket)]),
+      _mask(BucketCount(max_size, kBytesPerBucket) - 1), _hand(0) {
+    for (std::size_t i = 0; i <= _mask; ++i) {
+        _buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+LockFreeHash::~LockFreeHash() {
+    for (std::size_t i = 0; i <= _mask; ++i) {
+        uintptr_t curr = _buckets[i].load(std::memory_order_relaxed);
+        while (curr) {
+            table_node *node = reinterpret_cast<table_node *>(curr);
+            curr = node->next.load(std::memory_order_relaxed) & ~uintptr_t(1);
+            delete node;
+        }
+    }
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Put(const std::string &key, const std::string &value) { return Put(key, value, 0); }
+
+// See LockFreeHash.h
+bool LockFreeHash::PutIfAbsent(const std::string &key, const std::string &value) {
+    return PutIfAbsent(key, value, 0);
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Set(const std::string &key, const std::string &value) { return Set(key, value, 0); }
+
+// See LockFreeHash.h
+bool LockFreeHash::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    if (expire != 0 && expire <= _Now()) {
+        // Value is never visible, only the old one has to go
+        Delete(ref);
+        return true;
+    }
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    Epoch::Guard guard(_epoch);
+    while (true) {
+        table_node *node = _Find(guard, ref, nullptr);
+        if (node == nullptr) {
+            _Evict(guard, key.size() + value.size(), nullptr);
+            node = _Insert(guard, key, value, ref.hash, expire);
+            if (node == nullptr) {
+                return true;
+            }
+        }
+
+        // Node could be deleted right under our feet, then start over
+        if (_Replace(guard, node, value, expire)) {
+            return true;
+        }
+    }
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    Epoch::Guard guard(_epoch);
+    if (_Find(guard, ref, nullptr)) {
+        return false;
+    }
+    if (expire != 0 && expire <= _Now()) {
+        return true;
+    }
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    _Evict(guard, key.size() + value.size(), nullptr);
+    return _Insert(guard, key, value, ref.hash, expire) == nullptr;
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    if (expire != 0 && expire <= _Now()) {
+        return Delete(ref);
+    }
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+
+    Epoch::Guard guard(_epoch);
+    while (true) {
+        table_node *node = _Find(guard, ref, nullptr);
+        if (node == nullptr) {
+            return false;
+        }
+        if (_Replace(guard, node, value, expire)) {
+            return true;
+        }
+    }
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Append(const std::string &key, const std::string &data) { return _Extend(key, data, false); }
+
+// See LockFreeHash.h
+bool LockFreeHash::Prepend(const std::string &key, const std::string &data) { return _Extend(key, data, true); }
+
+// See LockFreeHash.h
+Storage::IncrResult LockFreeHash::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, false, value);
+}
+
+// See LockFreeHash.h
+Storage::IncrResult LockFreeHash::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, true, value);
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Delete(const std::string &key) { return Delete(KeyRef(key)); }
+
+// See LockFreeHash.h
+bool LockFreeHash::Delete(const KeyRef &key) {
+    Epoch::Guard guard(_epoch);
+    while (true) {
+        table_node *node = _Find(guard, key, nullptr);
+        if (node == nullptr) {
+            return false;
+        }
+        if (_Remove(guard, node)) {
+            return true;
+        }
+    }
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Get(const std::string &key, std::string &value) {
+    return View(key, [&value](const char *data, std::size_t size) { value.assign(data, size); });
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Get(const KeyRef &key, std::string &value) {
+    return View(key, [&value](const char *data, std::size_t size) { value.assign(data, size); });
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::View(const std::string &key, const Visitor &visitor) { return View(KeyRef(key), visitor); }
+
+// See LockFreeHash.h
+bool LockFreeHash::View(const KeyRef &key, const Visitor &visitor) {
+    Epoch::Guard guard(_epoch);
+    table_value *value = _Lookup(guard, key);
+    if (value == nullptr) {
+        return false;
+    }
+    visitor(value->data.data(), value->data.size());
+    return true;
+}
+
+// See LockFreeHash.h
+std::size_t LockFreeHash::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [&visitor](const std::string &key, const char *value, std::size_t size, uint64_t) {
+            visitor(key, value, size);
+        });
+    }
+    return found;
+}
+
+// See LockFreeHash.h
+std::size_t LockFreeHash::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    Epoch::Guard guard(_epoch);
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        table_value *value = _Lookup(guard, key);
+        if (value != nullptr) {
+            visitor(key, value->data.data(), value->data.size());
+            found++;
+        }
+    }
+    return found;
+}
+
+// See LockFreeHash.h
+std::size_t LockFreeHash::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, visitor);
+    }
+    return found;
+}
+
+// See LockFreeHash.h
+Storage::CasResult LockFreeHash::CompareAndSwap(const std::string &key, const std::string &value,
+                                                std::time_t expire, uint64_t cas) {
+    KeyRef ref(key);
+    Epoch::Guard guard(_epoch);
+    table_node *node = _Find(guard, ref, nullptr);
+    if (node == nullptr) {
+        return CasResult::kNotFound;
+    }
+    table_value *old = node->value.load(std::memory_order_acquire);
+    if (old == nullptr) {
+        return CasResult::kNotFound;
+    }
+    if (old->cas != cas) {
+        return CasResult::kExists;
+    }
+    if (expire != 0 && expire <= _Now()) {
+        // Value is never visible, so the swap only takes the old one away
+        if (!_Take(guard, node, old)) {
+            return old == nullptr ? CasResult::kNotFound : CasResult::kExists;
+        }
+        _Find(guard, ref, nullptr);
+        return CasResult::kStored;
+    }
+    if (key.size() + value.size() > _max_size) {
+        return CasResult::kNotStored;
+    }
+    if (value.size() > old->data.size()) {
+        _Evict(guard, value.size() - old->data.size(), node);
+    }
+
+    // Version can't come back, so single CAS fails if value was replaced or deleted since it was checked
+    table_value *fresh = _NewValue(value, expire);
+    _curr_size.fetch_add(value.size(), std::memory_order_relaxed);
+    if (!node->value.compare_exchange_strong(old, fresh, std::memory_order_acq_rel)) {
+        _curr_size.fetch_sub(value.size(), std::memory_order_relaxed);
+        delete fresh;
+        return old == nullptr ? CasResult::kNotFound : CasResult::kExists;
+    }
+    node->referenced.store(true, std::memory_order_relaxed);
+    _curr_size.fetch_sub(old->data.size(), std::memory_order_relaxed);
+    guard.Retire(old, _DeleteValue);
+    return CasResult::kStored;
+}
+
+// See LockFreeHash.h
+bool LockFreeHash::Scan(const Scanner &scanner) {
+    // Structure is consistent at any moment, so a forked copy could be walked as is
+    std::time_t now = _Now();
+    for (std::size_t i = 0; i <= _mask; ++i) {
+        uintptr_t curr = _buckets[i].load(std::memory_order_acquire);
+        while (curr) {
+            table_node *node = reinterpret_cast<table_node *>(curr);
+            table_value *value = node->value.load(std::memory_order_acquire);
+            if (value && !value->Expired(now)) {
+                scanner(node->key.data(), node->key.size(), value->data.data(), value->data.size(), value->expire);
+            }
+            curr = node->next.load(std::memory_order_acquire) & ~uintptr_t(1);
+        }
+    }
+    return true;
+}
+
+// See LockFreeHash.h
+void LockFreeHash::Report(const Reporter &reporter) {
+    Stats stats = GetStats();
+    reporter("bytes", stats.size);
+    reporter("limit_maxbytes", stats.max_size);
+    reporter("get_hits", stats.hits);
+    reporter("get_misses", stats.misses);
+    reporter("evictions", stats.evictions);
+}
+
+// See LockFreeHash.h
+LockFreeHash::Stats LockFreeHash::GetStats() const {
+    return Stats{_curr_size.load(std::memory_order_relaxed), _max_size, _hits.Sum(), _misses.Sum(),
+                 _evictions.Sum()};
+}
+
+void LockFreeHash::_DeleteNode(void *node) { delete static_cast<table_node *>(node); }
+
+void LockFreeHash::_DeleteValue(void *value) { delete static_cast<table_value *>(value); }
+
+std::time_t LockFreeHash::_Now() { return std::time(nullptr); }
+
+LockFreeHash::table_value *LockFreeHash::_NewValue(std::string data, std::time_t expire) {
+    return new table_value(std::move(data), _cas.fetch_add(1, std::memory_order_relaxed) + 1, expire);
+}
+
+bool LockFreeHash::_View(const std::string &key, const CasVisitor &visitor) {
+    Epoch::Guard guard(_epoch);
+    table_value *value = _Lookup(guard, key);
+    if (value == nullptr) {
+        return false;
+    }
+    visitor(key, value->data.data(), value->data.size(), value->cas);
+    return true;
+}
+
+LockFreeHash::table_value *LockFreeHash::_Lookup(Epoch::Guard &guard, const KeyRef &key) {
+    table_node *node = _Find(guard, key, nullptr);
+    table_value *value = node ? node->value.load(std::memory_order_acquire) : nullptr;
+    if (value == nullptr) {
+        _misses.Add();
+        return nullptr;
+    }
+    _hits.Add();
+
+    // Don't dirty cache line of the hot node on each hit
+    if (!node->referenced.load(std::memory_order_relaxed)) {
+        node->referenced.store(true, std::memory_order_relaxed);
+    }
+    return value;
+}
+
+LockFreeHash::table_node *LockFreeHash::_Find(Epoch::Guard &guard, const KeyRef &key, uintptr_t *head) {
+    std::atomic<uintptr_t> &bucket = _Bucket(key.hash);
+retry:
+    std::atomic<uintptr_t> *prev = &bucket;
+    uintptr_t first = bucket.load(std::memory_order_acquire);
+    uintptr_t curr = first;
+    while (curr) {
+        table_node *node = reinterpret_cast<table_node *>(curr);
+        uintptr_t next = node->next.load(std::memory_order_acquire);
+        if (next & 1) {
+            // Node is removed, unlink it. Failure means prev changed or got removed itself
+            uintptr_t expected = curr;
+            if (!prev->compare_exchange_strong(expected, next & ~uintptr_t(1), std::memory_order_acq_rel)) {
+                goto retry;
+            }
+            guard.Retire(node, _DeleteNode);
+            if (prev == &bucket) {
+                first = next & ~uintptr_t(1);
+            }
+            curr = next & ~uintptr_t(1);
+            continue;
+        }
+
+        if (node->hash == key.hash && key == node->key) {
+            table_value *value = node->value.load(std::memory_order_acquire);
+            if (value != nullptr && value->expire != 0 && value->Expired(_Now())) {
+                // Whether it is taken by us or replaced by someone else, the next pass sees the outcome
+                _Take(guard, node, value);
+                goto retry;
+            }
+            if (value != nullptr) {
+                return node;
+            }
+        }
+        prev = &node->next;
+        curr = next;
+    }
+
+    if (head) {
+        *head = first;
+    }
+    return nullptr;
+}
+
+bool LockFreeHash::_Take(Epoch::Guard &guard, table_node *node, table_value *&value) {
+    if (!node->value.compare_exchange_strong(value, nullptr, std::memory_order_acq_rel)) {
+        return false;
+    }
+    _curr_size.fetch_sub(node->key.size() + value->data.size(), std::memory_order_relaxed);
+    guard.Retire(value, _DeleteValue);
+
+    uintptr_t next = node->next.load(std::memory_order_relaxed);
+    while (!(next & 1) && !node->next.compare_exchange_weak(next, next | 1, std::memory_order_acq_rel)) {
+    }
+    return true;
+}
+
+bool LockFreeHash::_Remove(Epoch::Guard &guard, table_node *node) {
+    table_value *value = node->value.load(std::memory_order_acquire);
+    while (value != nullptr && !_Take(guard, node, value)) {
+    }
+    if (value == nullptr) {
+        return false;
+    }
+
+    // Unlink it now unless a newer node of the same key is found first, then somebody else does that later
+    _Find(guard, KeyRef(node->key.data(), node->key.size(), node->hash), nullptr);
+    return true;
+}
+
+bool LockFreeHash::_Replace(Epoch::Guard &guard, table_node *node, const std::string &value,
+                            std::time_t expire) {
+    table_value *old = node->value.load(std::memory_order_acquire);
+    if (old == nullptr) {
+        return false;
+    }
+    if (value.size() > old->data.size()) {
+        _Evict(guard, value.size() - old->data.size(), node);
+    }
+
+    table_value *fresh = _NewValue(value, expire);
+    _curr_size.fetch_add(value.size(), std::memory_order_relaxed);
+    do {
+        if (old == nullptr) {
+            _curr_size.fetch_sub(value.size(), std::memory_order_relaxed);
+            delete fresh;
+            return false;
+        }
+    } while (!node->value.compare_exchange_weak(old, fresh, std::memory_order_acq_rel));
+
+    node->referenced.store(true, std::memory_order_relaxed);
+    _curr_size.fetch_sub(old->data.size(), std::memory_order_relaxed);
+    guard.Retire(old, _DeleteValue);
+    return true;
+}
+
+bool LockFreeHash::_Extend(const std::string &key, const std::string &data, bool front) {
+    KeyRef ref(key);
+    Epoch::Guard guard(_epoch);
+    while (true) {
+        table_node *node = _Find(guard, ref, nullptr);
+        if (node == nullptr) {
+            return false;
+        }
+        table_value *old = node->value.load(std::memory_order_acquire);
+        if (old == nullptr) {
+            continue;
+        }
+        if (key.size() + old->data.size() + data.size() > _max_size) {
+            return false;
+        }
+        _Evict(guard, data.size(), node);
+
+        // Readers never lock, so published value is immutable and the extended one is built aside. Appends
+        // racing for the node are never lost: CAS fails unless value is still the one that was extended
+        std::string extended;
+        extended.reserve(old->data.size() + data.size());
+        extended.append(front ? data : old->data).append(front ? old->data : data);
+        table_value *fresh = _NewValue(std::move(extended), old->expire);
+        _curr_size.fetch_add(data.size(), std::memory_order_relaxed);
+        if (node->value.compare_exchange_strong(old, fresh, std::memory_order_acq_rel)) {
+            node->referenced.store(true, std::memory_order_relaxed);
+            guard.Retire(old, _DeleteValue);
+            return true;
+        }
+        _curr_size.fetch_sub(data.size(), std::memory_order_relaxed);
+        delete fresh;
+    }
+}
+
+Storage::IncrResult LockFreeHash::_Increment(const std::string &key, uint64_t delta, bool decrement,
+                                             uint64_t &value) {
+    KeyRef ref(key);
+    Epoch::Guard guard(_epoch);
+    while (true) {
+        table_node *node = _Find(guard, ref, nullptr);
+        if (node == nullptr) {
+            return IncrResult::kNotFound;
+        }
+        table_value *old = node->value.load(std::memory_order_acquire);
+        if (old == nullptr) {
+            continue;
+        }
+        if (!_ApplyDelta(old->data.data(), old->data.size(), delta, decrement, value)) {
+            return IncrResult::kNotNumber;
+        }
+
+        table_value *fresh = _NewValue(std::to_string(value), old->expire);
+        if (fresh->data.size() > old->data.size()) {
+            _Evict(guard, fresh->data.size() - old->data.size(), node);
+        }
+        _curr_size.fetch_add(fresh->data.size(), std::memory_order_relaxed);
+        if (node->value.compare_exchange_strong(old, fresh, std::memory_order_acq_rel)) {
+            node->referenced.store(true, std::memory_order_relaxed);
+            _curr_size.fetch_sub(old->data.size(), std::memory_order_relaxed);
+            guard.Retire(old, _DeleteValue);
+            return IncrResult::kUpdated;
+        }
+        _curr_size.fetch_sub(fresh->data.size(), std::memory_order_relaxed);
+        delete fresh;
+    }
+}
+
+void LockFreeHash::_Evict(Epoch::Guard &guard, std::size_t size, const table_node *keep) {
+    // Each round clears all reference bits, so the second one finds victims unless table is empty
+    std::time_t now = _Now();
+    std::size_t budget = kEvictRounds * (_mask + 1);
+    while (_curr_size.load(std::memory_order_relaxed) + size > _max_size && budget-- > 0) {
+        std::size_t idx = _hand.fetch_add(1, std::memory_order_relaxed) & _mask;
+        uintptr_t curr = _buckets[idx].load(std::memory_order_acquire);
+        while (curr && _curr_size.load(std::memory_order_relaxed) + size > _max_size) {
+            table_node *node = reinterpret_cast<table_node *>(curr);
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            if (!(next & 1) && node != keep) {
+                // Expired node goes first, it isn't counted as eviction
+                table_value *value = node->value.load(std::memory_order_acquire);
+                bool expired = value != nullptr && value->Expired(now);
+                if (!expired && node->referenced.load(std::memory_order_relaxed)) {
+                    node->referenced.store(false, std::memory_order_relaxed);
+                } else if (_Remove(guard, node) && !expired) {
+                    _evictions.Add();
+                }
+            }
+            curr = next & ~uintptr_t(1);
+        }
+    }
+}
+
+LockFreeHash::table_node *LockFreeHash::_Insert(Epoch::Guard &guard, const std::string &key,
+                                                const std::string &value, uint64_t hash, std::time_t expire) {
+    std::atomic<uintptr_t> &bucket = _Bucket(hash);
+    table_node *node = nullptr;
+    while (true) {
+        uintptr_t head;
+        table_node *found = _Find(guard, KeyRef(key.data(), key.size(), hash), &head);
+        if (found) {
+            delete node;
+            return found;
+        }
+
+        // Any insert into the bucket changes its head, so CAS fails if the same key was added meanwhile
+        if (node == nullptr) {
+            node = new table_node(key, _NewValue(value, expire), hash);
+        }
+        node->next.store(head, std::memory_order_relaxed);
+
+        // Size goes up before node is visible, so that concurrent removal never takes it below zero
+        _curr_size.fetch_add(key.size() + value.size(), std::memory_order_relaxed);
+        if (bucket.compare_exchange_weak(head, reinterpret_cast<uintptr_t>(node), std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        _curr_size.fetch_sub(key.size() + value.size(), std::memory_order_relaxed);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,239 @@
+#ifndef AFINA_STORAGE_LOCK_FREE_HASH_H
+#define AFINA_STORAGE_LOCK_FREE_HASH_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+#include <afina/concurrency/CoreLocal.h>
+
+#include "Epoch.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Lock-free hash table with CLOCK eviction
+ * Fixed array of buckets, each one is a lock-free singly linked list (Harris list: node is removed by
+ * marking its next link first, and unlinked by whoever walks by next). New nodes are pushed to the bucket
+ * head with a CAS on the head seen by the search, so two concurrent inserts of the same key can't both
+ * succeed. Values are swapped in place by CAS on the node value pointer, nullptr value means the node was
+ * deleted and is going away. Published value never changes and carries its version, so CompareAndSwap is
+ * the same pointer CAS guarded by a check of the version. Removed nodes and replaced values are freed
+ * through Epoch, so readers never take a lock and never wait for writers.
+ *
+ * Bucket count is derived from max_size and doesn't change, there is no resize.
+ *
+ * Eviction is an approximate CLOCK: each hit raises the node reference bit, and writer that needs room
+ * sweeps buckets one by one from the shared hand, clearing bits of referenced nodes and evicting the rest.
+ * Concurrent writers sweep different buckets, so total size could briefly go a bit over max_size, by at
+ * most the size of entries being inserted at the moment.
+ *
+ * Expire time is a part of the published value. Lookup that meets expired value takes it away the same
+ * way Delete does, and the clock hand evicts expired nodes regardless of their reference bit.
+ *
+ * That is thread safe implementation
+ */
+class LockFreeHash : public Afina::Storage {
+public:
+    /**
+     * Counters of the cache state. Hits and misses are counted per CPU, so concurrent readers don't share
+     * a cache line for them
+     */
+    struct Stats {
+        // Bytes of keys and values stored and the limit on them
+        std::size_t size;
+        std::size_t max_size;
+
+        // Lookups that found/didn't find the key
+        uint64_t hits;
+        uint64_t misses;
+
+        // Entries dropped to make room for the new ones
+        uint64_t evictions;
+    };
+
+    LockFreeHash(size_t max_size = 1024);
+    ~LockFreeHash();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Implements Afina::Storage interface
+    void Report(const Reporter &reporter) override;
+
+    Stats GetStats() const;
+
+private:
+    // Value published by the node, immutable
+    struct table_value {
+        table_value(std::string data_, uint64_t cas_, std::time_t expire_)
+            : data(std::move(data_)), cas(cas_), expire(expire_) {}
+
+        bool Expired(std::time_t now) const { return expire != 0 && expire <= now; }
+
+        const std::string data;
+        const uint64_t cas;
+
+        // Unix time value expires at, 0 if never
+        const std::time_t expire;
+    };
+
+    struct table_node {
+        table_node(const std::string &key_, table_value *value_, uint64_t hash_)
+            : key(key_), hash(hash_), value(value_), next(0), referenced(true) {}
+        ~table_node() { delete value.load(std::memory_order_relaxed); }
+
+        const std::string key;
+        const uint64_t hash;
+
+        // nullptr once node is deleted
+        std::atomic<table_value *> value;
+
+        // Next node, the lowest bit set marks this node as removed from the list
+        std::atomic<uintptr_t> next;
+
+        // Set on each access, cleared by the clock hand
+        std::atomic<bool> referenced;
+    };
+
+    // Average entry size bucket count is derived from
+    static constexpr std::size_t kBytesPerBucket = 64;
+
+    // How many sweeps over all buckets writer makes looking for a victim before it gives up
+    static constexpr std::size_t kEvictRounds = 2;
+
+    static void _DeleteNode(void *node);
+    static void _DeleteValue(void *value);
+
+    static std::time_t _Now();
+
+    // Builds value with a new version
+    table_value *_NewValue(std::string data, std::time_t expire);
+
+    // Same as View, but passes version of the value as well
+    bool _View(const std::string &key, const CasVisitor &visitor);
+
+    // Returns current value of the live node with the given key and marks node as referenced, nullptr if there
+    // is none
+    table_value *_Lookup(Epoch::Guard &guard, const KeyRef &key);
+
+    std::atomic<uintptr_t> &_Bucket(uint64_t hash) { return _buckets[hash & _mask]; }
+
+    // Returns live node with the given key or nullptr, unlinks removed nodes it meets on the way and takes
+    // expired value of the key away. Head of the bucket seen by a clean pass is stored into head
+    table_node *_Find(Epoch::Guard &guard, const KeyRef &key, uintptr_t *head);
+
+    // Takes value of the node away if it is still the given one and marks node removed, otherwise returns
+    // false with value updated to the current one. Node is left for the next _Find to unlink
+    bool _Take(Epoch::Guard &guard, table_node *node, table_value *&value);
+
+    // Atomically takes value of the node away, then unlinks node. Returns false if node was deleted already
+    bool _Remove(Epoch::Guard &guard, table_node *node);
+
+    // Replaces value of the live node, returns false if node got deleted meanwhile
+    bool _Replace(Epoch::Guard &guard, table_node *node, const std::string &value, std::time_t expire);
+
+    // Swaps value of the node with the one extended by data, retries if another writer got there first
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Swaps value of the node with the counter changed by delta, retries the same way as _Extend
+    IncrResult _Increment(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Sweeps clock hand until there is room for size more bytes, node keep is never evicted
+    void _Evict(Epoch::Guard &guard, std::size_t size, const table_node *keep);
+
+    // Inserts new node unless there is one with the same key already, which is returned then
+    table_node *_Insert(Epoch::Guard &guard, const std::string &key, const std::string &value, uint64_t hash,
+                        std::time_t expire);
+
+    // Maximum number of bytes could be stored in this cache.
+    // i.e all (keys+values) must be not greater than the _max_size
+    const std::size_t _max_size;
+    std::atomic<std::size_t> _curr_size;
+
+    // The last version given to a value
+    std::atomic<uint64_t> _cas;
+
+    std::unique_ptr<std::atomic<uintptr_t>[]> _buckets;
+    const std::size_t _mask;
+
+    // Next bucket clock hand looks at
+    std::atomic<std::size_t> _hand;
+
+    Concurrency::CoreCounter _hits;
+    Concurrency::CoreCounter _misses;
+    Concurrency::CoreCounter _evictions;
+
+    Epoch _epoch;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_LOCK_FREE_HASH_H
@@ -0,0 +1,728 @@
+#include "MmapStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+constexpr std::size_t MmapStorage::kMinBlock;
+constexpr std::size_t MmapStorage::kClasses;
+
+static const char kMagic[8] = {'A', 'F', 'N', 'M', 'M', 'A', 'P', '3'};
+
+// Bytes of file per bucket
+static constexpr std::size_t kBytesPerBucket = 256;
+
+struct MmapStorage::header {
+    char magic[8];
+    uint32_t clean;
+    uint32_t reserved;
+
+    // Hash function depends on the build, see KeyHash.h, file is usable only with the same one
+    uint64_t hash_check;
+
+    uint64_t file_size;
+    uint64_t buckets;
+
+    // Offset of the first block and of the space that isn't cut into blocks yet
+    uint64_t data;
+    uint64_t tail;
+
+    uint64_t count;
+    uint64_t used;
+
+    // Next bucket CLOCK hand visits
+    uint64_t hand;
+
+    // The last version given to a value
+    uint64_t cas;
+
+    // Heads of free blocks lists per class
+    uint64_t free[kClasses];
+};
+
+struct MmapStorage::item {
+    // Next item in the bucket chain, or next free block
+    uint64_t next;
+    union {
+        uint64_t hash;
+
+        // Previous free block of the same class, so that buddy is taken out of the list when merged
+        uint64_t prev;
+    };
+    uint64_t cas;
+    int64_t expire;
+    uint32_t key_size;
+    uint32_t value_size;
+    uint8_t klass;
+    uint8_t live;
+    uint8_t referenced;
+    uint8_t reserved[5];
+
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+    bool KeyEquals(const KeyRef &key) {
+        return key_size == key.size && std::memcmp(data(), key.data, key_size) == 0;
+    }
+};
+
+static std::size_t PageSize() { return sysconf(_SC_PAGESIZE); }
+
+static int64_t Now() { return int64_t(std::time(nullptr)); }
+
+MmapStorage::MmapStorage(const std::string &path, std::size_t file_size)
+    : _path(path), _fd(-1), _base(nullptr), _warm(false), _header(nullptr), _buckets(nullptr), _hits(0),
+      _misses(0), _evictions(0) {
+    std::size_t page = PageSize();
+    _file_size = (file_size + page - 1) / page * page;
+
+    uint64_t buckets = 1024;
+    while (buckets * kBytesPerBucket < _file_size) {
+        buckets *= 2;
+    }
+    uint64_t data = page + (buckets * sizeof(uint64_t) + page - 1) / page * page;
+    if (data + kMinBlock > _file_size) {
+        throw std::system_error(EINVAL, std::system_category(), "File is too small for storage");
+    }
+
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to open " + path);
+    }
+
+    // Only header is checked before mapping everything, file could be of other size
+    header old;
+    std::memset(&old, 0, sizeof(old));
+    struct stat st;
+    bool reuse = fstat(_fd, &st) == 0 && std::size_t(st.st_size) == _file_size &&
+                 pread(_fd, &old, sizeof(old), 0) == ssize_t(sizeof(old)) &&
+                 std::memcmp(old.magic, kMagic, sizeof(kMagic)) == 0 && old.clean == 1 &&
+                 old.hash_check == HashKey(kMagic, sizeof(kMagic)) && old.file_size == _file_size &&
+                 old.buckets == buckets && old.data == data;
+
+    // Truncating to zero first drops whatever was there, the rest of the file is sparse
+    if (!reuse && (ftruncate(_fd, 0) != 0 || ftruncate(_fd, _file_size) != 0)) {
+        int error = errno;
+        close(_fd);
+        throw std::system_error(error, std::system_category(), "Failed to size " + path);
+    }
+
+    void *mem = mmap(nullptr, _file_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mem == MAP_FAILED) {
+        int error = errno;
+        close(_fd);
+        throw std::system_error(error, std::system_category(), "Failed to map " + path);
+    }
+    _base = static_cast<char *>(mem);
+    _header = reinterpret_cast<header *>(_base);
+    _buckets = reinterpret_cast<uint64_t *>(_base + page);
+    _warm = reuse;
+
+    if (!reuse) {
+        std::memcpy(_header->magic, kMagic, sizeof(kMagic));
+        _header->hash_check = HashKey(kMagic, sizeof(kMagic));
+        _header->file_size = _file_size;
+        _header->buckets = buckets;
+        _header->data = data;
+        _header->tail = data;
+    }
+
+    // Dirty mark must reach the disk before any change does
+    _header->clean = 0;
+    msync(_base, page, MS_SYNC);
+}
+
+MmapStorage::~MmapStorage() {
+    if (_base) {
+        munmap(_base, _file_size);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+// See MmapStorage.h
+void MmapStorage::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Index is touched by every lookup, data is accessed at random
+    _Advise(PageSize(), _header->data - PageSize(), MADV_WILLNEED);
+    _Advise(_header->data, _file_size - _header->data, MADV_RANDOM);
+}
+
+// See MmapStorage.h
+void MmapStorage::Stop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (msync(_base, _file_size, MS_SYNC) != 0) {
+        return;
+    }
+    __atomic_store_n(&_header->clean, 1, __ATOMIC_RELEASE);
+    msync(_base, PageSize(), MS_SYNC);
+}
+
+// See MmapStorage.h
+bool MmapStorage::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    int64_t now = Now();
+    KeyRef ref(key);
+    uint64_t *link = _Find(ref, now);
+    int64_t exptime = _Expire(expire);
+    if (exptime != 0 && exptime <= now) {
+        // Value is never visible, only the old one has to go
+        if (link) {
+            _Remove(link);
+        }
+        return true;
+    }
+
+    if (link && _Update(_Item(*link), value, exptime)) {
+        return true;
+    }
+    return _Insert(key, value, ref.hash, exptime, link ? *link : 0);
+}
+
+// See MmapStorage.h
+bool MmapStorage::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    int64_t now = Now();
+    KeyRef ref(key);
+    if (_Find(ref, now)) {
+        return false;
+    }
+    int64_t exptime = _Expire(expire);
+    if (exptime != 0 && exptime <= now) {
+        return true;
+    }
+    return _Insert(key, value, ref.hash, exptime);
+}
+
+// See MmapStorage.h
+bool MmapStorage::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    int64_t now = Now();
+    KeyRef ref(key);
+    uint64_t *link = _Find(ref, now);
+    if (!link) {
+        return false;
+    }
+    int64_t exptime = _Expire(expire);
+    if (exptime != 0 && exptime <= now) {
+        _Remove(link);
+        return true;
+    }
+    if (_Update(_Item(*link), value, exptime)) {
+        return true;
+    }
+    return _Insert(key, value, ref.hash, exptime, *link);
+}
+
+// See MmapStorage.h
+bool MmapStorage::Delete(const std::string &key) { return Delete(KeyRef(key)); }
+
+// See MmapStorage.h
+bool MmapStorage::Delete(const KeyRef &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t *link = _Find(key, Now());
+    if (!link) {
+        return false;
+    }
+    _Remove(link);
+    return true;
+}
+
+// See MmapStorage.h
+bool MmapStorage::Append(const std::string &key, const std::string &data) { return _Extend(key, data, false); }
+
+// See MmapStorage.h
+bool MmapStorage::Prepend(const std::string &key, const std::string &data) { return _Extend(key, data, true); }
+
+// See MmapStorage.h
+Storage::IncrResult MmapStorage::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, false, value);
+}
+
+// See MmapStorage.h
+Storage::IncrResult MmapStorage::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, true, value);
+}
+
+// See MmapStorage.h
+bool MmapStorage::Get(const std::string &key, std::string &value) {
+    return View(key, [&value](const char *data, std::size_t size) { value.assign(data, size); });
+}
+
+// See MmapStorage.h
+bool MmapStorage::Get(const KeyRef &key, std::string &value) {
+    return View(key, [&value](const char *data, std::size_t size) { value.assign(data, size); });
+}
+
+// See MmapStorage.h
+bool MmapStorage::View(const std::string &key, const Visitor &visitor) { return View(KeyRef(key), visitor); }
+
+// See MmapStorage.h
+bool MmapStorage::View(const KeyRef &key, const Visitor &visitor) {
+    return _View(key, [&visitor](const char *value, std::size_t size, uint64_t) { visitor(value, size); });
+}
+
+// See MmapStorage.h
+std::size_t MmapStorage::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [&key, &visitor](const char *value, std::size_t size, uint64_t) {
+            visitor(key, value, size);
+        });
+    }
+    return found;
+}
+
+// See MmapStorage.h
+std::size_t MmapStorage::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [&key, &visitor](const char *value, std::size_t size, uint64_t) {
+            visitor(key, value, size);
+        });
+    }
+    return found;
+}
+
+// See MmapStorage.h
+std::size_t MmapStorage::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [&key, &visitor](const char *value, std::size_t size, uint64_t cas) {
+            visitor(key, value, size, cas);
+        });
+    }
+    return found;
+}
+
+// See MmapStorage.h
+Storage::CasResult MmapStorage::CompareAndSwap(const std::string &key, const std::string &value,
+                                               std::time_t expire, uint64_t cas) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    int64_t now = Now();
+    KeyRef ref(key);
+    uint64_t *link = _Find(ref, now);
+    if (!link) {
+        return CasResult::kNotFound;
+    }
+    if (_Item(*link)->cas != cas) {
+        return CasResult::kExists;
+    }
+    int64_t exptime = _Expire(expire);
+    if (exptime != 0 && exptime <= now) {
+        _Remove(link);
+        return CasResult::kStored;
+    }
+    if (_Update(_Item(*link), value, exptime)) {
+        return CasResult::kStored;
+    }
+    return _Insert(key, value, ref.hash, exptime, *link) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See MmapStorage.h
+bool MmapStorage::Scan(const Scanner &scanner) {
+    int64_t now = Now();
+    uint64_t data = _header->data, tail = _header->tail;
+
+    // Blocks follow each other, so that is a single pass over the file
+    _Advise(data, tail - data, MADV_SEQUENTIAL);
+    for (uint64_t offset = data; offset < tail;) {
+        item *it = _Item(offset);
+        if (it->live && (it->expire == 0 || it->expire > now)) {
+            scanner(it->data(), it->key_size, it->data() + it->key_size, it->value_size, std::time_t(it->expire));
+        }
+        offset += kMinBlock << it->klass;
+    }
+    _Advise(data, tail - data, MADV_RANDOM);
+    return true;
+}
+
+// See MmapStorage.h
+MmapStorage::Stats MmapStorage::GetStats() const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return Stats{_header->count, _header->used, _header->tail - _header->data, _file_size, _hits, _misses,
+                 _evictions};
+}
+
+int64_t MmapStorage::_Expire(std::time_t expire) {
+    // Anything before the epoch is long gone, but 0 is taken by "never"
+    return expire < 0 ? 1 : int64_t(expire);
+}
+
+std::size_t MmapStorage::_Class(std::size_t size) {
+    std::size_t klass = 0;
+    while (klass < kClasses && (kMinBlock << klass) < size) {
+        klass++;
+    }
+    return klass;
+}
+
+MmapStorage::item *MmapStorage::_Item(uint64_t offset) const { return reinterpret_cast<item *>(_base + offset); }
+
+uint64_t *MmapStorage::_Link(uint64_t offset) {
+    uint64_t *link = &_buckets[_Item(offset)->hash & (_header->buckets - 1)];
+    while (*link != offset) {
+        link = &_Item(*link)->next;
+    }
+    return link;
+}
+
+uint64_t *MmapStorage::_Find(const KeyRef &key, int64_t now) {
+    uint64_t *link = &_buckets[key.hash & (_header->buckets - 1)];
+    while (*link) {
+        item *it = _Item(*link);
+        if (it->hash == key.hash && it->KeyEquals(key)) {
+            if (it->expire != 0 && it->expire <= now) {
+                _Remove(link);
+                return nullptr;
+            }
+            return link;
+        }
+        link = &it->next;
+    }
+    return nullptr;
+}
+
+void MmapStorage::_Remove(uint64_t *link) {
+    uint64_t offset = *link;
+    item *it = _Item(offset);
+    *link = it->next;
+    _header->count--;
+    _header->used -= it->key_size + it->value_size;
+    _Free(offset);
+}
+
+bool MmapStorage::_Insert(const std::string &key, const std::string &value, uint64_t hash, int64_t expire,
+                          uint64_t old) {
+    std::size_t klass = _Class(sizeof(item) + key.size() + value.size());
+    uint64_t offset = klass < kClasses ? _Allocate(klass, old) : 0;
+    if (!offset) {
+        return false;
+    }
+    if (old) {
+        // Eviction could have changed the chain, so the link is looked up again
+        _Remove(_Link(old));
+    }
+
+    item *it = _Item(offset);
+    it->hash = hash;
+    it->expire = expire;
+    it->key_size = key.size();
+    it->value_size = value.size();
+    it->cas = ++_header->cas;
+    it->klass = klass;
+    it->live = 1;
+    it->referenced = 0;
+    std::memcpy(it->data(), key.data(), key.size());
+    std::memcpy(it->data() + key.size(), value.data(), value.size());
+
+    uint64_t &bucket = _buckets[hash & (_header->buckets - 1)];
+    it->next = bucket;
+    bucket = offset;
+    _header->count++;
+    _header->used += key.size() + value.size();
+    return true;
+}
+
+bool MmapStorage::_Update(item *it, const std::string &value, int64_t expire) {
+    // Much smaller value moves to a smaller block, so that space isn't wasted
+    if (_Class(sizeof(item) + it->key_size + value.size()) != it->klass) {
+        return false;
+    }
+    _header->used += value.size();
+    _header->used -= it->value_size;
+    it->value_size = value.size();
+    it->expire = expire;
+    it->cas = ++_header->cas;
+    std::memcpy(it->data() + it->key_size, value.data(), value.size());
+    return true;
+}
+
+bool MmapStorage::_View(const KeyRef &key, const std::function<void(const char *, std::size_t, uint64_t)> &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t *link = _Find(key, Now());
+    if (!link) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+
+    // Page isn't dirtied by the hits of the item that is referenced already
+    item *it = _Item(*link);
+    if (!it->referenced) {
+        it->referenced = 1;
+    }
+    visitor(it->data() + it->key_size, it->value_size, it->cas);
+    return true;
+}
+
+bool MmapStorage::_Extend(const std::string &key, const std::string &data, bool front) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    KeyRef ref(key);
+    uint64_t *link = _Find(ref, Now());
+    if (!link) {
+        return false;
+    }
+
+    item *it = _Item(*link);
+    std::size_t value_size = it->value_size + data.size();
+    std::size_t size = sizeof(item) + it->key_size + value_size;
+    if (size <= kMinBlock << it->klass) {
+        char *value = it->data() + it->key_size;
+        if (front) {
+            std::memmove(value + data.size(), value, it->value_size);
+            std::memcpy(value, data.data(), data.size());
+        } else {
+            std::memcpy(value + it->value_size, data.data(), data.size());
+        }
+        it->value_size = value_size;
+        it->cas = ++_header->cas;
+        _header->used += data.size();
+        return true;
+    }
+    if (_Class(size) == kClasses || (kMinBlock << _Class(size)) > _file_size - _header->data) {
+        return false;
+    }
+
+    // Block size doubles, so value is moved once per doubling rather than on each call
+    std::string value;
+    value.reserve(value_size);
+    const char *old = it->data() + it->key_size;
+    if (front) {
+        value.append(data).append(old, it->value_size);
+    } else {
+        value.append(old, it->value_size).append(data);
+    }
+    return _Insert(key, value, ref.hash, it->expire, *link);
+}
+
+Storage::IncrResult MmapStorage::_Increment(const std::string &key, uint64_t delta, bool decrement,
+                                            uint64_t &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    KeyRef ref(key);
+    uint64_t *link = _Find(ref, Now());
+    if (!link) {
+        return IncrResult::kNotFound;
+    }
+
+    // Counter is kept as digits, so the file stays readable by any build. Digits fit the block almost always
+    item *it = _Item(*link);
+    if (!_ApplyDelta(it->data() + it->key_size, it->value_size, delta, decrement, value)) {
+        return IncrResult::kNotNumber;
+    }
+    std::string digits = std::to_string(value);
+    int64_t expire = it->expire;
+    if (_Update(it, digits, expire)) {
+        return IncrResult::kUpdated;
+    }
+    return _Insert(key, digits, ref.hash, expire, *link) ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+uint64_t MmapStorage::_Allocate(std::size_t klass, uint64_t keep) {
+    std::size_t size = kMinBlock << klass;
+    if (size > _file_size - _header->data) {
+        return 0;
+    }
+
+    uint64_t offset = _PopFree(klass);
+    if (offset) {
+        return offset;
+    }
+
+    // Blocks are aligned to their size, so that none crosses more pages than needed
+    uint64_t start = (_header->tail - _header->data + size - 1) / size * size + _header->data;
+    if (start + size <= _file_size) {
+        // Gap left by alignment is cut into free blocks as well
+        while (_header->tail < start) {
+            std::size_t gap = _header->tail - _header->data;
+            std::size_t gap_class = 0;
+            while (gap_class + 1 < klass && gap % (kMinBlock << (gap_class + 1)) == 0 &&
+                   _header->tail + (kMinBlock << (gap_class + 1)) <= start) {
+                gap_class++;
+            }
+            item *it = _Item(_header->tail);
+            it->klass = gap_class;
+            it->live = 0;
+            _Free(_header->tail);
+            _header->tail += kMinBlock << gap_class;
+        }
+        _header->tail = start + size;
+        return start;
+    }
+
+    if (!_Evict(klass, Now(), keep)) {
+        return 0;
+    }
+    return _PopFree(klass);
+}
+
+uint64_t MmapStorage::_PopFree(std::size_t klass) {
+    std::size_t found = klass;
+    while (found < kClasses && !_header->free[found]) {
+        found++;
+    }
+    if (found == kClasses) {
+        return 0;
+    }
+
+    uint64_t offset = _header->free[found];
+    _UnlinkFree(offset);
+
+    // Bigger block is split in halves, upper ones go to the free lists
+    while (found > klass) {
+        found--;
+        uint64_t half = offset + (kMinBlock << found);
+        item *it = _Item(half);
+        it->klass = found;
+        it->live = 0;
+        _PushFree(half);
+    }
+    return offset;
+}
+
+void MmapStorage::_PushFree(uint64_t offset) {
+    item *it = _Item(offset);
+    it->prev = 0;
+    it->next = _header->free[it->klass];
+    if (it->next) {
+        _Item(it->next)->prev = offset;
+    }
+    _header->free[it->klass] = offset;
+}
+
+void MmapStorage::_UnlinkFree(uint64_t offset) {
+    item *it = _Item(offset);
+    if (it->prev) {
+        _Item(it->prev)->next = it->next;
+    } else {
+        _header->free[it->klass] = it->next;
+    }
+    if (it->next) {
+        _Item(it->next)->prev = it->prev;
+    }
+}
+
+void MmapStorage::_Free(uint64_t offset) {
+    item *it = _Item(offset);
+    it->live = 0;
+
+    // Header of the block stays, the rest is of no use
+    std::size_t page = PageSize();
+    uint64_t start = (offset + sizeof(item) + page - 1) / page * page;
+    uint64_t end = (offset + (kMinBlock << it->klass)) / page * page;
+    if (end > start) {
+#ifdef MADV_COLD
+        _Advise(start, end - start, MADV_COLD);
+#endif
+    }
+
+    // Block merges with its buddy as long as that one is free and whole, so that big blocks come back
+    std::size_t klass = it->klass;
+    while (klass + 1 < kClasses) {
+        std::size_t size = kMinBlock << klass;
+        uint64_t buddy = _header->data + ((offset - _header->data) ^ size);
+        if (buddy + size > _header->tail) {
+            break;
+        }
+        item *other = _Item(buddy);
+        if (other->live || other->klass != klass) {
+            break;
+        }
+        _UnlinkFree(buddy);
+        offset = std::min(offset, buddy);
+        klass++;
+    }
+
+    it = _Item(offset);
+    it->klass = klass;
+    it->live = 0;
+    _PushFree(offset);
+}
+
+bool MmapStorage::_HasFree(std::size_t klass) const {
+    for (; klass < kClasses; ++klass) {
+        if (_header->free[klass]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MmapStorage::_Evict(std::size_t klass, int64_t now, uint64_t keep) {
+    // Small blocks scattered over the file rarely merge into a big one, so CLOCK evicts only about as many
+    // bytes as requested, then all items around the last victim go
+    std::size_t size = kMinBlock << klass;
+    std::size_t evicted = 0;
+    uint64_t victim = 0;
+
+    // Two rounds at most: the first one could only clear reference bits
+    uint64_t steps = 2 * _header->buckets;
+    for (uint64_t step = 0; step < steps && evicted < size; ++step) {
+        uint64_t *link = &_buckets[_header->hand];
+        _header->hand = (_header->hand + 1) & (_header->buckets - 1);
+
+        while (*link) {
+            item *it = _Item(*link);
+            if (*link == keep) {
+                link = &it->next;
+                continue;
+            }
+            if (it->referenced && (it->expire == 0 || it->expire > now)) {
+                it->referenced = 0;
+                link = &it->next;
+                continue;
+            }
+            victim = *link;
+            evicted += kMinBlock << it->klass;
+            _Remove(link);
+            _evictions++;
+            if (_HasFree(klass)) {
+                return true;
+            }
+        }
+    }
+    return victim && _EvictBlock(_header->data + (victim - _header->data) / size * size, klass, keep);
+}
+
+bool MmapStorage::_EvictBlock(uint64_t offset, std::size_t klass, uint64_t keep) {
+    // Blocks are aligned to their size, so the ones smaller than the range cover it exactly
+    uint64_t end = offset + (kMinBlock << klass);
+    if (end > _header->tail || (keep >= offset && keep < end)) {
+        return false;
+    }
+
+    while (offset < end) {
+        item *it = _Item(offset);
+        uint64_t next = offset + (kMinBlock << it->klass);
+        if (it->live) {
+            _Remove(_Link(offset));
+            _evictions++;
+        }
+        offset = next;
+    }
+    return true;
+}
+
+void MmapStorage::_Advise(uint64_t offset, std::size_t size, int advice) {
+    // Hints only, failure changes nothing but performance
+    std::size_t page = PageSize();
+    uint64_t start = offset / page * page;
+    if (size > 0) {
+        madvise(_base + start, offset + size - start, advice);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,244 @@
+#ifndef AFINA_STORAGE_MMAP_STORAGE_H
+#define AFINA_STORAGE_MMAP_STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage in a memory mapped file
+ * Items and the hash index both live in a file that is mapped as a whole, so the data set could be much
+ * bigger than RAM: page cache keeps hot pages resident and the kernel writes dirty ones back. The file
+ * stays between runs and the next start just maps it again, nothing is read or rebuilt up front:
+ *
+ * +--------+----------------------+-------------------------------------+
+ * | header | buckets, u64 offsets | blocks of items                     |
+ * +--------+----------------------+-------------------------------------+
+ *
+ * Each bucket heads a chain of items linked by offsets. Item takes a block of power of two size, from 64
+ * bytes up, blocks are cut from the end of allocated space or taken from per size free lists, bigger free
+ * block is split in halves and freed one merges with its free buddy. Once the file is full, CLOCK hand goes
+ * over buckets: items accessed since the previous pass get another chance, the rest are evicted, until block
+ * of the needed size is free. If that doesn't happen after about the needed size is evicted, all items of
+ * the aligned range around the last victim go, so a big item never wipes the whole store.
+ *
+ * Index is looked up randomly, so readahead is disabled for the data, while Scan goes over blocks in file
+ * order with sequential hint. Pages of freed blocks are hinted cold to leave page cache first.
+ *
+ * Mapping is shared, so a forked copy of the storage isn't frozen in time as Snapshotter and CommandLog
+ * compaction expect. There is no need for them anyway, the file itself is persistent.
+ *
+ * Header tells whether the file was left clean by Stop. File that wasn't, as after a crash in the middle
+ * of a change, or that has other geometry is started empty.
+ *
+ * Versions of values are kept in items, and the last one given out is in the header, so they stay valid
+ * across restarts as well.
+ *
+ * That is thread safe implementation, all operations are serialized on a single mutex
+ */
+class MmapStorage : public Afina::Storage {
+public:
+    struct Stats {
+        std::size_t entries;
+
+        // Bytes of keys and values, of blocks cut from the file and of the file itself
+        std::size_t used_bytes;
+        std::size_t allocated_bytes;
+        std::size_t file_size;
+
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
+    /**
+     * Opens the file, creating it if needed. Throws std::system_error if it couldn't be mapped
+     *
+     * @param path of the file
+     * @param file_size bytes of the file, rounded up to pages
+     */
+    MmapStorage(const std::string &path, std::size_t file_size);
+    ~MmapStorage();
+
+    MmapStorage(const MmapStorage &) = delete;
+    MmapStorage &operator=(const MmapStorage &) = delete;
+
+    // Implements Afina::Storage interface
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return Put(key, value, 0); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return PutIfAbsent(key, value, 0);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return Set(key, value, 0); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    void Freeze() override { _mutex.lock(); }
+
+    // Implements Afina::Storage interface
+    void Thaw() override { _mutex.unlock(); }
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    /**
+     * Whether content of the file was picked up from the previous run
+     */
+    bool warm() const { return _warm; }
+
+    Stats GetStats() const;
+
+private:
+    struct header;
+    struct item;
+
+    // Blocks are kMinBlock << class bytes
+    static constexpr std::size_t kMinBlock = 64;
+    static constexpr std::size_t kClasses = 32;
+
+    static int64_t _Expire(std::time_t expire);
+
+    static std::size_t _Class(std::size_t size);
+
+    item *_Item(uint64_t offset) const;
+
+    // Returns link that points to the live item at the given offset
+    uint64_t *_Link(uint64_t offset);
+
+    // Returns link that points to the live item with the given key, expired one is removed on the way
+    uint64_t *_Find(const KeyRef &key, int64_t now);
+
+    // Unlinks item the link points to and frees its block
+    void _Remove(uint64_t *link);
+
+    // Adds new item, old one with the same key if any is removed only once new one got its block
+    bool _Insert(const std::string &key, const std::string &value, uint64_t hash, int64_t expire, uint64_t old = 0);
+
+    // Stores new value into the item if it fits the block, returns false otherwise
+    bool _Update(item *it, const std::string &value, int64_t expire);
+
+    // Same as View, but passes version of the value as well
+    bool _View(const KeyRef &key,
+               const std::function<void(const char *value, std::size_t size, uint64_t cas)> &visitor);
+
+    // Adds data to the end or to the front of the value, in place if the block has room
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Rewrites counter digits, in place if the block has room
+    IncrResult _Increment(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Returns offset of a block of the given class, 0 if nothing could be evicted. Item at keep offset stays
+    uint64_t _Allocate(std::size_t klass, uint64_t keep);
+
+    // Pops block of at least the given class from free lists, 0 if there is none
+    uint64_t _PopFree(std::size_t klass);
+
+    void _PushFree(uint64_t offset);
+
+    // Takes free block out of its list
+    void _UnlinkFree(uint64_t offset);
+
+    // Puts block to the free lists merging it with free buddies
+    void _Free(uint64_t offset);
+
+    // Whether there is a free block of at least the given class
+    bool _HasFree(std::size_t klass) const;
+
+    // Evicts items until block of the given class is free, but never the keep one. Returns false if it didn't
+    // help, having evicted about the size of the block only
+    bool _Evict(std::size_t klass, int64_t now, uint64_t keep);
+
+    // Evicts all items of the block of the given class at offset, returns false if that is not possible
+    bool _EvictBlock(uint64_t offset, std::size_t klass, uint64_t keep);
+
+    void _Advise(uint64_t offset, std::size_t size, int advice);
+
+    std::string _path;
+    int _fd;
+    char *_base;
+    std::size_t _file_size;
+    bool _warm;
+
+    header *_header;
+    uint64_t *_buckets;
+
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+
+    mutable std::mutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MMAP_STORAGE_H
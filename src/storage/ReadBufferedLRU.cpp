@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "ReadBufferedLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+ReadBufferedLRU::ReadBufferedLRU(size_t max_size) : SimpleLRU(max_size), _buffer_count(1) {
+    // Buffer per core, threads beyond that share them
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    while (_buffer_count < cores) {
+        _buffer_count *= 2;
+    }
+
+    // new doesn't respect alignment above the fundamental one until C++17
+    void *mem = nullptr;
+    if (posix_memalign(&mem, kCacheLine, sizeof(read_buffer) * _buffer_count) != 0) {
+        throw std::bad_alloc();
+    }
+    _buffers = static_cast<read_buffer *>(mem);
+    for (size_t i = 0; i < _buffer_count; ++i) {
+        new (&_buffers[i]) read_buffer();
+    }
+}
+
+ReadBufferedLRU::~ReadBufferedLRU() {
+    for (size_t i = 0; i < _buffer_count; ++i) {
+        _buffers[i].~read_buffer();
+    }
+    std::free(_buffers);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Put(const std::string &key, const std::string &value) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Put(key, value);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::PutIfAbsent(key, value);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Set(const std::string &key, const std::string &value) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Set(key, value);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Put(key, value, expire);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::PutIfAbsent(key, value, expire);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Set(key, value, expire);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Append(const std::string &key, const std::string &data) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Append(key, data);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Prepend(const std::string &key, const std::string &data) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Prepend(key, data);
+}
+
+// See ReadBufferedLRU.h
+Storage::IncrResult ReadBufferedLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Increment(key, delta, value);
+}
+
+// See ReadBufferedLRU.h
+Storage::IncrResult ReadBufferedLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Decrement(key, delta, value);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Delete(const std::string &key) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::Delete(key);
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::Get(const std::string &key, std::string &value) {
+    return View(key, [&value](const char *data, std::size_t size) { value.assign(data, size); });
+}
+
+// See ReadBufferedLRU.h
+bool ReadBufferedLRU::View(const std::string &key, const Visitor &visitor) {
+    read_buffer &buffer = _Buffer();
+    bool found, full = false;
+    {
+        Concurrency::SharedLock lock(_mutex);
+        found = _Read(buffer, key, visitor, full);
+    }
+    if (full) {
+        _TryDrain();
+    }
+    return found;
+}
+
+// See ReadBufferedLRU.h
+std::size_t ReadBufferedLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    read_buffer &buffer = _Buffer();
+    std::size_t found = 0;
+    bool full = false;
+    {
+        Concurrency::SharedLock lock(_mutex);
+        for (auto &key : keys) {
+            found += _Read(buffer, key, [&key, &visitor](const char *value, std::size_t size) {
+                visitor(key, value, size);
+            }, full);
+        }
+    }
+    if (full) {
+        _TryDrain();
+    }
+    return found;
+}
+
+// See ReadBufferedLRU.h
+std::size_t ReadBufferedLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::MultiViewCas(keys, visitor);
+}
+
+// See ReadBufferedLRU.h
+Storage::CasResult ReadBufferedLRU::CompareAndSwap(const std::string &key, const std::string &value,
+                                                   std::time_t expire, uint64_t cas) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    return SimpleLRU::CompareAndSwap(key, value, expire, cas);
+}
+
+// See ReadBufferedLRU.h
+void ReadBufferedLRU::Freeze() {
+    _mutex.lock();
+    _Drain();
+}
+
+// See ReadBufferedLRU.h
+void ReadBufferedLRU::Thaw() { _mutex.unlock(); }
+
+// See ReadBufferedLRU.h
+SimpleLRU::Stats ReadBufferedLRU::GetStats() const {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    Stats stats = SimpleLRU::GetStats();
+    stats.hits += _hits.Sum();
+    stats.misses += _misses.Sum();
+    return stats;
+}
+
+// See ReadBufferedLRU.h
+void ReadBufferedLRU::SetMaxSize(std::size_t max_size) {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex);
+    _Drain();
+    SimpleLRU::SetMaxSize(max_size);
+}
+
+// See ReadBufferedLRU.h
+std::time_t ReadBufferedLRU::Expire(const std::string &key) const {
+    Concurrency::SharedLock lock(_mutex);
+    return SimpleLRU::Expire(key);
+}
+
+ReadBufferedLRU::read_buffer &ReadBufferedLRU::_Buffer() const {
+    // Threads are spread over buffers round robin in order of their first read
+    static std::atomic<size_t> next(0);
+    static thread_local size_t idx = next.fetch_add(1, std::memory_order_relaxed);
+    return _buffers[idx & (_buffer_count - 1)];
+}
+
+bool ReadBufferedLRU::_Read(read_buffer &buffer, const std::string &key, const Visitor &visitor, bool &full) {
+    lru_node *node = _Peek(key);
+    if (node == nullptr) {
+        _misses.Add();
+        return false;
+    }
+    _hits.Add();
+    visitor(node->value.data(), node->value.size());
+
+    // Head doesn't move while the lock is held shared, so the slot taken is free until the next drain. The
+    // drain comes under exclusive lock, which orders the store below before it
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+    if (tail - head < kBufferSize &&
+        buffer.tail.compare_exchange_strong(tail, tail + 1, std::memory_order_relaxed)) {
+        buffer.slots[tail & (kBufferSize - 1)].store(node, std::memory_order_relaxed);
+        tail++;
+    }
+    full = full || tail - head >= kBufferSize;
+    return true;
+}
+
+void ReadBufferedLRU::_TryDrain() {
+    std::unique_lock<Concurrency::SharedMutex> lock(_mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        _Drain();
+    }
+}
+
+void ReadBufferedLRU::_Drain() {
+    for (size_t i = 0; i < _buffer_count; ++i) {
+        read_buffer &buffer = _buffers[i];
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head) {
+            _Promote(buffer.slots[head & (kBufferSize - 1)].load(std::memory_order_relaxed));
+        }
+        buffer.head.store(head, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
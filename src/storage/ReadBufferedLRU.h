@@ -0,0 +1,153 @@
+#ifndef AFINA_STORAGE_READ_BUFFERED_LRU_H
+#define AFINA_STORAGE_READ_BUFFERED_LRU_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
+#include <afina/concurrency/SharedMutex.h>
+
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SimpleLRU with batched promotions
+ * ThreadSafeSimplLRU takes the mutex exclusively on each read only to move the entry to the head of the
+ * list. Here reads take the lock shared, so they run in parallel, and hits are recorded into read buffers
+ * instead: small rings, each thread writes to one of them picked once per thread. Whoever takes the lock
+ * exclusively drains all buffers first and applies the promotions in order, so that the list is reordered
+ * in batches and a write pays for many reads at once. Reader that finds its buffer full tries to take the
+ * lock to drain them, but doesn't wait if someone holds it.
+ *
+ * Buffers are lossy: hit that doesn't fit, or loses a race for a slot, is dropped. LRU order becomes
+ * approximate, hot entries are still promoted often enough to stay, as nothing needs all of their hits.
+ *
+ * Recorded nodes can't go away before they are drained, entries are removed only under exclusive lock
+ * and each exclusive section starts with the drain.
+ *
+ * That is thread safe implementation
+ */
+class ReadBufferedLRU : public SimpleLRU {
+public:
+    ReadBufferedLRU(size_t max_size = 1024);
+    ~ReadBufferedLRU();
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // see SimpleLRU.h
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // see SimpleLRU.h
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // see SimpleLRU.h
+    bool Delete(const std::string &key) override;
+
+    // see SimpleLRU.h
+    bool Get(const std::string &key, std::string &value) override;
+
+    // see SimpleLRU.h
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // see SimpleLRU.h
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // see SimpleLRU.h
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // see SimpleLRU.h, KeyRef is copied into a string and passed to the methods above
+    using SimpleLRU::Delete;
+    using SimpleLRU::Get;
+    using SimpleLRU::View;
+    using SimpleLRU::MultiView;
+
+    // see SimpleLRU.h
+    void Freeze() override;
+
+    // see SimpleLRU.h
+    void Thaw() override;
+
+    // see SimpleLRU.h, hits and misses of reads are included
+    Stats GetStats() const;
+
+    // see SimpleLRU.h
+    void SetMaxSize(std::size_t max_size);
+
+    // see SimpleLRU.h
+    std::time_t Expire(const std::string &key) const;
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    // Slots in each buffer, power of two
+    static constexpr std::size_t kBufferSize = 16;
+
+    struct alignas(kCacheLine) read_buffer {
+        read_buffer() : head(0), tail(0) {}
+
+        // Slots from head to tail hold hits not applied yet, head is moved only by the drain
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+
+        std::atomic<lru_node *> slots[kBufferSize];
+    };
+
+    // Buffer of the calling thread
+    read_buffer &_Buffer() const;
+
+    // Looks key up and records the hit, returns false if there is no such key. Sets full once buffer has
+    // no room left. Must be called with the lock held shared
+    bool _Read(read_buffer &buffer, const std::string &key, const Visitor &visitor, bool &full);
+
+    // Drains buffers if the lock is free right now
+    void _TryDrain();
+
+    // Applies all recorded hits. Must be called with the lock held exclusively
+    void _Drain();
+
+    // Array of _buffer_count buffers aligned to kCacheLine
+    read_buffer *_buffers;
+    std::size_t _buffer_count;
+
+    // Lookups done under shared lock, SimpleLRU counts the rest
+    Concurrency::CoreCounter _hits;
+    Concurrency::CoreCounter _misses;
+
+    mutable Concurrency::SharedMutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_READ_BUFFERED_LRU_H
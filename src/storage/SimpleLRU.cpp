@@ -3,7 +3,9 @@
 namespace Afina {
 namespace Backend {
 
-bool SimpleLRU::_UpdateNode(SimpleLRU::lru_node_iterator &node_it, const std::string& value) {
+constexpr std::size_t SimpleLRU::kReclaimBudget;
+
+bool SimpleLRU::_UpdateNode(SimpleLRU::lru_node_iterator &node_it, const std::string& value, std::time_t expire) {
     lru_node &curr_node = node_it->second;
     if (curr_node.key.size() + value.size() > _max_size) return false;
     _MoveToHead(curr_node);
@@ -17,83 +19,325 @@ bool SimpleLRU::_UpdateNode(SimpleLRU::lru_node_iterator &node_it, const std::st
     }
     _curr_size += value.size() - curr_node.value.size();
     curr_node.value = value;
+    curr_node.cas = ++_cas;
+    _SetExpire(curr_node, expire);
     return true;
 }
 
-bool SimpleLRU::_InsertNode(const std::string &key, const std::string &value) {
+bool SimpleLRU::_InsertNode(const std::string &key, const std::string &value, std::time_t expire) {
     if (key.size() + value.size() > _max_size) return false;
     _DeleteTail(key.size() + value.size());
     std::unique_ptr<lru_node> tmp(std::move(_lru_head));
     _lru_head = std::unique_ptr<lru_node>(new lru_node(key, value, nullptr, std::move(tmp)));
     if (_lru_head->next){
         _lru_head->next->prev = _lru_head.get();
+    } else {
+        _lru_tail = _lru_head.get();
     }
     _lru_index.insert({_lru_head->key, *_lru_head});
+    _lru_head->cas = ++_cas;
+    _SetExpire(*_lru_head, expire);
     _curr_size += key.size() + value.size();
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-    auto it = _lru_index.find(key);
-    if (it != _lru_index.end()) {
-        return _UpdateNode(it, value);
+bool SimpleLRU::_ExtendNode(const std::string &key, const std::string &data, bool front) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    auto it = _Lookup(key, now);
+    if (it == _lru_index.end()) return false;
+    lru_node &curr_node = it->second;
+    if (curr_node.key.size() + curr_node.value.size() + data.size() > _max_size) return false;
+    // Same as in _UpdateNode, curr_node is in the head and is never evicted
+    _MoveToHead(curr_node);
+    _DeleteTail(data.size());
+    // String capacity grows geometrically, so appends cost O(data) amortized
+    if (front) {
+        curr_node.value.insert(0, data);
+    } else {
+        curr_node.value.append(data);
     }
-    return _InsertNode(key, value);
+    curr_node.cas = ++_cas;
+    _curr_size += data.size();
+    return true;
 }
 
+Storage::IncrResult SimpleLRU::_IncrementNode(const std::string &key, uint64_t delta, bool decrement,
+                                              uint64_t &value) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    auto it = _Lookup(key, now);
+    if (it == _lru_index.end()) return IncrResult::kNotFound;
+    const std::string &digits = it->second.get().value;
+    if (!_ApplyDelta(digits.data(), digits.size(), delta, decrement, value)) return IncrResult::kNotNumber;
+    // Short string never allocates and assignment reuses capacity of the old value
+    std::time_t expire = it->second.get().expire;
+    return _UpdateNode(it, std::to_string(value), expire) ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+// See MapBasedGlobalLockImpl.h, qualified calls as thread safe descendants hold the lock already
+bool SimpleLRU::Put(const std::string &key, const std::string &value) { return SimpleLRU::Put(key, value, 0); }
+
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    if (_lru_index.find(key) != _lru_index.end()) return false;
-    return _InsertNode(key, value);
+    return SimpleLRU::PutIfAbsent(key, value, 0);
 }
 
 // See MapBasedGlobalLockImpl.h
-bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    auto it = _lru_index.find(key);
+bool SimpleLRU::Set(const std::string &key, const std::string &value) { return SimpleLRU::Set(key, value, 0); }
+
+// See SimpleLRU.h
+bool SimpleLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    auto it = _Lookup(key, now);
+    if (expire != 0 && expire <= now) {
+        // Value is never visible, only the old one has to go
+        if (it != _lru_index.end()) {
+            _RemoveNode(it);
+        }
+        return true;
+    }
+    if (it != _lru_index.end()) {
+        return _UpdateNode(it, value, expire);
+    }
+    return _InsertNode(key, value, expire);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    if (_Lookup(key, now) != _lru_index.end()) return false;
+    if (expire != 0 && expire <= now) return true;
+    return _InsertNode(key, value, expire);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    auto it = _Lookup(key, now);
     if (it == _lru_index.end()) return false;
-    return _UpdateNode(it, value);
+    if (expire != 0 && expire <= now) {
+        _RemoveNode(it);
+        return true;
+    }
+    return _UpdateNode(it, value, expire);
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Append(const std::string &key, const std::string &data) { return _ExtendNode(key, data, false); }
+
+// See SimpleLRU.h
+bool SimpleLRU::Prepend(const std::string &key, const std::string &data) { return _ExtendNode(key, data, true); }
+
+// See SimpleLRU.h
+Storage::IncrResult SimpleLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _IncrementNode(key, delta, false, value);
+}
+
+// See SimpleLRU.h
+Storage::IncrResult SimpleLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _IncrementNode(key, delta, true, value);
 }
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Delete(const std::string &key) {
-    auto it = _lru_index.find(key);
+    auto it = _Lookup(key, _Now());
     if (it == _lru_index.end()) return false;
+    _RemoveNode(it);
+    return true;
+}
+
+void SimpleLRU::_RemoveNode(lru_node_iterator it) {
     lru_node &curr_node = it->second;
     std::unique_ptr<lru_node> curr_ptr;
+    if (&curr_node == _lru_tail) {
+        _lru_tail = curr_node.prev;
+    }
     if (!curr_node.prev) {
         curr_ptr = std::move(_lru_head);
         _lru_head = std::move(curr_node.next);
-        _lru_head->prev = nullptr;
+        if (_lru_head) {
+            _lru_head->prev = nullptr;
+        }
     }
     else {
         curr_ptr = std::move(curr_node.prev->next);
         curr_node.prev->next = std::move(curr_node.next);
-        if (curr_node.next){
-            curr_node.next->prev = curr_node.prev;
+        if (curr_node.prev->next){
+            curr_node.prev->next->prev = curr_node.prev;
         }
     }
     _curr_size -= curr_node.key.size() + curr_node.value.size();
     _lru_index.erase(it);
     curr_ptr.reset();
-    return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
-    auto it = _lru_index.find(key);
-    if (it == _lru_index.end()) return false;
+    auto it = _Lookup(key, _Now());
+    if (it == _lru_index.end()) {
+        _misses++;
+        return false;
+    }
+    _hits++;
     size_t len = it->second.get().value.size();
     value = it->second.get().value;
     return _MoveToHead(it->second);
 }
 
+// See MapBasedGlobalLockImpl.h
+bool SimpleLRU::View(const std::string &key, const Visitor &visitor) {
+    auto it = _Lookup(key, _Now());
+    if (it == _lru_index.end()) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+    const std::string &value = it->second.get().value;
+    visitor(value.data(), value.size());
+    return _MoveToHead(it->second);
+}
+
+// See MapBasedGlobalLockImpl.h
+std::size_t SimpleLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        // Qualified call, thread safe descendants hold the lock already
+        found += SimpleLRU::View(key, [&key, &visitor](const char *value, std::size_t size) {
+            visitor(key, value, size);
+        });
+    }
+    return found;
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _ViewCas(key, visitor);
+    }
+    return found;
+}
+
+// See SimpleLRU.h
+Storage::CasResult SimpleLRU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                             uint64_t cas) {
+    std::time_t now = _Now();
+    _Reclaim(now, kReclaimBudget);
+    auto it = _Lookup(key, now);
+    if (it == _lru_index.end()) {
+        return CasResult::kNotFound;
+    }
+    if (it->second.get().cas != cas) {
+        return CasResult::kExists;
+    }
+    if (expire != 0 && expire <= now) {
+        _RemoveNode(it);
+        return CasResult::kStored;
+    }
+    return _UpdateNode(it, value, expire) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See SimpleLRU.h
+bool SimpleLRU::Scan(const Scanner &scanner) {
+    std::time_t now = _Now();
+    for (lru_node *node = _lru_tail; node; node = node->prev) {
+        if (!node->Expired(now)) {
+            scanner(node->key.data(), node->key.size(), node->value.data(), node->value.size(), node->expire);
+        }
+    }
+    return true;
+}
+
+// See SimpleLRU.h
+SimpleLRU::Stats SimpleLRU::GetStats() const { return Stats{_curr_size, _max_size, _hits, _misses, _evictions}; }
+
+// See SimpleLRU.h
+void SimpleLRU::SetEvictor(Evictor evictor) { _evictor = std::move(evictor); }
+
+// See SimpleLRU.h
+std::time_t SimpleLRU::Expire(const std::string &key) const {
+    lru_node *node = _Peek(key);
+    return node ? node->expire : 0;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::SetMaxSize(std::size_t max_size) {
+    _max_size = max_size;
+    _DeleteTail(0);
+}
+
+bool SimpleLRU::_ViewCas(const std::string &key, const CasVisitor &visitor) {
+    auto it = _Lookup(key, _Now());
+    if (it == _lru_index.end()) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+    const lru_node &node = it->second;
+    visitor(key, node.value.data(), node.value.size(), node.cas);
+    return _MoveToHead(it->second);
+}
+
+// See SimpleLRU.h
+SimpleLRU::lru_node *SimpleLRU::_Peek(const std::string &key) const {
+    auto it = _lru_index.find(key);
+    if (it == _lru_index.end() || it->second.get().Expired(_Now())) {
+        return nullptr;
+    }
+    return &it->second.get();
+}
+
+std::time_t SimpleLRU::_Now() { return std::time(nullptr); }
+
+SimpleLRU::lru_node_iterator SimpleLRU::_Lookup(const std::string &key, std::time_t now) {
+    auto it = _lru_index.find(key);
+    if (it != _lru_index.end() && it->second.get().Expired(now)) {
+        _RemoveNode(it);
+        return _lru_index.end();
+    }
+    return it;
+}
+
+void SimpleLRU::_Reclaim(std::time_t now, std::size_t budget) {
+    _timers.Advance(now, budget, [this, now](const expiry &timer) {
+        // Timer could belong to a node that was removed or got an earlier timer since then
+        auto it = _lru_index.find(timer.key);
+        if (it == _lru_index.end() || &it->second.get() != timer.node || timer.node->timer != timer.deadline) {
+            return;
+        }
+        lru_node &node = it->second;
+        node.timer = 0;
+        if (node.Expired(now)) {
+            _RemoveNode(it);
+        } else {
+            // Expire time moved forward meanwhile
+            _SetExpire(node, node.expire);
+        }
+    });
+}
+
+void SimpleLRU::_SetExpire(lru_node &node, std::time_t expire) {
+    // Node has a single pending timer at most, see HashLRU::_SetExpire
+    if (expire != 0 && (node.timer == 0 || expire < node.timer)) {
+        _timers.Schedule(expire, expiry{node.key, &node, expire});
+        node.timer = expire;
+    }
+    node.expire = expire;
+}
+
 bool SimpleLRU::_MoveToHead(lru_node &node) {
     if (!node.prev) return true;
+    if (&node == _lru_tail) {
+        _lru_tail = node.prev;
+    }
     std::unique_ptr<lru_node> curr_ptr(std::move(node.prev->next));
     node.prev->next = std::move(node.next);
-    if (node.next) {
-        node.next->prev = node.prev;
+    if (node.prev->next) {
+        node.prev->next->prev = node.prev;
     }
     node.prev = nullptr;
     _lru_head->prev = curr_ptr.get();
@@ -104,12 +348,16 @@ bool SimpleLRU::_MoveToHead(lru_node &node) {
 
 void SimpleLRU::_DeleteTail(std::size_t new_size) {
     if (new_size + _curr_size > _max_size){
-        lru_node *ptr = _lru_head.get();
-        while (ptr->next) ptr = ptr->next.get();
+        lru_node *ptr = _lru_tail;
         while (ptr && new_size + _curr_size > _max_size) {
             _curr_size -= ptr->key.size() + ptr->value.size();
+            _evictions++;
+            if (_evictor && !ptr->Expired(_Now())) {
+                _evictor(ptr->key, ptr->value, ptr->expire);
+            }
             _lru_index.erase(_lru_index.find(ptr->key));
             ptr = ptr->prev;
+            _lru_tail = ptr;
             if (ptr) {
                 ptr->next.reset();
             }
@@ -1,6 +1,9 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <cstdint>
+#include <ctime>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -8,16 +11,45 @@
 
 #include <afina/Storage.h>
 
+#include "TimerWheel.h"
+
 namespace Afina {
 namespace Backend {
 
 /**
  * # Map based implementation
+ * Entry could have expire time, any access that finds it expired removes it, and TimerWheel advanced by
+ * each mutating call removes the ones nobody asks for, as HashLRU does.
+ *
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _curr_size(0) {}
+    /**
+     * Counters of the cache state, used to balance memory between StripedLRU shards
+     */
+    struct Stats {
+        // Bytes of keys and values stored and the limit on them
+        std::size_t size;
+        std::size_t max_size;
+
+        // Lookups that found/didn't find the key
+        uint64_t hits;
+        uint64_t misses;
+
+        // Entries dropped to make room for the new ones
+        uint64_t evictions;
+    };
+
+    /**
+     * Receives each entry right before it is evicted, to keep it somewhere else, along with its expire
+     * time. Expired entries are dropped without it. Must not call the storage
+     */
+    using Evictor = std::function<void(const std::string &key, const std::string &value, std::time_t expire)>;
+
+    SimpleLRU(size_t max_size = 1024)
+        : _max_size(max_size), _curr_size(0), _hits(0), _misses(0), _evictions(0), _cas(0), _lru_tail(nullptr),
+          _timers(_Now()) {}
 
     ~SimpleLRU() {
         _lru_index.clear();
@@ -43,47 +75,175 @@ public:
     // Implements Afina::Storage interface
     bool Set(const std::string &key, const std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
 
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
-private:
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Lookups by KeyRef copy key into a string, std::map can't compare it in place before C++14
+    using Storage::Delete;
+    using Storage::Get;
+    using Storage::View;
+    using Storage::MultiView;
+
+    Stats GetStats() const;
+
+    /**
+     * Changes limit on stored bytes, least recently used entries are evicted until the rest fits
+     *
+     * @param max_size new limit
+     */
+    void SetMaxSize(std::size_t max_size);
+
+    /**
+     * Sets callback evicted entries are passed to, see TieredLRU
+     */
+    void SetEvictor(Evictor evictor);
+
+    /**
+     * Returns expire time of the entry, 0 if it never expires or there is no such entry
+     */
+    std::time_t Expire(const std::string &key) const;
+
+protected:
     // LRU cache node
     using lru_node = struct lru_node {
         lru_node(const std::string &key_, const std::string &value_,
                  lru_node *prev_, std::unique_ptr<lru_node>&& next_):
-            key(key_), value(value_), prev(prev_), next(std::move(next_)) {}
+            key(key_), value(value_), cas(0), expire(0), timer(0), prev(prev_), next(std::move(next_)) {}
+
+        bool Expired(std::time_t now) const { return expire != 0 && expire <= now; }
+
         const std::string key;
         std::string value;
+
+        // Version of the value, see Storage::CompareAndSwap
+        uint64_t cas;
+
+        // Unix time entry expires at, 0 if never
+        std::time_t expire;
+
+        // Deadline of the node timer pending in _timers, 0 if there is none
+        std::time_t timer;
+
         lru_node *prev;
         std::unique_ptr<lru_node> next;
     };
 
+    // Same as View, but passes version of the value as well
+    bool _ViewCas(const std::string &key, const CasVisitor &visitor);
+
+    static std::time_t _Now();
+
+    // Returns node of the key, nullptr if there is none or it is expired. Neither order of the list nor counters
+    // are changed, so concurrent lookups are safe as long as nothing modifies the cache, see ReadBufferedLRU
+    lru_node *_Peek(const std::string &key) const;
+
+    // Moves node to the head of the list, as a hit does
+    void _Promote(lru_node *node) { _MoveToHead(*node); }
+
+private:
     using lru_node_iterator = std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>>::iterator;
 
+    // Timer wheel steps made by each mutating call
+    static constexpr std::size_t kReclaimBudget = 4;
+
+    // Timer of the node, node is only compared by address as it could be destroyed already. It is the one
+    // pending for the node if lru_node#timer is the deadline
+    struct expiry {
+        std::string key;
+        const lru_node *node;
+        std::time_t deadline;
+    };
+
+    // Same as _lru_index.find, but expired node is removed and never returned
+    lru_node_iterator _Lookup(const std::string &key, std::time_t now);
+
+    // Removes expired nodes found by the timer wheel making at most budget steps of it
+    void _Reclaim(std::time_t now, std::size_t budget);
+
+    void _SetExpire(lru_node &node, std::time_t expire);
+
+    void _RemoveNode(lru_node_iterator node_it);
+
     bool _MoveToHead(lru_node &node);
 
     void _DeleteTail(std::size_t new_size);
 
-    bool _UpdateNode(lru_node_iterator &node_it, const std::string& value);
+    bool _UpdateNode(lru_node_iterator &node_it, const std::string& value, std::time_t expire);
+
+    bool _InsertNode(const std::string &key, const std::string &value, std::time_t expire);
 
-    bool _InsertNode(const std::string &key, const std::string &value);
+    bool _ExtendNode(const std::string &key, const std::string &data, bool front);
+
+    IncrResult _IncrementNode(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
 
     // Maximum number of bytes could be stored in this cache.
     // i.e all (keys+values) must be not greater than the _max_size
     std::size_t _max_size;
     std::size_t _curr_size;
 
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+
+    // The last version given to a value
+    uint64_t _cas;
+
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
     // List owns all nodes
     std::unique_ptr<lru_node> _lru_head;
 
+    // The last node of the list above, the first one to be evicted
+    lru_node *_lru_tail;
+
+    Evictor _evictor;
+
     // Index of nodes from list above, allows fast random access to elements by lru_node#key
     std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>, std::less<std::string>> _lru_index;
+
+    // Nodes with expire time, by their lru_node#expire
+    TimerWheel<expiry> _timers;
 };
 
 } // namespace Backend
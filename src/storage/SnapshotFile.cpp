@@ -0,0 +1,185 @@
+#include "SnapshotFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Codec.h"
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+static const char kMagic[8] = {'A', 'F', 'N', 'S', 'N', 'A', 'P', '1'};
+
+// Number of entries, payload size and its CRC32C
+static constexpr std::size_t kChunkHeader = 3 * sizeof(uint32_t);
+
+static void WriteChunk(int fd, uint32_t count, const std::string &payload) {
+    std::string header;
+    PutU32(header, count);
+    PutU32(header, uint32_t(payload.size()));
+    PutU32(header, Crc32c(0, payload.data(), payload.size()));
+    WriteAll(fd, header.data(), header.size());
+    WriteAll(fd, payload.data(), payload.size());
+}
+
+// See SnapshotFile.h
+std::size_t SnapshotFile::Write(Storage &storage, const std::string &path) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to create " + tmp);
+    }
+
+    std::size_t total = 0;
+    try {
+        WriteAll(fd, kMagic, sizeof(kMagic));
+
+        std::string payload;
+        uint32_t count = 0;
+        payload.reserve(kChunkSize + 4096);
+        bool scanned = storage.Scan([&](const char *key, std::size_t key_size, const char *value,
+                                        std::size_t value_size, std::time_t expire) {
+            PutVarint(payload, key_size);
+            PutVarint(payload, value_size);
+            PutVarint(payload, uint64_t(std::max<std::time_t>(expire, 0)));
+            payload.append(key, key_size).append(value, value_size);
+            count++;
+            if (payload.size() >= kChunkSize) {
+                WriteChunk(fd, count, payload);
+                total += count;
+                payload.clear();
+                count = 0;
+            }
+        });
+        if (!scanned) {
+            throw std::runtime_error("Storage doesn't support scanning");
+        }
+        if (count > 0) {
+            WriteChunk(fd, count, payload);
+            total += count;
+        }
+
+        payload.clear();
+        PutU32(payload, uint32_t(total));
+        PutU32(payload, uint32_t(uint64_t(total) >> 32));
+        WriteChunk(fd, 0, payload);
+
+        if (fsync(fd) != 0) {
+            throw std::system_error(errno, std::system_category(), "Failed to sync snapshot");
+        }
+    } catch (...) {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+
+    close(fd);
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        throw std::system_error(errno, std::system_category(), "Failed to rename snapshot");
+    }
+    return total;
+}
+
+// See SnapshotFile.h
+SnapshotFile::LoadStats SnapshotFile::Load(Storage &storage, const std::string &path, std::size_t threads) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(kMagic)) {
+        close(fd);
+        throw std::runtime_error("Snapshot " + path + " is too short");
+    }
+
+    std::size_t size = st.st_size;
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category(), "Failed to map " + path);
+    }
+    const char *data = static_cast<const char *>(mem);
+    const char *end = data + size;
+
+    // Walk headers to find all chunks, contents are checked later by workers
+    std::vector<const char *> chunks;
+    bool complete = std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+    for (const char *pos = data + sizeof(kMagic); complete;) {
+        if (end - pos < std::ptrdiff_t(kChunkHeader) || end - pos - kChunkHeader < GetU32(pos + 4)) {
+            complete = false;
+            break;
+        }
+        if (GetU32(pos) == 0) {
+            break;
+        }
+        chunks.push_back(pos);
+        pos += kChunkHeader + GetU32(pos + 4);
+    }
+    if (!complete) {
+        munmap(mem, size);
+        throw std::runtime_error("Snapshot " + path + " is truncated or isn't a snapshot");
+    }
+
+    std::atomic<std::size_t> next(0), loaded(0), expired(0), corrupted(0);
+    std::time_t now = std::time(nullptr);
+    auto worker = [&]() {
+        std::string key, value;
+        for (std::size_t i = next++; i < chunks.size(); i = next++) {
+            const char *in = chunks[i] + kChunkHeader;
+            const char *chunk_end = in + GetU32(chunks[i] + 4);
+            if (Crc32c(0, in, chunk_end - in) != GetU32(chunks[i] + 8)) {
+                corrupted++;
+                continue;
+            }
+
+            while (in < chunk_end) {
+                uint64_t key_size, value_size, expire;
+                if (!GetVarint(in, chunk_end, key_size) || !GetVarint(in, chunk_end, value_size) ||
+                    !GetVarint(in, chunk_end, expire) || uint64_t(chunk_end - in) < key_size + value_size) {
+                    // Checksum matched, so that is a bug of the writer rather than disk corruption
+                    corrupted++;
+                    break;
+                }
+                key.assign(in, key_size);
+                value.assign(in + key_size, value_size);
+                in += key_size + value_size;
+
+                if (expire != 0 && std::time_t(expire) <= now) {
+                    expired++;
+                } else if (storage.Put(key, value, std::time_t(expire))) {
+                    loaded++;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min(threads, chunks.size()); ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    munmap(mem, size);
+
+    return LoadStats{loaded.load(), expired.load(), corrupted.load()};
+}
+
+} // namespace Backend
+} // namespace Afina
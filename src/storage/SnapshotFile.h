@@ -0,0 +1,70 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_FILE_H
+#define AFINA_STORAGE_SNAPSHOT_FILE_H
+
+#include <cstddef>
+#include <string>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Snapshot file format
+ * Binary dump of storage entries, little endian:
+ *
+ * +-------+---------+---------+-----+---------+-----------+
+ * | magic | chunk 0 | chunk 1 | ... | chunk N | end chunk |
+ * +-------+---------+---------+-----+---------+-----------+
+ *
+ * Each chunk is a header of three u32: number of entries, payload size and CRC32C of the payload, followed
+ * by the payload. Payload is a sequence of entries, each one is varint key size, varint value size, varint
+ * expire time and then key and value bytes. End chunk has no entries and its payload is u64 total number of
+ * entries, so truncated file is never taken for a complete one.
+ *
+ * Chunks are independent and about kChunkSize bytes each, so that loader could find them all by jumping
+ * over headers and then check and decode them on several threads at once.
+ */
+class SnapshotFile {
+public:
+    struct LoadStats {
+        // Entries put into the storage
+        std::size_t loaded;
+
+        // Entries which expired while snapshot was on disk
+        std::size_t expired;
+
+        // Chunks with wrong checksum, their entries are lost
+        std::size_t corrupted;
+    };
+
+    /**
+     * Writes all entries of the storage into file at path. File is written under a temporary name and
+     * renamed once it is on disk, so that a crash never leaves a half written snapshot in place. Storage
+     * must not change meanwhile, see Storage::Scan. Throws std::runtime_error on failure
+     *
+     * @param storage to scan
+     * @param path of the file to write
+     * @return number of entries written
+     */
+    static std::size_t Write(Storage &storage, const std::string &path);
+
+    /**
+     * Puts entries from the file at path into the storage using the given number of threads, storage must
+     * be thread safe if there are more than one. Throws std::runtime_error if file couldn't be read or isn't
+     * a complete snapshot
+     *
+     * @param storage to fill
+     * @param path of the file to read
+     * @param threads number of threads to decode and put entries on
+     */
+    static LoadStats Load(Storage &storage, const std::string &path, std::size_t threads);
+
+private:
+    static constexpr std::size_t kChunkSize = 1024 * 1024;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_FILE_H
@@ -0,0 +1,119 @@
+#include "Snapshotter.h"
+
+#include <cerrno>
+#include <chrono>
+#include <exception>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "SnapshotFile.h"
+
+namespace Afina {
+namespace Backend {
+
+Snapshotter::Snapshotter(std::shared_ptr<Afina::Storage> storage, const std::string &path, unsigned period,
+                         std::size_t load_threads)
+    : _storage(storage), _path(path), _period(period), _load_threads(load_threads), _child(0), _succeeded(true),
+      _running(false) {}
+
+Snapshotter::~Snapshotter() { Stop(); }
+
+// See Snapshotter.h
+void Snapshotter::Start() {
+    _storage->Start();
+    if (access(_path.c_str(), F_OK) == 0) {
+        SnapshotFile::Load(*_storage, _path, _load_threads);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_period > 0 && !_running) {
+        _running = true;
+        _thread = std::thread(&Snapshotter::_Run, this);
+    }
+}
+
+// See Snapshotter.h
+void Snapshotter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _stop.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+
+    Wait();
+    _storage->Stop();
+}
+
+// See Snapshotter.h
+bool Snapshotter::Snapshot() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_Reap(false)) {
+        return false;
+    }
+
+    // Child gets a copy of the frozen storage, so it doesn't need locks that are held by the parent threads
+    _storage->Freeze();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int status = 0;
+        try {
+            SnapshotFile::Write(*_storage, _path);
+        } catch (const std::exception &) {
+            status = 1;
+        }
+        _exit(status);
+    }
+    _storage->Thaw();
+
+    if (pid < 0) {
+        return false;
+    }
+    _child = pid;
+    return true;
+}
+
+// See Snapshotter.h
+bool Snapshotter::Wait() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _Reap(true);
+    return _succeeded;
+}
+
+void Snapshotter::_Run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        if (_stop.wait_for(lock, std::chrono::seconds(_period), [this] { return !_running; })) {
+            break;
+        }
+
+        lock.unlock();
+        Snapshot();
+        lock.lock();
+    }
+}
+
+bool Snapshotter::_Reap(bool wait) {
+    if (_child == 0) {
+        return true;
+    }
+
+    int status;
+    pid_t pid;
+    do {
+        pid = waitpid(_child, &status, wait ? 0 : WNOHANG);
+    } while (pid < 0 && errno == EINTR);
+    if (pid == 0) {
+        return false;
+    }
+
+    _succeeded = pid == _child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    _child = 0;
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,170 @@
+#ifndef AFINA_STORAGE_SNAPSHOTTER_H
+#define AFINA_STORAGE_SNAPSHOTTER_H
+
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <sys/types.h>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Background snapshots
+ * Wraps any storage backend and saves its content into SnapshotFile without stopping the service for the
+ * time of the dump. Snapshot freezes the wrapped storage for as long as fork takes, so that child gets a
+ * consistent copy of its memory, and then lets it go. Child process scans its copy and writes the file
+ * while parent keeps serving requests, the kernel copies only pages the parent changes meanwhile.
+ *
+ * Snapshot file is loaded back on Start if it exists, using load_threads threads to decode it. Snapshots
+ * are taken every period seconds if period isn't zero, and on Storage::Snapshot call. Only one snapshot is
+ * in progress at any moment.
+ *
+ * That is thread safe implementation as long as the wrapped storage is
+ */
+class Snapshotter : public Afina::Storage {
+public:
+    Snapshotter(std::shared_ptr<Afina::Storage> storage, const std::string &path, unsigned period = 0,
+                std::size_t load_threads = 1);
+    ~Snapshotter();
+
+    void Start() override;
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override {
+        return _storage->Put(key, value, expire);
+    }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override {
+        return _storage->PutIfAbsent(key, value, expire);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override {
+        return _storage->Set(key, value, expire);
+    }
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override { return _storage->Append(key, data); }
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override { return _storage->Prepend(key, data); }
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override {
+        return _storage->Increment(key, delta, value);
+    }
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override {
+        return _storage->Decrement(key, delta, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override { return _storage->View(key, visitor); }
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override { return _storage->View(key, visitor); }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override {
+        return _storage->MultiView(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override {
+        return _storage->MultiView(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override {
+        return _storage->MultiViewCas(keys, visitor);
+    }
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override {
+        return _storage->CompareAndSwap(key, value, expire, cas);
+    }
+
+    // Implements Afina::Storage interface
+    void Freeze() override { _storage->Freeze(); }
+
+    // Implements Afina::Storage interface
+    void Thaw() override { _storage->Thaw(); }
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override { return _storage->Scan(scanner); }
+
+    // Implements Afina::Storage interface
+    void Report(const Reporter &reporter) override { _storage->Report(reporter); }
+
+    // Implements Afina::Storage interface
+    bool Snapshot() override;
+
+    /**
+     * Waits for the snapshot in progress if any, returns false if it failed
+     */
+    bool Wait();
+
+private:
+    // Periodic snapshots loop
+    void _Run();
+
+    // Reaps finished child, blocks until it exits if wait is set. Returns false if there is one still running
+    bool _Reap(bool wait);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::string _path;
+    const unsigned _period;
+    const std::size_t _load_threads;
+
+    // Guards fields below
+    std::mutex _mutex;
+
+    // Child process writing snapshot, 0 if there is none
+    pid_t _child;
+
+    // Whether the last finished snapshot was written successfully
+    bool _succeeded;
+
+    bool _running;
+    std::condition_variable _stop;
+    std::thread _thread;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOTTER_H
@@ -1,5 +1,8 @@
-#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
 #include <stdexcept>
+#include <thread>
 
 #include "StripedLRU.h"
 
@@ -7,45 +10,318 @@ namespace Afina {
 namespace Backend {
 
 StripedLRU StripedLRU::Create_StripedLRU(size_t memory_limit, size_t stripe_count) {
-    size_t stripe_limit = memory_limit / stripe_count;
+    size_t count = 1;
+    if (stripe_count == 0) {
+        // Twice as many stripes as cores makes collisions of concurrent writers rare
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        while (count < 2 * cores && memory_limit / (2 * count) >= 1024) {
+            count *= 2;
+        }
+    } else {
+        while (count < stripe_count) {
+            count *= 2;
+        }
+    }
+
+    size_t stripe_limit = memory_limit / count;
     if (stripe_limit < 1024) {
         throw std::runtime_error("Cache size of each shard is too small (less than 1Kb)");
     }
-    return StripedLRU(stripe_limit, stripe_count);
+    return StripedLRU(stripe_limit, count);
 }
 
-StripedLRU::StripedLRU(StripedLRU&& other): _shards(std::move(other._shards)) {}
+StripedLRU::StripedLRU(StripedLRU&& other)
+    : _stripes(other._stripes), _stripe_count(other._stripe_count), _stripe_limit(other._stripe_limit),
+      _min_limit(other._min_limit), _pool(other._pool), _last(std::move(other._last)) {
+    other._stripes = nullptr;
+    other._stripe_count = 0;
+}
 
 
-StripedLRU::StripedLRU (size_t stripe_limit, size_t stripe_count) {
-    _shards.reserve(stripe_count);
+StripedLRU::StripedLRU (size_t stripe_limit, size_t stripe_count)
+    : _stripe_count(stripe_count), _stripe_limit(stripe_limit),
+      _min_limit(std::max<size_t>(stripe_limit / 4, 1024)), _pool(0) {
+    // new doesn't respect alignment above the fundamental one until C++17
+    void *mem = nullptr;
+    if (posix_memalign(&mem, kCacheLine, sizeof(stripe) * stripe_count) != 0) {
+        throw std::bad_alloc();
+    }
+    _stripes = static_cast<stripe *>(mem);
     for (size_t i = 0; i < stripe_count; ++i){
-        _shards.emplace_back(new ThreadSafeSimplLRU(stripe_limit));
+        new (&_stripes[i]) stripe(stripe_limit);
     }
+    _last = GetShardStats();
+}
+
+StripedLRU::~StripedLRU() {
+    for (size_t i = 0; i < _stripe_count; ++i) {
+        _stripes[i].~stripe();
+    }
+    std::free(_stripes);
 }
 
 bool StripedLRU::Put(const std::string &key, const std::string &value) {
-    return _shards[_GetShardNum(key)]->Put(key, value);
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Put(key, value);
+    _OnWrite(s);
+    return result;
 }
 
 bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    return _shards[_GetShardNum(key)]->PutIfAbsent(key, value);
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.PutIfAbsent(key, value);
+    _OnWrite(s);
+    return result;
 }
 
 bool StripedLRU::Set(const std::string &key, const std::string &value) {
-    return _shards[_GetShardNum(key)]->Set(key, value);
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Set(key, value);
+    _OnWrite(s);
+    return result;
+}
+
+bool StripedLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Put(key, value, expire);
+    _OnWrite(s);
+    return result;
+}
+
+bool StripedLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.PutIfAbsent(key, value, expire);
+    _OnWrite(s);
+    return result;
+}
+
+bool StripedLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Set(key, value, expire);
+    _OnWrite(s);
+    return result;
+}
+
+bool StripedLRU::Append(const std::string &key, const std::string &data) {
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Append(key, data);
+    _OnWrite(s);
+    return result;
+}
+
+bool StripedLRU::Prepend(const std::string &key, const std::string &data) {
+    stripe &s = _StripeOf(key);
+    bool result = s.lru.Prepend(key, data);
+    _OnWrite(s);
+    return result;
+}
+
+Storage::IncrResult StripedLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    stripe &s = _StripeOf(key);
+    IncrResult result = s.lru.Increment(key, delta, value);
+    _OnWrite(s);
+    return result;
+}
+
+Storage::IncrResult StripedLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    stripe &s = _StripeOf(key);
+    IncrResult result = s.lru.Decrement(key, delta, value);
+    _OnWrite(s);
+    return result;
 }
 
 bool StripedLRU::Delete(const std::string &key) {
-    return _shards[_GetShardNum(key)]->Delete(key);
+    return _StripeOf(key).lru.Delete(key);
+}
+
+bool StripedLRU::Delete(const KeyRef &key) {
+    return _StripeOf(key).lru.Delete(key.str());
 }
 
 bool StripedLRU::Get(const std::string &key, std::string &value) {
-    return _shards[_GetShardNum(key)]->Get(key, value);
+    return _StripeOf(key).lru.Get(key, value);
+}
+
+bool StripedLRU::Get(const KeyRef &key, std::string &value) {
+    return _StripeOf(key).lru.Get(key.str(), value);
+}
+
+bool StripedLRU::View(const std::string &key, const Visitor &visitor) {
+    return _StripeOf(key).lru.View(key, visitor);
+}
+
+bool StripedLRU::View(const KeyRef &key, const Visitor &visitor) {
+    return _StripeOf(key).lru.View(key.str(), visitor);
+}
+
+std::size_t StripedLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    // Group keys by shard, so that each shard lock is taken once per request rather than once per key
+    std::vector<std::vector<const std::string *>> groups(_stripe_count);
+    for (auto &key : keys) {
+        groups[&_StripeOf(key) - _stripes].push_back(&key);
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        if (!groups[i].empty()) {
+            found += _stripes[i].lru.MultiView(groups[i], visitor);
+        }
+    }
+    return found;
+}
+
+std::size_t StripedLRU::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    // Same grouping as above, but stripe is picked by the hash that came with the key
+    std::vector<std::vector<const KeyRef *>> groups(_stripe_count);
+    for (auto &key : keys) {
+        groups[&_StripeOf(key) - _stripes].push_back(&key);
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        if (!groups[i].empty()) {
+            found += _stripes[i].lru.MultiView(groups[i], visitor);
+        }
+    }
+    return found;
+}
+
+std::size_t StripedLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    // Versions are counted by each shard on its own, key never moves between shards anyway
+    std::vector<std::vector<const std::string *>> groups(_stripe_count);
+    for (auto &key : keys) {
+        groups[&_StripeOf(key) - _stripes].push_back(&key);
+    }
+
+    std::size_t found = 0;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        if (!groups[i].empty()) {
+            found += _stripes[i].lru.MultiViewCas(groups[i], visitor);
+        }
+    }
+    return found;
+}
+
+Storage::CasResult StripedLRU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                              uint64_t cas) {
+    stripe &s = _StripeOf(key);
+    CasResult result = s.lru.CompareAndSwap(key, value, expire, cas);
+    _OnWrite(s);
+    return result;
+}
+
+void StripedLRU::Freeze() {
+    _rebalance_mutex.lock();
+    for (size_t i = 0; i < _stripe_count; ++i) {
+        _stripes[i].lru.Freeze();
+    }
+}
+
+void StripedLRU::Thaw() {
+    for (size_t i = _stripe_count; i > 0; --i) {
+        _stripes[i - 1].lru.Thaw();
+    }
+    _rebalance_mutex.unlock();
+}
+
+bool StripedLRU::Scan(const Scanner &scanner) {
+    for (size_t i = 0; i < _stripe_count; ++i) {
+        _stripes[i].lru.Scan(scanner);
+    }
+    return true;
+}
+
+std::vector<SimpleLRU::Stats> StripedLRU::GetShardStats() const {
+    std::vector<SimpleLRU::Stats> stats;
+    stats.reserve(_stripe_count);
+    for (size_t i = 0; i < _stripe_count; ++i) {
+        stats.push_back(_stripes[i].lru.GetStats());
+    }
+    return stats;
+}
+
+void StripedLRU::Rebalance() {
+    std::unique_lock<std::mutex> lock(_rebalance_mutex);
+    _Rebalance();
+}
+
+void StripedLRU::_OnWrite(stripe &s) {
+    // Each stripe counts own writes, shared counter would be the very cache line all writers fight for
+    size_t every = std::max<size_t>(kRebalanceEvery / _stripe_count, 1);
+    if (s.writes.fetch_add(1, std::memory_order_relaxed) % every != every - 1) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_rebalance_mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        _Rebalance();
+    }
 }
 
-size_t StripedLRU::_GetShardNum(const std::string &key) {
-    return std::hash<std::string>{}(key) % _shards.size();
+void StripedLRU::_Rebalance() {
+    // Shards keep working meanwhile, so counters are a bit stale by the time limits change. That is fine,
+    // each shard limit is changed under its own lock and only by this thread
+    std::vector<SimpleLRU::Stats> stats = GetShardStats();
+    std::vector<uint64_t> evictions(stats.size()), hits(stats.size());
+    uint64_t total_evictions = 0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        evictions[i] = stats[i].evictions - _last[i].evictions;
+        hits[i] = stats[i].hits - _last[i].hits;
+        total_evictions += evictions[i];
+    }
+
+    if (total_evictions == 0) {
+        // Nobody needs more room, leave limits alone
+        _last = std::move(stats);
+        return;
+    }
+
+    // Calm shards return half of the room they don't use
+    for (size_t i = 0; i < stats.size(); ++i) {
+        if (evictions[i] > 0 || stats[i].max_size <= _min_limit) {
+            continue;
+        }
+        size_t unused = stats[i].max_size > stats[i].size ? stats[i].max_size - stats[i].size : 0;
+        size_t give = std::min(unused / 2, stats[i].max_size - _min_limit);
+        if (give > 0) {
+            stats[i].max_size -= give;
+            _stripes[i].lru.SetMaxSize(stats[i].max_size);
+            _pool += give;
+        }
+    }
+
+    if (_pool > 0) {
+        // Pressed shards borrow the pool in proportion to their evictions
+        size_t pool = _pool;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            size_t take = pool * evictions[i] / total_evictions;
+            if (take > 0) {
+                stats[i].max_size += take;
+                _stripes[i].lru.SetMaxSize(stats[i].max_size);
+                _pool -= take;
+            }
+        }
+    } else {
+        // Nothing to borrow, take a step from the shard which is the least pressed and the least used
+        size_t step = _stripe_limit / kRebalanceSteps;
+        size_t hot = std::max_element(evictions.begin(), evictions.end()) - evictions.begin();
+        size_t donor = stats.size();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            if (i == hot || stats[i].max_size < _min_limit + step || evictions[i] * 2 >= evictions[hot]) {
+                continue;
+            }
+            if (donor == stats.size() || evictions[i] < evictions[donor] ||
+                (evictions[i] == evictions[donor] && hits[i] < hits[donor])) {
+                donor = i;
+            }
+        }
+        if (donor < stats.size() && step > 0) {
+            _stripes[donor].lru.SetMaxSize(stats[donor].max_size - step);
+            _stripes[hot].lru.SetMaxSize(stats[hot].max_size + step);
+        }
+    }
+
+    // Evictions made by shrinking above belong to this round, not to the next one
+    _last = GetShardStats();
 }
 
 } // namespace Backend
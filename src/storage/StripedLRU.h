@@ -1,19 +1,47 @@
 #ifndef AFINA_STORAGE_STRIPED_LRU_H
 #define AFINA_STORAGE_STRIPED_LRU_H
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 
 #include "afina/Storage.h"
+#include "KeyHash.h"
 #include "ThreadSafeSimpleLRU.h"
 
 namespace Afina {
 namespace Backend {
 
+/**
+ * # Sharded LRU with adaptive memory budget
+ * Keys are spread over stripe_count ThreadSafeSimplLRU shards by hash, each shard has own lock. Memory
+ * limit is split evenly at start, but with skewed keys one shard could thrash while others sit half
+ * empty. So every kRebalanceEvery writes, if any shard had to evict, budgets are rebalanced against a global
+ * pool:
+ * - shards that didn't evict anything since the last round return half of their unused room to the pool
+ * - shards that evicted borrow everything in the pool, in proportion to their evictions
+ * - if pool is empty and the most pressed shard evicts twice as much as another one, the latter gives it a
+ *   step of budget, shard with fewer hits is preferred as the donor
+ *
+ * Sum of shard limits and the pool always equals memory_limit, and no shard goes below a quarter of the
+ * initial share.
+ *
+ * Number of stripes is a power of two, so that stripe is picked by a mask over HashKey (hardware CRC32C)
+ * instead of a division over std::hash. By default it is twice the number of cores, as long as each
+ * stripe gets at least 1Kb. Stripes lay in one array aligned to cache lines, each one padded to whole
+ * lines, so that lock of one stripe never shares a line with its neighbours. Key that comes as KeyRef
+ * picks its stripe by the hash it carries, without hashing it again.
+ */
 class StripedLRU: public Afina::Storage {
 public:
-    static StripedLRU Create_StripedLRU(size_t memory_limit = 4 * 1024, size_t stripe_count = 4);
-    
-    ~StripedLRU() = default;
+    /**
+     * @param memory_limit total budget of all stripes
+     * @param stripe_count number of stripes rounded up to a power of two, 0 means derive it from core count
+     */
+    static StripedLRU Create_StripedLRU(size_t memory_limit = 4 * 1024, size_t stripe_count = 0);
+
+    ~StripedLRU();
 
     StripedLRU(StripedLRU&& other);
 
@@ -26,19 +54,118 @@ public:
     // Implements Afina::Storage interface
     bool Set(const std::string &key, const std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
 
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    void Freeze() override;
+
+    // Implements Afina::Storage interface
+    void Thaw() override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Size, limit, hit and eviction counters of each shard
+    std::vector<SimpleLRU::Stats> GetShardStats() const;
+
+    // Runs a round of budget balancing right away, see class description
+    void Rebalance();
+
+    size_t stripe_count() const { return _stripe_count; }
+
 private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    // Writes between balancing rounds, counted by each stripe on its own
+    static constexpr std::size_t kRebalanceEvery = 4096;
+
+    // Budget moved between two shards at once is the initial share divided by that
+    static constexpr std::size_t kRebalanceSteps = 16;
+
+    struct alignas(kCacheLine) stripe {
+        explicit stripe(size_t limit) : lru(limit), writes(0) {}
+
+        ThreadSafeSimplLRU lru;
+        std::atomic<size_t> writes;
+    };
 
     StripedLRU(size_t stripe_limit, size_t stripe_count);
 
-    size_t _GetShardNum(const std::string &key);
+    stripe &_StripeOf(const std::string &key) { return _stripes[HashKey(key) & (_stripe_count - 1)]; }
+
+    stripe &_StripeOf(const KeyRef &key) { return _stripes[key.hash & (_stripe_count - 1)]; }
+
+    // Counts write and runs balancing round once in a while, unless another thread is doing it already
+    void _OnWrite(stripe &s);
+
+    void _Rebalance();
+
+    // Array of _stripe_count stripes aligned to kCacheLine
+    stripe *_stripes;
+    size_t _stripe_count;
+
+    // Initial budget of each shard and the lowest one it could get
+    size_t _stripe_limit;
+    size_t _min_limit;
+
+    // Guards everything below
+    std::mutex _rebalance_mutex;
+
+    // Budget not assigned to any shard
+    size_t _pool;
 
-    std::vector<std::unique_ptr<ThreadSafeSimplLRU>> _shards;
+    // Counters at the end of the last round
+    std::vector<SimpleLRU::Stats> _last;
 };
 
 } // namespace Backend
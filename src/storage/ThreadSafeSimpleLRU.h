@@ -4,6 +4,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "SimpleLRU.h"
 
@@ -38,6 +39,48 @@ public:
         return SimpleLRU::Set(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Put(key, value, expire);
+    }
+
+    // see SimpleLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::PutIfAbsent(key, value, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Set(key, value, expire);
+    }
+
+    // see SimpleLRU.h
+    bool Append(const std::string &key, const std::string &data) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Append(key, data);
+    }
+
+    // see SimpleLRU.h
+    bool Prepend(const std::string &key, const std::string &data) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Prepend(key, data);
+    }
+
+    // see SimpleLRU.h
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Increment(key, delta, value);
+    }
+
+    // see SimpleLRU.h
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Decrement(key, delta, value);
+    }
+
     // see SimpleLRU.h
     bool Delete(const std::string &key) override {
         std::unique_lock<std::mutex> lock(_mutex);
@@ -50,8 +93,100 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool View(const std::string &key, const Visitor &visitor) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::View(key, visitor);
+    }
+
+    // see SimpleLRU.h
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::MultiView(keys, visitor);
+    }
+
+    // see SimpleLRU.h
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::MultiViewCas(keys, visitor);
+    }
+
+    // see SimpleLRU.h
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::CompareAndSwap(key, value, expire, cas);
+    }
+
+    // see SimpleLRU.h, KeyRef is copied into a string and passed to the locked methods above
+    using SimpleLRU::Delete;
+    using SimpleLRU::Get;
+    using SimpleLRU::View;
+    using SimpleLRU::MultiView;
+
+    // see SimpleLRU.h
+    void Freeze() override { _mutex.lock(); }
+
+    // see SimpleLRU.h
+    void Thaw() override { _mutex.unlock(); }
+
+    /**
+     * Same as MultiView, but keys are given by pointers, so that a caller could pass a subset of its own
+     * keys without copying them. All keys are looked up under a single lock acquisition
+     */
+    std::size_t MultiView(const std::vector<const std::string *> &keys, const MultiVisitor &visitor) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::size_t found = 0;
+        for (const std::string *key : keys) {
+            found += SimpleLRU::View(*key, [key, &visitor](const char *value, std::size_t size) {
+                visitor(*key, value, size);
+            });
+        }
+        return found;
+    }
+
+    // Same as MultiView above, for keys passed by reference
+    std::size_t MultiView(const std::vector<const KeyRef *> &keys, const RefVisitor &visitor) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::size_t found = 0;
+        for (const KeyRef *key : keys) {
+            found += SimpleLRU::View(key->str(), [key, &visitor](const char *value, std::size_t size) {
+                visitor(*key, value, size);
+            });
+        }
+        return found;
+    }
+
+    // Same as MultiView above, but passes versions of values as well
+    std::size_t MultiViewCas(const std::vector<const std::string *> &keys, const CasVisitor &visitor) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::size_t found = 0;
+        for (const std::string *key : keys) {
+            found += _ViewCas(*key, visitor);
+        }
+        return found;
+    }
+
+    // see SimpleLRU.h
+    Stats GetStats() const {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::GetStats();
+    }
+
+    // see SimpleLRU.h
+    void SetMaxSize(std::size_t max_size) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        SimpleLRU::SetMaxSize(max_size);
+    }
+
+    // see SimpleLRU.h
+    std::time_t Expire(const std::string &key) const {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return SimpleLRU::Expire(key);
+    }
+
 private:
-    std::mutex _mutex;
+    mutable std::mutex _mutex;
 };
 
 } // namespace Backend
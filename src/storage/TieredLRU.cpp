@@ -0,0 +1,307 @@
+#include "TieredLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+TieredLRU::TieredLRU(const std::string &path, std::size_t ram_size, std::size_t disk_size, std::size_t extent_size)
+    : _disk(path, disk_size, extent_size), _ram(ram_size), _ram_hits(0), _ram_misses(0), _disk_hits(0),
+      _disk_misses(0), _demotions(0), _promotions(0) {
+    _ram.SetEvictor([this](const std::string &key, const std::string &value, std::time_t expire) {
+        _demotions += _disk.Put(key, value, expire);
+    });
+}
+
+// See TieredLRU.h
+bool TieredLRU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0); }
+
+// See TieredLRU.h
+bool TieredLRU::PutIfAbsent(const std::string &key, const std::string &value) { return PutIfAbsent(key, value, 0); }
+
+// See TieredLRU.h
+bool TieredLRU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0); }
+
+// See TieredLRU.h
+bool TieredLRU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _Put(key, value, expire);
+}
+
+// See TieredLRU.h
+bool TieredLRU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_disk.Contains(key)) {
+        return false;
+    }
+    if (_ram.PutIfAbsent(key, value, expire)) {
+        return true;
+    }
+
+    // Either key is in RAM already or the entry doesn't fit there
+    return !_ram.View(key, [](const char *, std::size_t) {}) && _disk.Put(key, value, expire);
+}
+
+// See TieredLRU.h
+bool TieredLRU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_ram.Set(key, value, expire)) {
+        return true;
+    }
+
+    // Either key isn't in RAM or the new value doesn't fit there
+    if (!_disk.Contains(key) && !_ram.View(key, [](const char *, std::size_t) {})) {
+        return false;
+    }
+    return _Put(key, value, expire);
+}
+
+// See TieredLRU.h
+bool TieredLRU::Append(const std::string &key, const std::string &data) { return _Extend(key, data, false); }
+
+// See TieredLRU.h
+bool TieredLRU::Prepend(const std::string &key, const std::string &data) { return _Extend(key, data, true); }
+
+// See TieredLRU.h
+Storage::IncrResult TieredLRU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, false, value);
+}
+
+// See TieredLRU.h
+Storage::IncrResult TieredLRU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, true, value);
+}
+
+// See TieredLRU.h
+bool TieredLRU::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool ram = _ram.Delete(key);
+    return _disk.Delete(key) || ram;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Get(const std::string &key, std::string &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_ram.Get(key, value)) {
+        _ram_hits++;
+        return true;
+    }
+    _ram_misses++;
+
+    std::vector<cold_entry> read;
+    _ReadCold(lock, std::vector<std::string>(1, key), read);
+    if (read.empty()) {
+        _disk_misses++;
+        return false;
+    }
+    _disk_hits++;
+    value = std::move(read[0].value);
+    if (!read[0].hot) {
+        _Promote(key, value, read[0].expire);
+    }
+    return true;
+}
+
+// See TieredLRU.h
+bool TieredLRU::View(const std::string &key, const Visitor &visitor) {
+    std::string value;
+    if (!Get(key, value)) {
+        return false;
+    }
+    visitor(value.data(), value.size());
+    return true;
+}
+
+// See TieredLRU.h
+std::size_t TieredLRU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t found = 0;
+    std::vector<std::string> cold;
+    for (auto &key : keys) {
+        bool hit = _ram.View(key, [&key, &visitor](const char *value, std::size_t size) { visitor(key, value, size); });
+        if (hit) {
+            _ram_hits++;
+            found++;
+        } else {
+            _ram_misses++;
+            cold.push_back(key);
+        }
+    }
+    if (cold.empty()) {
+        return found;
+    }
+
+    // Promotion could demote other cold keys of the batch, so entries are taken out of the file first
+    std::vector<cold_entry> read;
+    _ReadCold(lock, cold, read);
+    _disk_hits += read.size();
+    _disk_misses += cold.size() - read.size();
+    for (auto &entry : read) {
+        visitor(entry.key, entry.value.data(), entry.value.size());
+        if (!entry.hot) {
+            _Promote(entry.key, entry.value, entry.expire);
+        }
+    }
+    return found + read.size();
+}
+
+// See TieredLRU.h
+std::size_t TieredLRU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t found = 0;
+    std::vector<std::string> one(1), cold;
+    for (auto &key : keys) {
+        one[0] = key;
+        if (_ram.MultiViewCas(one, visitor) > 0) {
+            _ram_hits++;
+            found++;
+        } else {
+            _ram_misses++;
+            cold.push_back(key);
+        }
+    }
+    if (cold.empty()) {
+        return found;
+    }
+
+    // Version is known once entry settles in its tier, so visitor is called after promotion
+    std::vector<cold_entry> read;
+    _ReadCold(lock, cold, read);
+    _disk_hits += read.size();
+    _disk_misses += cold.size() - read.size();
+    for (auto &entry : read) {
+        if (!entry.hot) {
+            _Promote(entry.key, entry.value, entry.expire);
+        }
+        one[0] = entry.key;
+        if (_ram.MultiViewCas(one, visitor) == 0) {
+            visitor(entry.key, entry.value.data(), entry.value.size(), _disk.Version(entry.key));
+        }
+    }
+    return found + read.size();
+}
+
+// See TieredLRU.h
+Storage::CasResult TieredLRU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                             uint64_t cas) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    CasResult result = _ram.CompareAndSwap(key, value, expire, cas);
+    if (result == CasResult::kNotFound) {
+        if (!_disk.Contains(key)) {
+            return CasResult::kNotFound;
+        }
+        if (_disk.Version(key) != cas) {
+            return CasResult::kExists;
+        }
+    } else if (result != CasResult::kNotStored) {
+        return result;
+    }
+
+    // Versions matched, but either key is cold or the new value doesn't fit RAM
+    return _Put(key, value, expire) ? CasResult::kStored : CasResult::kNotStored;
+}
+
+// See TieredLRU.h
+bool TieredLRU::Scan(const Scanner &scanner) {
+    // Colder entries go first, as SimpleLRU does
+    return _disk.Scan(scanner) && _ram.Scan(scanner);
+}
+
+// See TieredLRU.h
+TieredLRU::Stats TieredLRU::GetStats() const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return Stats{_ram_hits, _ram_misses, _disk_hits, _disk_misses, _demotions, _promotions, _disk.GetStats()};
+}
+
+bool TieredLRU::_Put(const std::string &key, const std::string &value, std::time_t expire) {
+    if (_ram.Put(key, value, expire)) {
+        _disk.Delete(key);
+        return true;
+    }
+    _ram.Delete(key);
+    return _disk.Put(key, value, expire);
+}
+
+bool TieredLRU::_Extend(const std::string &key, const std::string &data, bool front) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (front ? _ram.Prepend(key, data) : _ram.Append(key, data)) {
+        return true;
+    }
+
+    // Either key is cold or the value outgrows RAM
+    std::string value;
+    std::time_t expire;
+    if (_disk.Get(key, value)) {
+        expire = _disk.Expire(key);
+    } else if (_ram.Get(key, value)) {
+        expire = _ram.Expire(key);
+    } else {
+        return false;
+    }
+    return _Put(key, front ? data + value : value + data, expire);
+}
+
+Storage::IncrResult TieredLRU::_Increment(const std::string &key, uint64_t delta, bool decrement,
+                                          uint64_t &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    IncrResult result = decrement ? _ram.Decrement(key, delta, value) : _ram.Increment(key, delta, value);
+    std::time_t expire;
+    if (result == IncrResult::kNotFound) {
+        // Counter is cold
+        std::string old;
+        if (!_disk.Get(key, old)) {
+            return IncrResult::kNotFound;
+        }
+        if (!_ApplyDelta(old.data(), old.size(), delta, decrement, value)) {
+            return IncrResult::kNotNumber;
+        }
+        expire = _disk.Expire(key);
+    } else if (result != IncrResult::kNotStored) {
+        return result;
+    } else {
+        expire = _ram.Expire(key);
+    }
+
+    // New counter is known, but either it is cold or its digits don't fit RAM
+    return _Put(key, std::to_string(value), expire) ? IncrResult::kUpdated : IncrResult::kNotStored;
+}
+
+void TieredLRU::_ReadCold(std::unique_lock<std::mutex> &lock, const std::vector<std::string> &keys,
+                          std::vector<cold_entry> &read) {
+    std::vector<ExtentStore::Fetch> fetches(keys.size());
+    std::size_t located = 0;
+    for (auto &key : keys) {
+        located += _disk.Locate(key, fetches[located]);
+    }
+    fetches.resize(located);
+    if (fetches.empty()) {
+        return;
+    }
+
+    // Load doesn't touch the store, so others go on while the disk is busy
+    lock.unlock();
+    _disk.Load(fetches);
+    lock.lock();
+
+    std::string value;
+    for (auto &fetch : fetches) {
+        if (_disk.Take(fetch, value)) {
+            read.push_back(cold_entry{fetch.key, value, fetch.expire, false});
+        } else if (_disk.Get(fetch.key, value)) {
+            // Entry was stored again or moved by compaction meanwhile
+            read.push_back(cold_entry{fetch.key, value, _disk.Expire(fetch.key), false});
+        } else if (_ram.Get(fetch.key, value)) {
+            // Another lookup has promoted it or a writer has put it into RAM
+            read.push_back(cold_entry{fetch.key, value, _ram.Expire(fetch.key), true});
+        }
+    }
+}
+
+void TieredLRU::_Promote(const std::string &key, const std::string &value, std::time_t expire) {
+    // Entry that doesn't fit RAM stays in the file
+    if (_ram.Put(key, value, expire)) {
+        _disk.Delete(key);
+        _promotions++;
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,176 @@
+#ifndef AFINA_STORAGE_TIERED_LRU_H
+#define AFINA_STORAGE_TIERED_LRU_H
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "ExtentStore.h"
+#include "SimpleLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Two-tier cache: RAM LRU in front of a file
+ * Hot entries live in SimpleLRU of ram_size bytes. Entry evicted from it isn't lost but demoted to
+ * ExtentStore, a log structured file of disk_size bytes, so that the cache holds much more than fits
+ * into memory. Lookup missing RAM goes to the file, entry found there is promoted back into RAM.
+ *
+ * Each key is in one tier at most. MultiView reads all cold keys of the batch from the file at once with
+ * asynchronous I/O, single lookups read synchronously.
+ *
+ * Entry too big for RAM goes to the file directly. Expire time follows entry between tiers, each tier
+ * drops expired entries on its own, see SimpleLRU and ExtentStore.
+ *
+ * Version of a RAM entry is the one SimpleLRU keeps, entry that stays in the file is versioned by its
+ * record place, see ExtentStore::Version. Either way it changes when the entry moves between tiers.
+ *
+ * That is thread safe implementation, all operations are serialized on a single mutex. Lookups release it
+ * while they wait for the file, see ExtentStore::Locate
+ */
+class TieredLRU : public Afina::Storage {
+public:
+    /**
+     * Per tier lookup counters and movements between tiers
+     */
+    struct Stats {
+        uint64_t ram_hits;
+        uint64_t ram_misses;
+
+        // Lookups that missed RAM and were served/not served by the file
+        uint64_t disk_hits;
+        uint64_t disk_misses;
+
+        // Entries moved from RAM to the file and back
+        uint64_t demotions;
+        uint64_t promotions;
+
+        ExtentStore::Stats disk;
+    };
+
+    /**
+     * @param path of the file for cold entries, it is truncated
+     * @param ram_size bytes of keys and values kept in memory
+     * @param disk_size bytes of the file
+     * @param extent_size bytes of file extent, see ExtentStore
+     */
+    TieredLRU(const std::string &path, std::size_t ram_size, std::size_t disk_size,
+              std::size_t extent_size = ExtentStore::kDefaultExtentSize);
+    ~TieredLRU() {}
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    void Freeze() override { _mutex.lock(); }
+
+    // Implements Afina::Storage interface
+    void Thaw() override { _mutex.unlock(); }
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Lookups by KeyRef copy key into a string, both tiers are indexed by std::string
+    using Storage::Delete;
+    using Storage::Get;
+    using Storage::View;
+    using Storage::MultiView;
+
+    Stats GetStats() const;
+
+private:
+    // Entry read from the file
+    struct cold_entry {
+        std::string key;
+        std::string value;
+        std::time_t expire;
+
+        // Entry was promoted by another lookup while the file was read, it is in RAM already
+        bool hot;
+    };
+
+    // Reads entries of the keys from the file. Lock is released while the disk is busy, entry that has
+    // changed meanwhile is looked up again in both tiers
+    void _ReadCold(std::unique_lock<std::mutex> &lock, const std::vector<std::string> &keys,
+                   std::vector<cold_entry> &read);
+
+    // Stores entry into RAM, or into the file if it doesn't fit RAM
+    bool _Put(const std::string &key, const std::string &value, std::time_t expire);
+
+    // Extends value in place if it is in RAM and still fits there, otherwise stores the extended copy
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Changes counter in place if it is in RAM, otherwise stores the new one
+    IncrResult _Increment(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Moves entry just read from the file into RAM
+    void _Promote(const std::string &key, const std::string &value, std::time_t expire);
+
+    ExtentStore _disk;
+    SimpleLRU _ram;
+
+    uint64_t _ram_hits;
+    uint64_t _ram_misses;
+    uint64_t _disk_hits;
+    uint64_t _disk_misses;
+    uint64_t _demotions;
+    uint64_t _promotions;
+
+    mutable std::mutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIERED_LRU_H
@@ -0,0 +1,126 @@
+#ifndef AFINA_STORAGE_TIMER_WHEEL_H
+#define AFINA_STORAGE_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hierarchical timer wheel
+ * Keeps values scheduled to fire at some tick (one tick is one second for storages) and hands them back
+ * once time reaches that tick. There are kLevels wheels of kSlots slots each, slot of level N spans
+ * kSlots^N ticks. Value lands into the lowest level which covers distance to its deadline, so Schedule
+ * costs O(1) regardless of how far deadline is. Each time lower level wheel makes a full turn, the next
+ * slot of upper level is cascaded: its values are scheduled again and fall into lower levels, and
+ * eventually into level 0 slot which fires exactly at the deadline tick.
+ *
+ * Wheel doesn't support cancellation, owner is expected to validate fired value, i.e check that the
+ * thing it refers to still exists and is still due.
+ *
+ * All the work is done by Advance in bounded slices: each step fires one value, moves one value during
+ * cascade or moves time forward to the next tick that has something to do, but by at most kSlots ticks.
+ * So catching up after a long pause or draining a crowded slot never blocks the owner for long, the rest
+ * is picked up by the next calls.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+template <typename T> class TimerWheel {
+public:
+    TimerWheel(uint64_t now) : _tick(now), _collected(false), _cascade_level(0) {}
+
+    /**
+     * Schedules value to fire at the given tick, ticks which already passed fire on the next Advance
+     */
+    void Schedule(uint64_t deadline, const T &value) {
+        if (deadline < _tick || (deadline == _tick && _collected)) {
+            _due.push_back(timer{deadline, value});
+            return;
+        }
+
+        uint64_t distance = deadline - _tick;
+        for (std::size_t level = 0; level < kLevels; ++level) {
+            if (distance < (uint64_t(1) << (kLevelBits * (level + 1)))) {
+                _wheel[level][(deadline >> (kLevelBits * level)) & kSlotMask].push_back(timer{deadline, value});
+                return;
+            }
+        }
+
+        // Too far for the whole wheel: park in the top level slot which cascades last and reschedule from there
+        std::size_t last = ((_tick >> (kLevelBits * (kLevels - 1))) + kSlots - 1) & kSlotMask;
+        _wheel[kLevels - 1][last].push_back(timer{deadline, value});
+    }
+
+    /**
+     * Moves time forward to now making at most budget steps, calls fire(value) for each value which is
+     * due. Returns true if wheel caught up with now and has nothing else due
+     */
+    template <typename F> bool Advance(uint64_t now, std::size_t budget, F fire) {
+        for (; budget > 0; --budget) {
+            if (!_cascade.empty()) {
+                timer t = _cascade.back();
+                _cascade.pop_back();
+                Schedule(t.deadline, t.value);
+            } else if (_cascade_level > 0) {
+                // Upper levels go first, so that values fall through all of them in the same tick
+                _cascade.swap(_wheel[_cascade_level][(_tick >> (kLevelBits * _cascade_level)) & kSlotMask]);
+                _cascade_level--;
+            } else if (!_due.empty()) {
+                timer t = _due.back();
+                _due.pop_back();
+                fire(t.value);
+            } else if (!_collected) {
+                _due.swap(_wheel[0][_tick & kSlotMask]);
+                _collected = true;
+            } else if (_tick < now) {
+                // Ticks with nothing to fire or cascade are passed at once, up to a level 0 turn per step
+                do {
+                    _tick++;
+                } while (_tick < now && (_tick & kSlotMask) != 0 && _wheel[0][_tick & kSlotMask].empty());
+                _collected = false;
+                while (_cascade_level + 1 < kLevels &&
+                       (_tick & ((uint64_t(1) << (kLevelBits * (_cascade_level + 1))) - 1)) == 0) {
+                    _cascade_level++;
+                }
+            } else {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr std::size_t kLevelBits = 6;
+    static constexpr std::size_t kSlots = std::size_t(1) << kLevelBits;
+    static constexpr std::size_t kSlotMask = kSlots - 1;
+
+    // 64^4 seconds is about half a year, values scheduled further than that are parked and rescheduled
+    static constexpr std::size_t kLevels = 4;
+
+    struct timer {
+        uint64_t deadline;
+        T value;
+    };
+
+    std::vector<timer> _wheel[kLevels][kSlots];
+
+    // Values which are due already, but not fired yet
+    std::vector<timer> _due;
+
+    // Values of the upper level slot which is being cascaded
+    std::vector<timer> _cascade;
+
+    // Current tick, _collected tells whether its level 0 slot was moved into _due already
+    uint64_t _tick;
+    bool _collected;
+
+    // Highest level which slot must be cascaded in the current tick, 0 if there is none left
+    std::size_t _cascade_level;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TIMER_WHEEL_H
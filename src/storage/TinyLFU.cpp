@@ -0,0 +1,413 @@
+#include "TinyLFU.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace Afina {
+namespace Backend {
+
+void TinyLFU::policy_list::PushHead(policy_entry *entry) {
+    entry->prev = nullptr;
+    entry->next = head;
+    if (head) {
+        head->prev = entry;
+    } else {
+        tail = entry;
+    }
+    head = entry;
+    size += entry->size;
+}
+
+void TinyLFU::policy_list::Unlink(policy_entry *entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        tail = entry->prev;
+    }
+    entry->prev = entry->next = nullptr;
+    size -= entry->size;
+}
+
+TinyLFU::TinyLFU(std::shared_ptr<Afina::Storage> storage, size_t max_size)
+    : _storage(std::move(storage)), _max_size(max_size), _window_max(std::max<size_t>(max_size / 100, 1)),
+      _protected_max((max_size - _window_max) * 4 / 5), _sketch(std::max<size_t>(max_size / 64, 64)),
+      _stats{0, 0, 0, 0} {}
+
+TinyLFU::~TinyLFU() {
+    for (policy_list *list : {&_window, &_probation, &_protected}) {
+        while (list->head) {
+            policy_entry *next = list->head->next;
+            delete list->head;
+            list->head = next;
+        }
+    }
+}
+
+// See TinyLFU.h
+bool TinyLFU::Put(const std::string &key, const std::string &value) { return Put(key, value, 0); }
+
+// See TinyLFU.h
+bool TinyLFU::Put(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    if (key.size() + value.size() > _max_size || !_storage->Put(key, value, expire)) {
+        return false;
+    }
+    _OnStored(key, ref.hash, key.size() + value.size());
+    return true;
+}
+
+// See TinyLFU.h
+bool TinyLFU::PutIfAbsent(const std::string &key, const std::string &value) { return PutIfAbsent(key, value, 0); }
+
+// See TinyLFU.h
+bool TinyLFU::PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    if (key.size() + value.size() > _max_size || !_storage->PutIfAbsent(key, value, expire)) {
+        return false;
+    }
+    _OnStored(key, ref.hash, key.size() + value.size());
+    return true;
+}
+
+// See TinyLFU.h
+bool TinyLFU::Set(const std::string &key, const std::string &value) { return Set(key, value, 0); }
+
+// See TinyLFU.h
+bool TinyLFU::Set(const std::string &key, const std::string &value, std::time_t expire) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    if (key.size() + value.size() > _max_size) {
+        return false;
+    }
+    if (!_storage->Set(key, value, expire)) {
+        // Wrapped storage could have lost the key on its own
+        policy_entry *entry = _Find(ref);
+        if (entry) {
+            _Forget(entry);
+        }
+        return false;
+    }
+    _OnStored(key, ref.hash, key.size() + value.size());
+    return true;
+}
+
+// See TinyLFU.h
+bool TinyLFU::Append(const std::string &key, const std::string &data) { return _Extend(key, data, false); }
+
+// See TinyLFU.h
+bool TinyLFU::Prepend(const std::string &key, const std::string &data) { return _Extend(key, data, true); }
+
+// See TinyLFU.h
+Storage::IncrResult TinyLFU::Increment(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, false, value);
+}
+
+// See TinyLFU.h
+Storage::IncrResult TinyLFU::Decrement(const std::string &key, uint64_t delta, uint64_t &value) {
+    return _Increment(key, delta, true, value);
+}
+
+// See TinyLFU.h
+bool TinyLFU::Delete(const std::string &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    policy_entry *entry = _Find(key);
+    if (entry) {
+        _Forget(entry);
+    }
+    return _storage->Delete(key);
+}
+
+// See TinyLFU.h
+bool TinyLFU::Delete(const KeyRef &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    policy_entry *entry = _Find(key);
+    if (entry) {
+        _Forget(entry);
+    }
+    return _storage->Delete(key);
+}
+
+// See TinyLFU.h
+bool TinyLFU::Get(const std::string &key, std::string &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _View(key, [this, &key, &value]() { return _storage->Get(key, value); });
+}
+
+// See TinyLFU.h
+bool TinyLFU::Get(const KeyRef &key, std::string &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _View(key, [this, &key, &value]() { return _storage->Get(key, value); });
+}
+
+// See TinyLFU.h
+bool TinyLFU::View(const std::string &key, const Visitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _View(key, [this, &key, &visitor]() { return _storage->View(key, visitor); });
+}
+
+// See TinyLFU.h
+bool TinyLFU::View(const KeyRef &key, const Visitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _View(key, [this, &key, &visitor]() { return _storage->View(key, visitor); });
+}
+
+// See TinyLFU.h
+std::size_t TinyLFU::MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [this, &key, &visitor]() {
+            return _storage->View(key, [&key, &visitor](const char *value, std::size_t size) {
+                visitor(key, value, size);
+            });
+        });
+    }
+    return found;
+}
+
+// See TinyLFU.h
+std::size_t TinyLFU::MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t found = 0;
+    for (auto &key : keys) {
+        found += _View(key, [this, &key, &visitor]() {
+            return _storage->View(key, [&key, &visitor](const char *value, std::size_t size) {
+                visitor(key, value, size);
+            });
+        });
+    }
+    return found;
+}
+
+// See TinyLFU.h
+std::size_t TinyLFU::MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::size_t found = 0;
+    std::vector<std::string> one(1);
+    for (auto &key : keys) {
+        found += _View(key, [this, &key, &one, &visitor]() {
+            one[0] = key;
+            return _storage->MultiViewCas(one, visitor) > 0;
+        });
+    }
+    return found;
+}
+
+// See TinyLFU.h
+Storage::CasResult TinyLFU::CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                                           uint64_t cas) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    if (key.size() + value.size() > _max_size) {
+        return CasResult::kNotStored;
+    }
+
+    CasResult result = _storage->CompareAndSwap(key, value, expire, cas);
+    if (result == CasResult::kStored) {
+        _OnStored(key, ref.hash, key.size() + value.size());
+    } else if (result == CasResult::kNotFound) {
+        // Wrapped storage could have lost the key on its own
+        policy_entry *entry = _Find(ref);
+        if (entry) {
+            _Forget(entry);
+        }
+    }
+    return result;
+}
+
+// See TinyLFU.h
+void TinyLFU::Freeze() {
+    _mutex.lock();
+    _storage->Freeze();
+}
+
+// See TinyLFU.h
+void TinyLFU::Thaw() {
+    _storage->Thaw();
+    _mutex.unlock();
+}
+
+// See TinyLFU.h
+bool TinyLFU::Scan(const Scanner &scanner) { return _storage->Scan(scanner); }
+
+// See TinyLFU.h
+void TinyLFU::Report(const Reporter &reporter) { _storage->Report(reporter); }
+
+TinyLFU::Stats TinyLFU::GetStats() const {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+TinyLFU::policy_entry *TinyLFU::_Find(const KeyRef &key) const {
+    return _index.Find(key.hash, [&key](const policy_entry &entry) { return key == entry.key; });
+}
+
+TinyLFU::policy_list &TinyLFU::_ListOf(Segment segment) {
+    switch (segment) {
+    case Segment::kWindow:
+        return _window;
+    case Segment::kProbation:
+        return _probation;
+    default:
+        return _protected;
+    }
+}
+
+void TinyLFU::_MoveTo(policy_entry *entry, Segment segment) {
+    if (entry->segment != Segment::kNone) {
+        _ListOf(entry->segment).Unlink(entry);
+    }
+    entry->segment = segment;
+    _ListOf(segment).PushHead(entry);
+}
+
+void TinyLFU::_Forget(policy_entry *entry) {
+    if (entry->segment != Segment::kNone) {
+        _ListOf(entry->segment).Unlink(entry);
+    }
+    _index.Erase(entry->hash, entry);
+    delete entry;
+}
+
+void TinyLFU::_Evict(policy_entry *entry) {
+    _storage->Delete(entry->key);
+    _Forget(entry);
+}
+
+bool TinyLFU::_View(const KeyRef &key, const std::function<bool()> &read) {
+    _sketch.Increment(key.hash);
+    policy_entry *entry = _Find(key);
+    if (entry == nullptr || !read()) {
+        if (entry) {
+            _Forget(entry);
+        }
+        _stats.misses++;
+        return false;
+    }
+    _stats.hits++;
+    _OnHit(entry);
+    return true;
+}
+
+bool TinyLFU::_Extend(const std::string &key, const std::string &data, bool front) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    policy_entry *entry = _Find(ref);
+    if (entry && entry->size + data.size() > _max_size) {
+        return false;
+    }
+    if (!(front ? _storage->Prepend(key, data) : _storage->Append(key, data))) {
+        // Wrapped storage could have lost the key on its own
+        if (entry) {
+            _Forget(entry);
+        }
+        return false;
+    }
+
+    // Policy could have lost track of the key, then its size comes from the storage
+    std::size_t size = 0;
+    if (entry) {
+        size = entry->size + data.size();
+    } else {
+        _storage->View(key, [&key, &size](const char *, std::size_t value_size) { size = key.size() + value_size; });
+    }
+    _OnStored(key, ref.hash, size);
+    return true;
+}
+
+Storage::IncrResult TinyLFU::_Increment(const std::string &key, uint64_t delta, bool decrement, uint64_t &value) {
+    KeyRef ref(key);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _sketch.Increment(ref.hash);
+    IncrResult result = decrement ? _storage->Decrement(key, delta, value) : _storage->Increment(key, delta, value);
+    if (result == IncrResult::kUpdated) {
+        _OnStored(key, ref.hash, key.size() + std::to_string(value).size());
+    } else if (result == IncrResult::kNotFound) {
+        // Wrapped storage could have lost the key on its own
+        policy_entry *entry = _Find(ref);
+        if (entry) {
+            _Forget(entry);
+        }
+    }
+    return result;
+}
+
+void TinyLFU::_OnStored(const std::string &key, uint64_t hash, std::size_t size) {
+    policy_entry *entry = _Find(KeyRef(key.data(), key.size(), hash));
+    if (entry == nullptr) {
+        entry = new policy_entry(key, hash, size);
+        _index.Insert(hash, entry);
+        _MoveTo(entry, Segment::kWindow);
+    } else {
+        policy_list &list = _ListOf(entry->segment);
+        list.size -= entry->size;
+        entry->size = size;
+        list.size += entry->size;
+        _OnHit(entry);
+    }
+    _Balance();
+}
+
+void TinyLFU::_OnHit(policy_entry *entry) {
+    if (entry->segment == Segment::kWindow) {
+        _MoveTo(entry, Segment::kWindow);
+        return;
+    }
+
+    // Second hit in the main space makes entry protected
+    _MoveTo(entry, Segment::kProtected);
+    while (_protected.size > _protected_max && _protected.tail != entry) {
+        _MoveTo(_protected.tail, Segment::kProbation);
+    }
+}
+
+void TinyLFU::_Admit(policy_entry *candidate) {
+    std::size_t main_max = _max_size - _window_max;
+    while (_probation.size + _protected.size + candidate->size > main_max) {
+        policy_entry *victim = _probation.tail ? _probation.tail : _protected.tail;
+        if (victim == nullptr) {
+            break;
+        }
+
+        if (_sketch.Frequency(candidate->hash) > _sketch.Frequency(victim->hash)) {
+            _Evict(victim);
+        } else {
+            _stats.rejected++;
+            _Evict(candidate);
+            return;
+        }
+    }
+
+    _stats.admitted++;
+    _MoveTo(candidate, Segment::kProbation);
+}
+
+void TinyLFU::_Balance() {
+    while (_window.size > _window_max && _window.tail) {
+        policy_entry *candidate = _window.tail;
+        _window.Unlink(candidate);
+        candidate->segment = Segment::kNone;
+        _Admit(candidate);
+    }
+
+    // Entries in the main space could grow on update
+    std::size_t main_max = _max_size - _window_max;
+    while (_probation.size + _protected.size > main_max) {
+        _Evict(_probation.tail ? _probation.tail : _protected.tail);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
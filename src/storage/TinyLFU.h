@@ -0,0 +1,215 @@
+#ifndef AFINA_STORAGE_TINY_LFU_H
+#define AFINA_STORAGE_TINY_LFU_H
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "FrequencySketch.h"
+#include "HashIndex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # W-TinyLFU admission policy
+ * Wraps any storage backend and decides which keys stay in it. New keys land in a small window LRU
+ * (1% of memory). Keys pushed out of the window compete for the main space, a segmented LRU made of
+ * probation (20%) and protected (80%) parts: candidate is admitted only if FrequencySketch estimates
+ * it to be more popular than the probation victim, loser gets deleted from the wrapped storage.
+ *
+ * That way a single scan of one-hit-wonder keys passes through the window only and never flushes the
+ * hot set out of the main space.
+ *
+ * Wrapped storage keeps the values and is the source of truth whether key present or not, policy only
+ * tracks keys and sizes. Wrapped storage must be able to hold max_size bytes, otherwise its own eviction
+ * takes over the policy.
+ *
+ * That is thread safe implementation, all operations are serialized on a single mutex
+ */
+class TinyLFU : public Afina::Storage {
+public:
+    /**
+     * Counters to compare hit ratio with other policies
+     */
+    struct Stats {
+        // Lookups that found/didn't find the key
+        uint64_t hits;
+        uint64_t misses;
+
+        // Keys moved from window into main space and the ones dropped after losing the frequency duel
+        uint64_t admitted;
+        uint64_t rejected;
+    };
+
+    TinyLFU(std::shared_ptr<Afina::Storage> storage, size_t max_size = 1024);
+    ~TinyLFU();
+
+    void Start() override { _storage->Start(); }
+    void Stop() override { _storage->Stop(); }
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value, std::time_t expire) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Prepend(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Increment(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    IncrResult Decrement(const std::string &key, uint64_t delta, uint64_t &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const KeyRef &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const KeyRef &key, std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool View(const std::string &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    bool View(const KeyRef &key, const Visitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<std::string> &keys, const MultiVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiView(const std::vector<KeyRef> &keys, const RefVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    std::size_t MultiViewCas(const std::vector<std::string> &keys, const CasVisitor &visitor) override;
+
+    // Implements Afina::Storage interface
+    CasResult CompareAndSwap(const std::string &key, const std::string &value, std::time_t expire,
+                             uint64_t cas) override;
+
+    // Implements Afina::Storage interface
+    void Freeze() override;
+
+    // Implements Afina::Storage interface
+    void Thaw() override;
+
+    // Implements Afina::Storage interface
+    bool Scan(const Scanner &scanner) override;
+
+    // Implements Afina::Storage interface
+    void Report(const Reporter &reporter) override;
+
+    Stats GetStats() const;
+
+private:
+    enum class Segment { kNone, kWindow, kProbation, kProtected };
+
+    struct policy_entry {
+        policy_entry(const std::string &key_, uint64_t hash_, std::size_t size_)
+            : key(key_), hash(hash_), size(size_), segment(Segment::kNone), prev(nullptr), next(nullptr) {}
+        const std::string key;
+        const uint64_t hash;
+        std::size_t size;
+        Segment segment;
+        policy_entry *prev;
+        policy_entry *next;
+    };
+
+    // Intrusive LRU list of entries, head is the most recently used one
+    struct policy_list {
+        policy_entry *head = nullptr;
+        policy_entry *tail = nullptr;
+
+        // Sum of entries sizes
+        std::size_t size = 0;
+
+        void PushHead(policy_entry *entry);
+        void Unlink(policy_entry *entry);
+    };
+
+    policy_entry *_Find(const KeyRef &key) const;
+
+    policy_list &_ListOf(Segment segment);
+
+    // Moves entry into the segment head
+    void _MoveTo(policy_entry *entry, Segment segment);
+
+    // Drops entry from the policy only
+    void _Forget(policy_entry *entry);
+
+    // Drops entry from the policy and the wrapped storage
+    void _Evict(policy_entry *entry);
+
+    // Counts lookup of the key, read is called to get the value out of the wrapped storage if policy knows it
+    bool _View(const KeyRef &key, const std::function<bool()> &read);
+
+    // Extends value in the wrapped storage and accounts the new size
+    bool _Extend(const std::string &key, const std::string &data, bool front);
+
+    // Changes counter in the wrapped storage and accounts the new size
+    IncrResult _Increment(const std::string &key, uint64_t delta, bool decrement, uint64_t &value);
+
+    // Updates policy after key was stored into the wrapped storage
+    void _OnStored(const std::string &key, uint64_t hash, std::size_t size);
+
+    void _OnHit(policy_entry *entry);
+
+    // Gives window candidate a chance to get into the main space
+    void _Admit(policy_entry *candidate);
+
+    // Restores segments limits
+    void _Balance();
+
+    std::shared_ptr<Afina::Storage> _storage;
+
+    // Segments limits in bytes, i.e keys+values
+    std::size_t _max_size;
+    std::size_t _window_max;
+    std::size_t _protected_max;
+
+    policy_list _window;
+    policy_list _probation;
+    policy_list _protected;
+
+    // Index of all entries tracked by policy
+    HashIndex<policy_entry> _index;
+
+    FrequencySketch _sketch;
+
+    Stats _stats;
+
+    mutable std::mutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_TINY_LFU_H
@@ -0,0 +1,118 @@
+#include "WarmSegment.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+static const char kMagic[8] = {'A', 'F', 'N', 'W', 'A', 'R', 'M', '1'};
+
+struct WarmSegment::header {
+    char magic[8];
+    uint32_t clean;
+    uint32_t reserved;
+    uint64_t layout;
+    uint64_t arena_size;
+
+    // Number of u64 entries in the index right after the arena
+    uint64_t index_size;
+};
+
+static std::size_t PageSize() { return sysconf(_SC_PAGESIZE); }
+
+WarmSegment::WarmSegment(const std::string &name, std::size_t arena_size, uint64_t layout)
+    : _fd(-1), _header(nullptr), _arena(nullptr), _warm(false) {
+    std::size_t page = PageSize();
+    _arena_size = (arena_size + page - 1) / page * page;
+
+    _fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Failed to open shared memory " + name);
+    }
+
+    // Only header is checked before mapping everything, segment could be smaller than we need
+    header old;
+    std::memset(&old, 0, sizeof(old));
+    struct stat st;
+    bool reuse = fstat(_fd, &st) == 0 && std::size_t(st.st_size) >= page + _arena_size &&
+                 pread(_fd, &old, sizeof(old), 0) == ssize_t(sizeof(old)) &&
+                 std::memcmp(old.magic, kMagic, sizeof(kMagic)) == 0 && old.clean == 1 && old.layout == layout &&
+                 old.arena_size == _arena_size &&
+                 std::size_t(st.st_size) >= page + _arena_size + old.index_size * sizeof(uint64_t);
+
+    // Truncating to zero first drops whatever was there
+    if (!reuse && (ftruncate(_fd, 0) != 0 || ftruncate(_fd, page + _arena_size) != 0)) {
+        int error = errno;
+        close(_fd);
+        throw std::system_error(error, std::system_category(), "Failed to size shared memory " + name);
+    }
+
+    void *mem = mmap(nullptr, page + _arena_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mem == MAP_FAILED) {
+        int error = errno;
+        close(_fd);
+        throw std::system_error(error, std::system_category(), "Failed to map shared memory " + name);
+    }
+    _header = static_cast<header *>(mem);
+    _arena = static_cast<char *>(mem) + page;
+    _warm = reuse;
+
+    if (!reuse) {
+        std::memcpy(_header->magic, kMagic, sizeof(kMagic));
+        _header->layout = layout;
+        _header->arena_size = _arena_size;
+        _header->index_size = 0;
+    }
+    _header->clean = 0;
+}
+
+WarmSegment::~WarmSegment() {
+    if (_header) {
+        munmap(_header, PageSize() + _arena_size);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+// See WarmSegment.h
+std::vector<uint64_t> WarmSegment::TakeIndex() {
+    std::vector<uint64_t> index;
+    if (!_warm) {
+        return index;
+    }
+    _warm = false;
+
+    index.resize(_header->index_size);
+    std::size_t bytes = index.size() * sizeof(uint64_t);
+    if (bytes > 0 && pread(_fd, index.data(), bytes, PageSize() + _arena_size) != ssize_t(bytes)) {
+        index.clear();
+    }
+    return index;
+}
+
+// See WarmSegment.h
+void WarmSegment::MarkClean(const std::vector<uint64_t> &index) {
+    std::size_t offset = PageSize() + _arena_size;
+    std::size_t bytes = index.size() * sizeof(uint64_t);
+    if (ftruncate(_fd, offset + bytes) != 0 ||
+        (bytes > 0 && pwrite(_fd, index.data(), bytes, offset) != ssize_t(bytes))) {
+        throw std::system_error(errno, std::system_category(), "Failed to write shared memory index");
+    }
+
+    _header->index_size = index.size();
+    __atomic_store_n(&_header->clean, 1, __ATOMIC_RELEASE);
+}
+
+// See WarmSegment.h
+void WarmSegment::Remove(const std::string &name) { shm_unlink(name.c_str()); }
+
+} // namespace Backend
+} // namespace Afina
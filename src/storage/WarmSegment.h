@@ -0,0 +1,84 @@
+#ifndef AFINA_STORAGE_WARM_SEGMENT_H
+#define AFINA_STORAGE_WARM_SEGMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Shared memory segment that outlives the process
+ * Named POSIX shared memory object holding the item arena, so that data survives restart of the server
+ * and the next process picks it up instead of starting with a cold cache:
+ *
+ * +--------+-------------------------+-------+
+ * | header | arena of arena_size     | index |
+ * +--------+-------------------------+-------+
+ *
+ * Header takes a page and tells geometry of the arena and whether the segment was left clean. Index is
+ * written by the owner on graceful shutdown only: offsets of live items in the arena in the order owner
+ * needs them back. Segment is marked dirty as soon as it is mapped, so that after a crash, when arena
+ * could be in the middle of a change, the next process starts cold.
+ *
+ * Segment is reused only if it was left clean with the same geometry and layout version, otherwise its
+ * content is dropped.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class WarmSegment {
+public:
+    /**
+     * Maps segment with the given name, creating it if needed
+     *
+     * @param name of the shared memory object, like "/afina"
+     * @param arena_size bytes of the arena, rounded up to pages
+     * @param layout identifies layout of the arena content, segment with other layout isn't reused
+     */
+    WarmSegment(const std::string &name, std::size_t arena_size, uint64_t layout);
+    ~WarmSegment();
+
+    WarmSegment(const WarmSegment &) = delete;
+    WarmSegment &operator=(const WarmSegment &) = delete;
+
+    /**
+     * Whether the segment was left clean and its arena content is valid
+     */
+    bool warm() const { return _warm; }
+
+    void *arena() const { return _arena; }
+    std::size_t arena_size() const { return _arena_size; }
+
+    /**
+     * Returns index left by the previous owner and forgets it, so that arena is picked up only once. Empty
+     * if segment isn't warm
+     */
+    std::vector<uint64_t> TakeIndex();
+
+    /**
+     * Stores index and marks segment clean, arena must not change after that. Throws std::system_error
+     * if index couldn't be written
+     */
+    void MarkClean(const std::vector<uint64_t> &index);
+
+    /**
+     * Removes segment with the given name, memory is released once the last process unmaps it
+     */
+    static void Remove(const std::string &name);
+
+private:
+    struct header;
+
+    int _fd;
+    header *_header;
+    void *_arena;
+    std::size_t _arena_size;
+    bool _warm;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_WARM_SEGMENT_H
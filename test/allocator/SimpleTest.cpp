@@ -322,3 +322,64 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, FreeInvalid) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    // Freeing empty pointer does nothing, freeing a stale copy is an error
+    a.free(p);
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+// Data must stay intact after every single step, and allocations in between must not break the pass
+TEST(SimpleTest, DefragIncremental) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+
+    vector<Pointer> kept;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        if (i % 3 == 0) {
+            kept.push_back(ptrs[i]);
+        } else {
+            a.free(ptrs[i]);
+        }
+    }
+    EXPECT_LT(a.max_alloc(), 4 * size);
+    size_t free_bytes = a.free_bytes();
+
+    size_t steps = 0;
+    while (!a.defrag(1)) {
+        steps++;
+        if (steps % 50 == 0) {
+            kept.push_back(a.alloc(size));
+            writeTo(kept.back(), size);
+        }
+        for (Pointer &p : kept) {
+            ASSERT_TRUE(isDataOk(p, size));
+        }
+    }
+    EXPECT_GT(steps, kept.size() / 2);
+
+    // Whatever was allocated during the pass, all the holes are gone now
+    a.defrag();
+    EXPECT_LE(a.free_bytes() - a.max_alloc(), 2 * sizeof(void *));
+    EXPECT_LE(a.free_bytes(), free_bytes);
+
+    for (Pointer &p : kept) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+}
@@ -0,0 +1,183 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Slab.h>
+
+using namespace Afina::Allocator;
+
+TEST(SlabCacheTest, Ceiling) {
+    SlabCache cache(4 * 4096, 4096);
+    std::set<void *> slabs;
+    for (int i = 0; i < 4; ++i) {
+        void *slab = cache.Get();
+        ASSERT_NE(nullptr, slab);
+        std::memset(slab, i, 4096);
+        slabs.insert(slab);
+    }
+    EXPECT_EQ(4, slabs.size());
+    EXPECT_EQ(nullptr, cache.Get());
+
+    cache.Put(*slabs.begin());
+    EXPECT_EQ(3, cache.slabs_used());
+    EXPECT_EQ(*slabs.begin(), cache.Get());
+    EXPECT_EQ(nullptr, cache.Get());
+}
+
+TEST(SlabTest, SizeClasses) {
+    Slab slab(1024 * 1024, 64 * 1024);
+    EXPECT_EQ(64 * 1024, slab.max_size());
+    EXPECT_EQ(Slab::kNoClass, slab.ClassOf(64 * 1024 + 1));
+
+    for (std::size_t size : {1, 64, 65, 100, 1000, 5000, 64 * 1024}) {
+        std::size_t cls = slab.ClassOf(size);
+        ASSERT_NE(Slab::kNoClass, cls);
+        EXPECT_GE(slab.ClassSize(cls), size);
+        if (cls > 0) {
+            EXPECT_LT(slab.ClassSize(cls - 1), size);
+        }
+
+        void *ptr = slab.Allocate(size);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 8);
+        EXPECT_EQ(cls, slab.ClassOf(static_cast<const void *>(ptr)));
+        std::memset(ptr, 0xff, size);
+        slab.Free(ptr);
+    }
+}
+
+// Once ceiling is reached memory comes only from chunks of the same class
+TEST(SlabTest, Ceiling) {
+    Slab slab(8 * 4096, 4096);
+    std::vector<void *> chunks;
+    while (void *ptr = slab.Allocate(100)) {
+        chunks.push_back(ptr);
+    }
+    EXPECT_EQ(8 * 4096, slab.memory_used());
+    EXPECT_EQ(8 * (4096 / slab.ClassSize(slab.ClassOf(100))), chunks.size());
+    EXPECT_EQ(nullptr, slab.Allocate(1000));
+
+    std::set<void *> unique(chunks.begin(), chunks.end());
+    EXPECT_EQ(chunks.size(), unique.size());
+
+    slab.Free(chunks.back());
+    EXPECT_EQ(chunks.back(), slab.Allocate(90));
+    for (void *ptr : chunks) {
+        slab.Free(ptr);
+    }
+}
+
+// Slab with all chunks freed goes to another class
+TEST(SlabTest, Release) {
+    Slab slab(4 * 4096, 4096);
+    std::vector<void *> chunks;
+    while (void *ptr = slab.Allocate(100)) {
+        chunks.push_back(ptr);
+    }
+    EXPECT_EQ(nullptr, slab.Allocate(1000));
+
+    void *victim = slab.SlabOf(chunks.front());
+    std::vector<void *> rest;
+    for (void *ptr : chunks) {
+        if (slab.SlabOf(ptr) == victim && ptr != chunks.front()) {
+            slab.Free(ptr);
+        } else {
+            rest.push_back(ptr);
+        }
+    }
+    EXPECT_FALSE(slab.Release(victim));
+
+    // Chunks found by the failed call are still there for the class
+    void *again = slab.Allocate(100);
+    EXPECT_EQ(victim, slab.SlabOf(again));
+    slab.Free(again);
+
+    slab.Free(chunks.front());
+    EXPECT_TRUE(slab.Release(victim));
+    EXPECT_EQ(3 * 4096, slab.memory_used());
+
+    void *big = slab.Allocate(1000);
+    ASSERT_NE(nullptr, big);
+    EXPECT_EQ(victim, slab.SlabOf(big));
+    EXPECT_EQ(slab.ClassOf(1000), slab.ClassOf(static_cast<const void *>(big)));
+    EXPECT_EQ(nullptr, slab.Allocate(100));
+
+    slab.Free(big);
+    for (void *ptr : rest) {
+        if (ptr != chunks.front()) {
+            slab.Free(ptr);
+        }
+    }
+}
+
+// Chunks freed by one thread are reused by the others through the depot
+TEST(SlabTest, ManyThreads) {
+    Slab slab(64 * 4096, 4096);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&slab, t]() {
+            std::vector<char *> chunks;
+            for (int round = 0; round < 100; ++round) {
+                for (int i = 0; i < 100; ++i) {
+                    char *ptr = static_cast<char *>(slab.Allocate(200));
+                    ASSERT_NE(nullptr, ptr);
+                    std::memset(ptr, t, 200);
+                    chunks.push_back(ptr);
+                }
+                for (char *ptr : chunks) {
+                    ASSERT_EQ(char(t), ptr[199]);
+                    slab.Free(ptr);
+                }
+                chunks.clear();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_LE(slab.memory_used(), 64 * 4096);
+}
+
+// Allocator over arena of the previous owner keeps its chunks and reuses everything else
+TEST(SlabTest, Restore) {
+    std::vector<char> arena_mem(9 * 4096);
+    void *arena = reinterpret_cast<void *>((reinterpret_cast<uintptr_t>(arena_mem.data()) + 4095) & ~uintptr_t(4095));
+
+    std::vector<Slab::Chunk> live;
+    {
+        Slab slab(arena, 8 * 4096, 4096);
+        std::vector<void *> small, big;
+        while (void *ptr = slab.Allocate(100)) {
+            small.push_back(ptr);
+            if (small.size() == 10) {
+                break;
+            }
+        }
+        big.push_back(slab.Allocate(2000));
+        for (std::size_t i = 0; i < small.size(); i += 3) {
+            live.push_back(Slab::Chunk{small[i], 100});
+        }
+        live.push_back(Slab::Chunk{big[0], 2000});
+    }
+
+    Slab slab(arena, 8 * 4096, 4096);
+    std::vector<Slab::Chunk> wrong{Slab::Chunk{static_cast<char *>(live[0].ptr) + 8, 100}};
+    EXPECT_FALSE(slab.Restore(wrong));
+    ASSERT_TRUE(slab.Restore(live));
+    EXPECT_EQ(2 * 4096, slab.memory_used());
+
+    std::set<void *> kept;
+    for (auto &chunk : live) {
+        kept.insert(chunk.ptr);
+    }
+    std::size_t allocated = 0;
+    while (void *ptr = slab.Allocate(100)) {
+        EXPECT_EQ(0, kept.count(ptr));
+        allocated++;
+    }
+    std::size_t per_slab = 4096 / slab.ClassSize(slab.ClassOf(100));
+    EXPECT_EQ(7 * per_slab - (live.size() - 1), allocated);
+}
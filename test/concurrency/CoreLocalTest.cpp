@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/CoreLocal.h>
+
+using namespace Afina::Concurrency;
+
+TEST(CoreLocalTest, SlotsArePadded) {
+    CoreLocal<std::atomic<uint64_t>> slots;
+    ASSERT_GE(slots.size(), 1u);
+    EXPECT_EQ(0u, slots.size() & (slots.size() - 1));
+
+    // Slot of the current CPU is the one aggregated, whatever CPU that is
+    slots.local().store(5);
+    uint64_t sum = slots.Aggregate(uint64_t(0), [](uint64_t sum, const std::atomic<uint64_t> &v) {
+        return sum + v.load();
+    });
+    EXPECT_EQ(5u, sum);
+
+    std::size_t count = slots.Aggregate(std::size_t(0), [](std::size_t count, const std::atomic<uint64_t> &v) {
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&v) % 64);
+        return count + 1;
+    });
+    EXPECT_EQ(slots.size(), count);
+}
+
+// Threads migrate between CPUs while adding, nothing must be lost anyway
+TEST(CoreLocalTest, ConcurrentCounter) {
+    CoreCounter counter;
+    EXPECT_EQ(0u, counter.Sum());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter, t]() {
+            for (int i = 0; i < 100000; ++i) {
+                counter.Add(t % 2 ? 1 : 2);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(4u * 100000 * 3, counter.Sum());
+}
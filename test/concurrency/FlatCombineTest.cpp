@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/FlatCombine.h>
+
+using namespace Afina::Concurrency;
+
+using Op = std::function<void()>;
+
+// Counter isn't atomic, all the increments are executed by combiners one at a time
+TEST(FlatCombineTest, ConcurrentOps) {
+    FlatCombine<Op> combine(2);
+    long counter = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&combine, &counter]() {
+            for (int i = 0; i < 10000; ++i) {
+                long seen = -1;
+                Op op = [&counter, &seen]() { seen = ++counter; };
+                combine.Execute(op);
+                EXPECT_GT(seen, 0);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(8 * 10000, counter);
+}
+
+TEST(FlatCombineTest, ExceptionIsPassedBack) {
+    FlatCombine<Op> combine;
+    Op fail = []() { throw std::runtime_error("failed"); };
+    EXPECT_THROW(combine.Execute(fail), std::runtime_error);
+
+    int value = 0;
+    Op op = [&value]() { value = 1; };
+    combine.Execute(op);
+    EXPECT_EQ(1, value);
+}
+
+// Nothing is executed while the lock is held, published op runs once it is released
+TEST(FlatCombineTest, LockHoldsOps) {
+    FlatCombine<Op> combine;
+    combine.lock();
+
+    std::atomic<bool> done(false);
+    std::thread thread([&combine, &done]() {
+        Op op = [&done]() { done = true; };
+        combine.Execute(op);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(done.load());
+
+    combine.unlock();
+    thread.join();
+    EXPECT_TRUE(done.load());
+}
@@ -0,0 +1,107 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afina/concurrency/ThreadLocal.h>
+
+using namespace Afina::Concurrency;
+
+namespace {
+
+// Counts live objects
+struct tracked {
+    static std::atomic<int> alive;
+
+    tracked() : value(0) { alive++; }
+    ~tracked() { alive--; }
+
+    std::atomic<long> value;
+};
+
+std::atomic<int> tracked::alive(0);
+
+} // namespace
+
+TEST(ThreadLocalTest, ObjectPerInstance) {
+    ThreadLocal<int> a, b;
+    a.get() = 1;
+    *b = 2;
+    EXPECT_EQ(1, a.get());
+    EXPECT_EQ(2, *b);
+    EXPECT_EQ(&a.get(), &a.get());
+
+    int count = 0;
+    a.ForEach([&count](int &value) { count += value; });
+    EXPECT_EQ(1, count);
+}
+
+// Objects of running threads are aggregated, exited threads take theirs away
+TEST(ThreadLocalTest, ForEachAndThreadExit) {
+    {
+        ThreadLocal<tracked> local;
+        std::atomic<int> ready(0);
+        std::atomic<bool> stop(false);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&local, &ready, &stop, t]() {
+                for (int i = 0; i <= t; ++i) {
+                    local->value++;
+                }
+                ready++;
+                while (!stop.load()) {
+                    std::this_thread::yield();
+                }
+            });
+        }
+        while (ready.load() < 4) {
+            std::this_thread::yield();
+        }
+
+        long sum = 0;
+        local.ForEach([&sum](tracked &t) { sum += t.value.load(); });
+        EXPECT_EQ(1 + 2 + 3 + 4, sum);
+        EXPECT_EQ(4, tracked::alive.load());
+
+        stop = true;
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(0, tracked::alive.load());
+
+        int count = 0;
+        local.ForEach([&count](tracked &) { count++; });
+        EXPECT_EQ(0, count);
+    }
+    EXPECT_EQ(0, tracked::alive.load());
+}
+
+// Instance destroyed while its threads are still running takes their objects, and its index is reused
+TEST(ThreadLocalTest, InstanceDestroyedFirst) {
+    std::unique_ptr<ThreadLocal<tracked>> local(new ThreadLocal<tracked>());
+    std::atomic<int> stage(0);
+
+    std::thread thread([&local, &stage]() {
+        (*local)->value = 5;
+        stage = 1;
+        while (stage.load() != 2) {
+            std::this_thread::yield();
+        }
+
+        // The same index, but a fresh object
+        EXPECT_EQ(0, (*local)->value.load());
+    });
+    while (stage.load() != 1) {
+        std::this_thread::yield();
+    }
+
+    local.reset();
+    EXPECT_EQ(0, tracked::alive.load());
+    local.reset(new ThreadLocal<tracked>());
+    stage = 2;
+
+    thread.join();
+    EXPECT_EQ(0, tracked::alive.load());
+}
@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Stats.h>
+
+#include "storage/ClockLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina::Backend;
+using namespace Afina::Execute;
+
+// Stats command reports hit, miss and eviction counters of the backends that keep them
+TEST(StatsTest, ReportsStorageCounters) {
+    std::vector<std::shared_ptr<Afina::Storage>> storages{std::make_shared<ClockLRU>(64),
+                                                          std::make_shared<LockFreeHash>(64)};
+    for (auto &storage : storages) {
+        for (int i = 0; i < 10; ++i) {
+            storage->Put("Key " + std::to_string(i), "Value " + std::to_string(i));
+        }
+        std::string value;
+        EXPECT_TRUE(storage->Get("Key 9", value));
+        EXPECT_FALSE(storage->Get("Key none", value));
+
+        std::string out;
+        Stats().Execute(*storage, "", out);
+        EXPECT_NE(std::string::npos, out.find("STAT get_hits 1\r\nSTAT get_misses 1\r\nSTAT evictions "));
+        EXPECT_EQ(std::string::npos, out.find("STAT evictions 0\r\n"));
+        EXPECT_NE(std::string::npos, out.find("STAT limit_maxbytes 64\r\n"));
+        EXPECT_EQ("END", out.substr(out.size() - 3));
+    }
+}
+
+// Backend without counters still ends the response
+TEST(StatsTest, NoCounters) {
+    SimpleLRU storage;
+    std::string out;
+    Stats().Execute(storage, "", out);
+    EXPECT_EQ("END", out);
+}
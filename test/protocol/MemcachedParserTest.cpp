@@ -4,7 +4,10 @@
 #include <string>
 
 #include <afina/execute/Add.h>
+#include <afina/execute/Cas.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Incr.h>
+#include <afina/execute/Prepend.h>
 #include <afina/execute/Set.h>
 #include <afina/execute/Stats.h>
 
@@ -58,6 +61,104 @@ TEST(MemcachedParserTest, SimpleAdd) {
     ASSERT_EQ(-1, tmp->expire());
 }
 
+// Verify prepend command is built as such
+TEST(MemcachedParserTest, SimplePrepend) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("prepend log 0 0 4\r\nline\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(19, consumed);
+    ASSERT_EQ("prepend", parser.Name());
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(dynamic_cast<Execute::Prepend *>(cmd.get()) == nullptr);
+    ASSERT_EQ(4, value_size);
+    ASSERT_EQ("log", static_cast<Execute::Prepend *>(cmd.get())->key());
+}
+
+// Verify cas command carries version and gets asks for versions
+TEST(MemcachedParserTest, GetsAndCas) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("cas foo 0 0 6 18446744073709551615\r\nfooval\r\n", consumed));
+    ASSERT_EQ(36, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Cas *cas = dynamic_cast<Execute::Cas *>(cmd.get());
+    ASSERT_FALSE(cas == nullptr);
+    ASSERT_EQ(6, value_size);
+    ASSERT_EQ("foo", cas->key());
+    ASSERT_EQ(18446744073709551615ull, cas->cas());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("gets foo bar\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::Get *gets = dynamic_cast<Execute::Get *>(cmd.get());
+    ASSERT_FALSE(gets == nullptr);
+    ASSERT_TRUE(gets->cas());
+    ASSERT_EQ(2, gets->keys().size());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 6 18446744073709551616\r\n", consumed), std::runtime_error);
+
+    // Cas without version must not pass for the one of version 0
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 6\r\nfooval\r\n", consumed), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("cas foo 0 0 6 \r\nfooval\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, IncrAndDecr) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("incr foo 18446744073709551615\r\n", consumed));
+    ASSERT_EQ(31, consumed);
+
+    size_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    Execute::Incr *incr = dynamic_cast<Execute::Incr *>(cmd.get());
+    ASSERT_FALSE(incr == nullptr);
+    ASSERT_EQ(0, value_size);
+    ASSERT_EQ("foo", incr->key());
+    ASSERT_EQ(18446744073709551615ull, incr->delta());
+    ASSERT_FALSE(incr->decrement());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("decr bar 5\r\n", consumed));
+    cmd = parser.Build(value_size);
+    Execute::Incr *decr = dynamic_cast<Execute::Incr *>(cmd.get());
+    ASSERT_FALSE(decr == nullptr);
+    ASSERT_EQ("bar", decr->key());
+    ASSERT_EQ(5, decr->delta());
+    ASSERT_TRUE(decr->decrement());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr foo 18446744073709551616\r\n", consumed), std::runtime_error);
+}
+
+// Malformed incr must fail right away rather than swallow the next command
+TEST(MemcachedParserTest, IncrMalformed) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_THROW(parser.Parse("incr foo\r\nget x\r\n", consumed), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr foo abc\r\n", consumed), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("incr foo 12x\r\n", consumed), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("decr foo \r\n", consumed), std::runtime_error);
+}
+
 // Verify simple get command passed in a single string
 TEST(MemcachedParserTest, SimpleGet) {
     Protocol::Parser parser;
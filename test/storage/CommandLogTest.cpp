@@ -0,0 +1,267 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "storage/CommandLog.h"
+#include "storage/SimpleLRU.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina::Backend;
+
+static std::string log_path(const std::string &name) {
+    return "/tmp/afina-" + name + "-" + std::to_string(getpid()) + ".log";
+}
+
+static std::size_t file_size(const std::string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+TEST(CommandLogTest, ReplayRebuildsStorage) {
+    std::string path = log_path("replay");
+    unlink(path.c_str());
+    {
+        CommandLog storage(std::make_shared<SimpleLRU>(), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+        EXPECT_FALSE(storage.PutIfAbsent("KEY2", "other"));
+        EXPECT_TRUE(storage.Set("KEY1", "val3"));
+        EXPECT_FALSE(storage.Set("KEY4", "val4"));
+        EXPECT_TRUE(storage.Put("KEY5", "val5"));
+        EXPECT_TRUE(storage.Delete("KEY5"));
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<SimpleLRU>(), path);
+    storage.Start();
+    EXPECT_EQ(5, storage.replayed());
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_FALSE(storage.Get("KEY5", value));
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+TEST(CommandLogTest, AppendsAreReplayed) {
+    std::string path = log_path("append");
+    unlink(path.c_str());
+    {
+        CommandLog storage(std::make_shared<SimpleLRU>(), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Append("KEY1", "tail"));
+        EXPECT_TRUE(storage.Prepend("KEY1", "head"));
+        EXPECT_FALSE(storage.Append("KEY2", "tail"));
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<SimpleLRU>(), path);
+    storage.Start();
+    EXPECT_EQ(3, storage.replayed());
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("headval1tail", value);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+// Counters are logged as deltas and changed again on replay
+TEST(CommandLogTest, CountersAreReplayed) {
+    std::string path = log_path("counter");
+    unlink(path.c_str());
+    {
+        CommandLog storage(std::make_shared<SimpleLRU>(), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        uint64_t value;
+        EXPECT_TRUE(storage.Put("KEY1", "10"));
+        EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 7, value));
+        EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Decrement("KEY1", 2, value));
+        EXPECT_EQ(Afina::Storage::IncrResult::kNotFound, storage.Increment("KEY2", 1, value));
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<SimpleLRU>(), path);
+    storage.Start();
+    EXPECT_EQ(3, storage.replayed());
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("15", value);
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+TEST(CommandLogTest, TornTailIsCut) {
+    std::string path = log_path("torn");
+    unlink(path.c_str());
+    {
+        CommandLog storage(std::make_shared<SimpleLRU>(), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        storage.Stop();
+    }
+    std::size_t valid = file_size(path);
+
+    // Record that was being written at the moment of crash
+    std::ofstream(path, std::ios::binary | std::ios::app) << std::string("\x20\0\0\0garbage", 11);
+    {
+        CommandLog storage(std::make_shared<SimpleLRU>(), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        EXPECT_EQ(1, storage.replayed());
+        EXPECT_EQ(valid, file_size(path));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<SimpleLRU>(), path);
+    storage.Start();
+    EXPECT_EQ(2, storage.replayed());
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+TEST(CommandLogTest, ConcurrentWritersAreDurable) {
+    std::string path = log_path("concurrent");
+    unlink(path.c_str());
+    const int threads = 4, count = 200;
+    {
+        CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&storage, t, count] {
+                for (int i = 0; i < count; ++i) {
+                    EXPECT_TRUE(storage.Put("Key " + std::to_string(t * count + i), std::to_string(i)));
+                }
+            });
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+    storage.Start();
+    EXPECT_EQ(threads * count, storage.replayed());
+    std::string value;
+    for (int t = 0; t < threads; ++t) {
+        for (int i = 0; i < count; ++i) {
+            ASSERT_TRUE(storage.Get("Key " + std::to_string(t * count + i), value));
+            EXPECT_EQ(std::to_string(i), value);
+        }
+    }
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+TEST(CommandLogTest, CompactionKeepsLiveData) {
+    std::string path = log_path("compact");
+    unlink(path.c_str());
+    {
+        CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path, CommandLog::FsyncPolicy::kAlways);
+        storage.Start();
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put("KEY" + std::to_string(i % 10), std::to_string(i)));
+        }
+        std::size_t before = file_size(path);
+
+        // Writes keep going while compaction runs
+        std::thread writer([&storage] {
+            for (int i = 0; i < 200; ++i) {
+                EXPECT_TRUE(storage.Put("NEW" + std::to_string(i % 20), std::to_string(i)));
+            }
+        });
+        EXPECT_TRUE(storage.Compact());
+        writer.join();
+        EXPECT_TRUE(storage.Delete("KEY0"));
+        EXPECT_LT(file_size(path), before);
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+    storage.Start();
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY0", value));
+    for (int i = 1; i < 10; ++i) {
+        ASSERT_TRUE(storage.Get("KEY" + std::to_string(i), value));
+        EXPECT_EQ(std::to_string(990 + i), value);
+    }
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(storage.Get("NEW" + std::to_string(i), value));
+        EXPECT_EQ(std::to_string(180 + i), value);
+    }
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+// Appends are not idempotent, so a record that is both in the dump and in the tail shows up on replay
+TEST(CommandLogTest, AppendsDuringCompaction) {
+    std::string path = log_path("compact-append");
+    unlink(path.c_str());
+    const int threads = 4, count = 2000;
+    {
+        CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path, CommandLog::FsyncPolicy::kNever);
+        storage.Start();
+        for (int t = 0; t < threads; ++t) {
+            EXPECT_TRUE(storage.Put("Key " + std::to_string(t), ""));
+        }
+        EXPECT_TRUE(storage.Put("Counter", "0"));
+
+        std::atomic<int> done(0);
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&storage, &done, t, count] {
+                uint64_t value;
+                for (int i = 0; i < count; ++i) {
+                    EXPECT_TRUE(storage.Append("Key " + std::to_string(t), "x"));
+                    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("Counter", 1, value));
+                }
+                done++;
+            });
+        }
+        while (done.load() < threads) {
+            EXPECT_TRUE(storage.Compact());
+        }
+        for (auto &writer : writers) {
+            writer.join();
+        }
+        storage.Stop();
+    }
+
+    CommandLog storage(std::make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+    storage.Start();
+    std::string value;
+    for (int t = 0; t < threads; ++t) {
+        ASSERT_TRUE(storage.Get("Key " + std::to_string(t), value));
+        EXPECT_EQ(count, value.size());
+    }
+    ASSERT_TRUE(storage.Get("Counter", value));
+    EXPECT_EQ(std::to_string(threads * count), value);
+    storage.Stop();
+
+    unlink(path.c_str());
+}
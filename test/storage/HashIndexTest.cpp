@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include "storage/HashIndex.h"
+
+using namespace Afina::Backend;
+
+struct TestNode {
+    std::string key;
+};
+
+static TestNode *find(const HashIndex<TestNode> &index, const std::string &key) {
+    return index.Find(std::hash<std::string>{}(key), [&key](const TestNode &node) { return node.key == key; });
+}
+
+// Mutate index while it is migrating entries between tables, each key must stay reachable
+TEST(HashIndexTest, GrowWhileErasing) {
+    HashIndex<TestNode> index;
+    std::vector<TestNode> nodes(10000);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].key = "Key " + std::to_string(i);
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        index.Insert(std::hash<std::string>{}(nodes[i].key), &nodes[i]);
+        if (i % 3 == 0) {
+            const std::string &key = nodes[i / 2].key;
+            EXPECT_TRUE(index.Erase(std::hash<std::string>{}(key), &nodes[i / 2]) || find(index, key) == nullptr);
+        }
+    }
+
+    size_t found = 0;
+    for (auto &node : nodes) {
+        TestNode *ptr = find(index, node.key);
+        if (ptr) {
+            EXPECT_EQ(&node, ptr);
+            found++;
+        }
+    }
+    EXPECT_EQ(index.size(), found);
+    EXPECT_GT(found, nodes.size() / 2);
+
+    for (auto &node : nodes) {
+        index.Erase(std::hash<std::string>{}(node.key), &node);
+    }
+    EXPECT_EQ(0, index.size());
+    EXPECT_EQ(nullptr, find(index, nodes[0].key));
+}
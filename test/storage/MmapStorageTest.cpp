@@ -0,0 +1,206 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <unistd.h>
+
+#include "storage/MmapStorage.h"
+
+using namespace Afina::Backend;
+
+static std::string mmap_path(const std::string &name) {
+    return "/tmp/afina-" + name + "-" + std::to_string(getpid()) + ".mmap";
+}
+
+TEST(MmapStorageTest, PutGetDelete) {
+    std::string path = mmap_path("ops");
+    unlink(path.c_str());
+    MmapStorage storage(path, 1024 * 1024);
+    storage.Start();
+    EXPECT_FALSE(storage.warm());
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY2", "other"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+
+    // Value grows out of its block and shrinks back
+    EXPECT_TRUE(storage.Set("KEY1", std::string(1000, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(std::string(1000, 'x'), value);
+    EXPECT_TRUE(storage.Put("KEY1", "val3"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Value is extended in place while block has room, then moves to a bigger one
+    EXPECT_TRUE(storage.Append("KEY2", "tail"));
+    EXPECT_TRUE(storage.Prepend("KEY2", "head"));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("headval2tail", value);
+    EXPECT_TRUE(storage.Append("KEY2", std::string(100, 't')));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("headval2tail" + std::string(100, 't'), value);
+    EXPECT_FALSE(storage.Append("KEY3", "tail"));
+
+    EXPECT_TRUE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Delete("KEY2"));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+
+    // Expired values are never visible
+    EXPECT_TRUE(storage.Put("KEY4", "val4", std::time(nullptr) - 1));
+    EXPECT_FALSE(storage.Get("KEY4", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4", std::time(nullptr) + 100));
+    EXPECT_TRUE(storage.Get("KEY4", value));
+
+    MmapStorage::Stats stats = storage.GetStats();
+    EXPECT_EQ(2, stats.entries);
+    EXPECT_EQ(16, stats.used_bytes);
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+TEST(MmapStorageTest, DataSurvivesRestart) {
+    std::string path = mmap_path("restart");
+    unlink(path.c_str());
+    auto version = [](MmapStorage &storage, const std::string &key) {
+        uint64_t version = 0;
+        storage.MultiViewCas({key}, [&version](const std::string &, const char *, std::size_t, uint64_t cas) {
+            version = cas;
+        });
+        return version;
+    };
+
+    uint64_t cas;
+    {
+        MmapStorage storage(path, 1024 * 1024);
+        storage.Start();
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(storage.Put("Key " + std::to_string(i), "Value " + std::to_string(i)));
+        }
+        EXPECT_TRUE(storage.Delete("Key 0"));
+        cas = version(storage, "Key 1");
+        storage.Stop();
+    }
+    {
+        MmapStorage storage(path, 1024 * 1024);
+        storage.Start();
+        EXPECT_TRUE(storage.warm());
+        EXPECT_EQ(999, storage.GetStats().entries);
+
+        std::string value;
+        EXPECT_FALSE(storage.Get("Key 0", value));
+        for (int i = 1; i < 1000; ++i) {
+            ASSERT_TRUE(storage.Get("Key " + std::to_string(i), value));
+            EXPECT_EQ("Value " + std::to_string(i), value);
+        }
+
+        std::size_t scanned = 0;
+        EXPECT_TRUE(storage.Scan([&scanned](const char *, std::size_t, const char *, std::size_t, std::time_t) {
+            scanned++;
+        }));
+        EXPECT_EQ(999, scanned);
+
+        // Versions are persistent as well
+        EXPECT_EQ(cas, version(storage, "Key 1"));
+        EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap("Key 1", "Value 1", 0, cas));
+        EXPECT_GT(version(storage, "Key 1"), cas);
+
+        // No Stop, as if process crashed
+        EXPECT_TRUE(storage.Put("Key 0", "Value 0"));
+    }
+
+    MmapStorage storage(path, 1024 * 1024);
+    EXPECT_FALSE(storage.warm());
+    EXPECT_EQ(0, storage.GetStats().entries);
+
+    unlink(path.c_str());
+}
+
+TEST(MmapStorageTest, EvictsWhenFull) {
+    std::string path = mmap_path("evict");
+    unlink(path.c_str());
+    MmapStorage storage(path, 256 * 1024);
+    storage.Start();
+
+    std::string value;
+    for (int i = 0; i < 10000; ++i) {
+        std::string key = "Key " + std::to_string(i);
+        ASSERT_TRUE(storage.Put(key, std::string(100, 'a' + i % 26)));
+
+        // Referenced entry gets a second chance
+        EXPECT_TRUE(storage.Get("Key 0", value));
+    }
+
+    MmapStorage::Stats stats = storage.GetStats();
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_LE(stats.allocated_bytes, stats.file_size);
+    EXPECT_TRUE(storage.Get("Key 0", value));
+    EXPECT_TRUE(storage.Get("Key 9999", value));
+    EXPECT_EQ(std::string(100, 'a' + 9999 % 26), value);
+    storage.Stop();
+
+    unlink(path.c_str());
+}
+
+// Freed blocks merge back, so a big item fits where small ones were
+TEST(MmapStorageTest, FreedBlocksMerge) {
+    std::string path = mmap_path("merge");
+    unlink(path.c_str());
+    MmapStorage storage(path, 1024 * 1024);
+
+    int count = 0;
+    while (storage.GetStats().evictions == 0) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(count++), "value"));
+    }
+    for (int i = 0; i < count; ++i) {
+        storage.Delete("Key " + std::to_string(i));
+    }
+    EXPECT_EQ(0, storage.GetStats().entries);
+
+    uint64_t evictions = storage.GetStats().evictions;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(storage.Put("Big " + std::to_string(i), std::string(200 * 1024, 'b')));
+    }
+    EXPECT_EQ(evictions, storage.GetStats().evictions);
+
+    unlink(path.c_str());
+}
+
+// Item bigger than the ones filling the store evicts about its size, not everything
+TEST(MmapStorageTest, BigItemEvictsItsSize) {
+    std::string path = mmap_path("big");
+    unlink(path.c_str());
+    MmapStorage storage(path, 1024 * 1024);
+
+    int count = 0;
+    while (storage.GetStats().evictions == 0) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(count++), "value"));
+    }
+    std::size_t entries = storage.GetStats().entries;
+
+    std::string value;
+    ASSERT_TRUE(storage.Put("Big", std::string(8000, 'b')));
+    EXPECT_TRUE(storage.Get("Big", value));
+    EXPECT_EQ(std::string(8000, 'b'), value);
+    EXPECT_GT(storage.GetStats().entries, entries - 512);
+
+    unlink(path.c_str());
+}
+
+// Value that couldn't grow stays as it was
+TEST(MmapStorageTest, FailedAppendKeepsValue) {
+    std::string path = mmap_path("append");
+    unlink(path.c_str());
+    MmapStorage storage(path, 1024 * 1024);
+
+    std::string big(200 * 1024, 'a');
+    ASSERT_TRUE(storage.Put("Key", big));
+    EXPECT_FALSE(storage.Append("Key", std::string(100 * 1024, 'b')));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key", value));
+    EXPECT_EQ(big, value);
+
+    unlink(path.c_str());
+}
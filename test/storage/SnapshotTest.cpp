@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "storage/HashLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/SimpleLRU.h"
+#include "storage/SnapshotFile.h"
+#include "storage/Snapshotter.h"
+#include "storage/StripedLRU.h"
+
+using namespace Afina::Backend;
+
+static std::string snapshot_path(const std::string &name) {
+    return "/tmp/afina-" + name + "-" + std::to_string(getpid()) + ".snap";
+}
+
+TEST(SnapshotTest, RoundTrip) {
+    std::string path = snapshot_path("roundtrip");
+    std::time_t now = std::time(nullptr);
+
+    HashLRU source;
+    EXPECT_TRUE(source.Put("KEY1", "val1"));
+    EXPECT_TRUE(source.Put("KEY2", "val2", now + 1000));
+    EXPECT_TRUE(source.Put("KEY3", std::string("va\0l3", 5)));
+    EXPECT_EQ(3, SnapshotFile::Write(source, path));
+
+    HashLRU target;
+    SnapshotFile::LoadStats stats = SnapshotFile::Load(target, path, 1);
+    EXPECT_EQ(3, stats.loaded);
+    EXPECT_EQ(0, stats.expired);
+    EXPECT_EQ(0, stats.corrupted);
+
+    std::string value;
+    EXPECT_TRUE(target.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(target.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_TRUE(target.Get("KEY3", value));
+    EXPECT_EQ(std::string("va\0l3", 5), value);
+
+    // Expire time survives the round trip
+    std::time_t expire = -1;
+    target.Scan([&](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t when) {
+        if (std::string(key, key_size) == "KEY2") {
+            expire = when;
+        }
+    });
+    EXPECT_EQ(now + 1000, expire);
+
+    unlink(path.c_str());
+}
+
+TEST(SnapshotTest, ParallelLoad) {
+    std::string path = snapshot_path("parallel");
+    const int count = 4096;
+    std::string value(1024, 'v');
+
+    LockFreeHash source(16 * 1024 * 1024);
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(source.Put("Key " + std::to_string(i), value + std::to_string(i)));
+    }
+    EXPECT_EQ(count, SnapshotFile::Write(source, path));
+
+    StripedLRU target = StripedLRU::Create_StripedLRU(16 * 1024 * 1024, 4);
+    SnapshotFile::LoadStats stats = SnapshotFile::Load(target, path, 4);
+    EXPECT_EQ(count, stats.loaded);
+    EXPECT_EQ(0, stats.corrupted);
+
+    std::string got;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(target.Get("Key " + std::to_string(i), got));
+        EXPECT_EQ(value + std::to_string(i), got);
+    }
+
+    unlink(path.c_str());
+}
+
+TEST(SnapshotTest, CorruptedAndTruncated) {
+    std::string path = snapshot_path("corrupted");
+    SimpleLRU source;
+    EXPECT_TRUE(source.Put("KEY1", "val1"));
+    SnapshotFile::Write(source, path);
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Flip a byte inside of the first chunk payload: magic, then chunk header
+    std::string broken = bytes;
+    broken[8 + 12 + 4] ^= 1;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << broken;
+
+    SimpleLRU target;
+    SnapshotFile::LoadStats stats = SnapshotFile::Load(target, path, 1);
+    EXPECT_EQ(0, stats.loaded);
+    EXPECT_EQ(1, stats.corrupted);
+
+    // File without the end chunk isn't accepted
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes.substr(0, bytes.size() - 1);
+    EXPECT_THROW(SnapshotFile::Load(target, path, 1), std::runtime_error);
+
+    unlink(path.c_str());
+}
+
+TEST(SnapshotTest, ForkAndRestart) {
+    std::string path = snapshot_path("fork");
+    unlink(path.c_str());
+    {
+        Snapshotter storage(std::make_shared<SimpleLRU>(), path);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        ASSERT_TRUE(storage.Snapshot());
+
+        // Changes made after fork don't get into the snapshot
+        EXPECT_TRUE(storage.Put("KEY3", "val3"));
+        EXPECT_TRUE(storage.Wait());
+        storage.Stop();
+    }
+
+    Snapshotter storage(std::make_shared<SimpleLRU>(), path);
+    storage.Start();
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    storage.Stop();
+
+    unlink(path.c_str());
+}
@@ -1,26 +1,45 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <unistd.h>
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
 
+#include <afina/allocator/Slab.h>
+
+#include "storage/ClockLRU.h"
+#include "storage/FlatCombineLRU.h"
+#include "storage/HashLRU.h"
+#include "storage/LockFreeHash.h"
+#include "storage/ReadBufferedLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/StripedLRU.h"
 
 using namespace Afina::Backend;
 using namespace Afina::Execute;
 using namespace std;
 
+// Every backend must pass the same set of tests
+template <typename T> class StorageTest : public ::testing::Test {};
 
+typedef ::testing::Types<SimpleLRU, HashLRU, ClockLRU, ReadBufferedLRU, FlatCombineLRU> Implementations;
+TYPED_TEST_CASE(StorageTest, Implementations);
 
-
-TEST(StorageTest, PutGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutGet) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -33,8 +52,8 @@ TEST(StorageTest, PutGet) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutOverwrite) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutOverwrite) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY1", "val2"));
@@ -44,8 +63,8 @@ TEST(StorageTest, PutOverwrite) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, PutIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutIfAbsent) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val1"));
 
@@ -56,8 +75,8 @@ TEST(StorageTest, PutIfAbsent) {
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutSetGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutSetGet) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Set("KEY1", "val2"));
@@ -69,8 +88,8 @@ TEST(StorageTest, PutSetGet) {
     EXPECT_TRUE(value == "val2");
 }
 
-TEST(StorageTest, SetIfAbsent) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, SetIfAbsent) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
 
@@ -80,8 +99,8 @@ TEST(StorageTest, SetIfAbsent) {
     EXPECT_TRUE(value == "val1");
 }
 
-TEST(StorageTest, PutDeleteGet) {
-    SimpleLRU storage;
+TYPED_TEST(StorageTest, PutDeleteGet) {
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -95,9 +114,167 @@ TEST(StorageTest, PutDeleteGet) {
 }
 
 
-TEST(StorageTest, GetIfAbsent)
+TYPED_TEST(StorageTest, AppendPrepend) {
+    TypeParam storage(64);
+
+    std::string value;
+    EXPECT_FALSE(storage.Append("KEY1", "tail"));
+    EXPECT_FALSE(storage.Prepend("KEY1", "head"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Append("KEY1", "tail"));
+    EXPECT_TRUE(storage.Prepend("KEY1", "head"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("headval1tail", value);
+
+    // Value that outgrows the storage stays as it was, growth evicts others
+    EXPECT_FALSE(storage.Append("KEY1", std::string(64, 'x')));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("headval1tail", value);
+    EXPECT_TRUE(storage.Append("KEY1", std::string(45, 'x')));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("headval1tail" + std::string(45, 'x'), value);
+}
+
+// Version must change with every write and only the holder of the current one could swap the value
+TYPED_TEST(StorageTest, CompareAndSwap) {
+    TypeParam storage;
+
+    std::map<std::string, uint64_t> versions;
+    auto read = [&storage, &versions](const std::vector<std::string> &keys) {
+        versions.clear();
+        return storage.MultiViewCas(keys, [&versions](const std::string &key, const char *, size_t, uint64_t cas) {
+            versions[key] = cas;
+        });
+    };
+
+    EXPECT_EQ(Afina::Storage::CasResult::kNotFound, storage.CompareAndSwap("KEY1", "val2", 0, 1));
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_EQ(2, read({"KEY1", "KEY2", "KEY3"}));
+    uint64_t first = versions["KEY1"];
+    EXPECT_NE(0, first);
+    EXPECT_NE(first, versions["KEY2"]);
+
+    EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap("KEY1", "val3", 0, first));
+    EXPECT_EQ(Afina::Storage::CasResult::kExists, storage.CompareAndSwap("KEY1", "val4", 0, first));
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    // Any change takes the version away, even if the value looks the same
+    EXPECT_EQ(1, read({"KEY1"}));
+    uint64_t second = versions["KEY1"];
+    EXPECT_NE(first, second);
+    EXPECT_TRUE(storage.Append("KEY1", ""));
+    EXPECT_EQ(Afina::Storage::CasResult::kExists, storage.CompareAndSwap("KEY1", "val5", 0, second));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_EQ(Afina::Storage::CasResult::kNotFound, storage.CompareAndSwap("KEY1", "val5", 0, second));
+}
+
+TYPED_TEST(StorageTest, IncrementDecrement) {
+    TypeParam storage;
+
+    uint64_t value = 0;
+    EXPECT_EQ(Afina::Storage::IncrResult::kNotFound, storage.Increment("KEY1", 1, value));
+    EXPECT_TRUE(storage.Put("KEY1", "10"));
+    EXPECT_TRUE(storage.Put("KEY2", "ten"));
+    EXPECT_EQ(Afina::Storage::IncrResult::kNotNumber, storage.Increment("KEY2", 1, value));
+
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 5, value));
+    EXPECT_EQ(15, value);
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Decrement("KEY1", 100, value));
+    EXPECT_EQ(0, value);
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 18446744073709551615ull, value));
+    EXPECT_EQ(18446744073709551615ull, value);
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 2, value));
+    EXPECT_EQ(1, value);
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 122, value));
+
+    // Counter reads and extends as digits
+    std::string text;
+    EXPECT_TRUE(storage.Get("KEY1", text));
+    EXPECT_EQ("123", text);
+    EXPECT_TRUE(storage.Append("KEY1", "4"));
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Decrement("KEY1", 4, value));
+    EXPECT_EQ(1230, value);
+    EXPECT_TRUE(storage.Prepend("KEY1", "x"));
+    EXPECT_EQ(Afina::Storage::IncrResult::kNotNumber, storage.Increment("KEY1", 1, value));
+    EXPECT_TRUE(storage.Get("KEY1", text));
+    EXPECT_EQ("x1230", text);
+}
+
+// Keys are referenced right in a request buffer, as they come from the network
+void check_key_refs(Afina::Storage &storage) {
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+
+    const char buffer[] = "get KEY1 KEY3 KEY2";
+    Afina::KeyRef key1(buffer + 4, 4), key3(buffer + 9, 4), key2(buffer + 14, 4);
+    EXPECT_EQ(Afina::HashKey("KEY1"), key1.hash);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get(key1, value));
+    EXPECT_EQ("val1", value);
+    EXPECT_FALSE(storage.Get(key3, value));
+    EXPECT_TRUE(storage.View(key2, [&value](const char *data, size_t size) { value.assign(data, size); }));
+    EXPECT_EQ("val2", value);
+
+    std::map<std::string, std::string> values;
+    std::vector<Afina::KeyRef> keys = {key1, key3, key2};
+    EXPECT_EQ(2, storage.MultiView(keys, [&values](const Afina::KeyRef &key, const char *data, size_t size) {
+        values[key.str()].assign(data, size);
+    }));
+    EXPECT_EQ("val1", values["KEY1"]);
+    EXPECT_EQ("val2", values["KEY2"]);
+
+    EXPECT_TRUE(storage.Delete(key1));
+    EXPECT_FALSE(storage.Delete(key1));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+}
+
+TYPED_TEST(StorageTest, KeyRefLookups) {
+    TypeParam storage;
+    check_key_refs(storage);
+}
+
+TYPED_TEST(StorageTest, PutView) {
+    TypeParam storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    std::string value;
+    auto visitor = [&value](const char *data, size_t size) { value.assign(data, size); };
+    EXPECT_TRUE(storage.View("KEY1", visitor));
+    EXPECT_EQ("val1", value);
+
+    value.clear();
+    EXPECT_FALSE(storage.View("KEY2", visitor));
+    EXPECT_TRUE(value.empty());
+}
+
+TYPED_TEST(StorageTest, PutMultiView) {
+    TypeParam storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    std::map<std::string, std::string> values;
+    auto visitor = [&values](const std::string &key, const char *data, size_t size) {
+        values[key].assign(data, size);
+    };
+    EXPECT_EQ(2, storage.MultiView({"KEY1", "KEY2", "KEY3"}, visitor));
+    EXPECT_EQ(2, values.size());
+    EXPECT_EQ("val1", values["KEY1"]);
+    EXPECT_EQ("val3", values["KEY3"]);
+}
+
+TYPED_TEST(StorageTest, GetIfAbsent)
 {
-    SimpleLRU storage;
+    TypeParam storage;
 
 
     std::string value;
@@ -108,9 +285,9 @@ TEST(StorageTest, GetIfAbsent)
     EXPECT_FALSE(storage.Get("KEY3", value));
 }
 
-TEST(StorageTest, DeleteIfAbsent)
+TYPED_TEST(StorageTest, DeleteIfAbsent)
 {
-    SimpleLRU storage;
+    TypeParam storage;
     EXPECT_FALSE(storage.Delete("KEY1"));
 
     EXPECT_FALSE(storage.Delete("KEY2"));
@@ -118,9 +295,9 @@ TEST(StorageTest, DeleteIfAbsent)
     EXPECT_FALSE(storage.Delete("KEY3"));
 }
 
-TEST(StorageTest, DeleteHeadAndTailNode)
+TYPED_TEST(StorageTest, DeleteHeadAndTailNode)
 {
-    SimpleLRU storage;
+    TypeParam storage;
 
     EXPECT_TRUE(storage.Put("KEY1", "val1"));
     EXPECT_TRUE(storage.Put("KEY2", "val2"));
@@ -139,15 +316,48 @@ TEST(StorageTest, DeleteHeadAndTailNode)
     EXPECT_TRUE(storage.Delete("KEY1"));
 }
 
+// Promote nodes from the middle of the list and then evict, list links must stay consistent
+TYPED_TEST(StorageTest, GetMiddleThenEvict) {
+    TypeParam storage(4 * 8);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Put("KEY4", "val4"));
+    EXPECT_TRUE(storage.Put("KEY5", "val5"));
+    EXPECT_TRUE(storage.Put("KEY6", "val6"));
+    EXPECT_TRUE(storage.Put("KEY7", "val7"));
+
+    EXPECT_TRUE(storage.Delete("KEY7"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY6", value));
+    EXPECT_EQ("val6", value);
+}
+
+TYPED_TEST(StorageTest, DeleteSingleNode) {
+    TypeParam storage;
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_TRUE(storage.Put("KEY1", "val2"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val2", value);
+}
+
 std::string pad_space(const std::string &s, size_t length) {
     std::string result = s;
     result.resize(length, ' ');
     return result;
 }
 
-TEST(StorageTest, BigTest) {
+TYPED_TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    TypeParam storage(2 * 100000 * length);
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -166,9 +376,9 @@ TEST(StorageTest, BigTest) {
     }
 }
 
-TEST(StorageTest, MaxTest) {
+TYPED_TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    TypeParam storage(2 * 1000 * length);
 
     std::stringstream ss;
 
@@ -195,3 +405,738 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+// Expire time in the past takes the value away at once, future one keeps it until then
+TYPED_TEST(StorageTest, ExpiredIsInvisible) {
+    TypeParam storage;
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", now + 3600));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Put("KEY2", "val22", now - 1));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3", -1));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val1", value);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+
+    // Past expire time drops existing value as well, CAS included
+    EXPECT_TRUE(storage.Set("KEY1", "val11", now - 1));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+
+    uint64_t cas = 0;
+    EXPECT_EQ(1, storage.MultiViewCas({"KEY3"}, [&cas](const std::string &, const char *, size_t, uint64_t version) {
+        cas = version;
+    }));
+    EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap("KEY3", "val33", now - 1, cas));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+}
+
+// Writes that don't take expire time keep the one entry has, Scan reports it
+TYPED_TEST(StorageTest, ExpireKept) {
+    TypeParam storage;
+    std::time_t expire = std::time(nullptr) + 3600;
+
+    EXPECT_TRUE(storage.Put("KEY1", "1", expire));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Append("KEY1", "0"));
+    uint64_t value = 0;
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 5, value));
+    EXPECT_EQ(15, value);
+
+    std::map<std::string, std::time_t> scanned;
+    storage.Scan([&scanned](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t when) {
+        scanned[std::string(key, key_size)] = when;
+    });
+    EXPECT_EQ(2, scanned.size());
+    EXPECT_EQ(expire, scanned["KEY1"]);
+    EXPECT_EQ(0, scanned["KEY2"]);
+
+    // Plain Put is a new value without expire time
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    storage.Scan([&scanned](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t when) {
+        scanned[std::string(key, key_size)] = when;
+    });
+    EXPECT_EQ(0, scanned["KEY1"]);
+}
+
+// Entry goes away once its time comes, every kind of lookup misses it
+TYPED_TEST(StorageTest, ExpireInTime) {
+    TypeParam storage;
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", now + 1));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ(1, storage.MultiView({"KEY1", "KEY2"}, [](const std::string &key, const char *, size_t) {
+        EXPECT_EQ("KEY2", key);
+    }));
+    EXPECT_FALSE(storage.Append("KEY1", "data"));
+    uint64_t counter = 0;
+    EXPECT_EQ(Afina::Storage::IncrResult::kNotFound, storage.Increment("KEY1", 1, counter));
+    EXPECT_FALSE(storage.Set("KEY1", "val11"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY1", "val11"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val11", value);
+}
+
+TEST(StripedLRUTest, MultiView) {
+    StripedLRU storage = StripedLRU::Create_StripedLRU(16 * 1024, 4);
+
+    std::vector<std::string> keys;
+    for (int i = 0; i < 64; ++i) {
+        keys.push_back("Key " + std::to_string(i));
+        if (i % 2 == 0) {
+            EXPECT_TRUE(storage.Put(keys.back(), "Val " + std::to_string(i)));
+        }
+    }
+
+    std::map<std::string, std::string> values;
+    EXPECT_EQ(32, storage.MultiView(keys, [&values](const std::string &key, const char *data, size_t size) {
+        values[key].assign(data, size);
+    }));
+    for (int i = 0; i < 64; i += 2) {
+        EXPECT_EQ("Val " + std::to_string(i), values[keys[i]]);
+    }
+}
+
+TEST(StripedLRUTest, KeyRefLookups) {
+    StripedLRU storage = StripedLRU::Create_StripedLRU(16 * 1024, 4);
+    check_key_refs(storage);
+}
+
+// Expire time is passed to the stripe
+TEST(StripedLRUTest, Expire) {
+    StripedLRU storage = StripedLRU::Create_StripedLRU(16 * 1024, 4);
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", now + 3600));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_TRUE(storage.Set("KEY2", "val22", now - 1));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3", now - 1));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+
+    std::time_t scanned = 0;
+    storage.Scan([&scanned](const char *, std::size_t, const char *, std::size_t, std::time_t when) {
+        scanned = when;
+    });
+    EXPECT_EQ(now + 3600, scanned);
+}
+
+TEST(StripedLRUTest, StripeCount) {
+    EXPECT_EQ(4, StripedLRU::Create_StripedLRU(16 * 1024, 3).stripe_count());
+    EXPECT_EQ(1, StripedLRU::Create_StripedLRU(1024).stripe_count());
+
+    size_t count = StripedLRU::Create_StripedLRU(1024 * 1024).stripe_count();
+    EXPECT_EQ(0, count & (count - 1));
+    EXPECT_GE(count, std::min<size_t>(2 * std::thread::hardware_concurrency(), 512));
+}
+
+// All keys fall into one shard, it must get budget of the idle ones instead of thrashing in own quarter
+TEST(StripedLRUTest, SkewedKeysBorrowBudget) {
+    const size_t length = 20;
+    StripedLRU storage = StripedLRU::Create_StripedLRU(4 * 4096, 4);
+
+    std::vector<std::string> keys;
+    for (long i = 0; keys.size() < 1000; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        if ((HashKey(key) & 3) == 0) {
+            keys.push_back(key);
+        }
+    }
+    for (int round = 0; round < 20; ++round) {
+        for (auto &key : keys) {
+            EXPECT_TRUE(storage.Put(key, pad_space("Val", length)));
+        }
+    }
+
+    std::vector<SimpleLRU::Stats> stats = storage.GetShardStats();
+    size_t total = 0;
+    for (auto &shard : stats) {
+        total += shard.max_size;
+    }
+    EXPECT_LE(total, 4 * 4096);
+    EXPECT_GE(stats[0].max_size, 3 * 4096);
+    EXPECT_GT(stats[0].evictions, 0);
+    EXPECT_EQ(0, stats[1].evictions);
+
+    size_t found = 0;
+    std::string value;
+    for (auto &key : keys) {
+        found += storage.Get(key, value);
+    }
+    EXPECT_GT(found, 4096 / (2 * length));
+}
+
+// Readers run under the shared lock while writer keeps evicting, nobody should see a torn value
+TEST(ClockLRUTest, ConcurrentReaders) {
+    ClockLRU storage(64 * 1024);
+    for (int i = 0; i < 1000; ++i) {
+        storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i));
+    }
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 20000; ++i) {
+                int k = (i * 7 + t) % 2000;
+                if (storage.Get("Key " + std::to_string(k), value)) {
+                    EXPECT_EQ("Val " + std::to_string(k), value);
+                }
+            }
+        });
+    }
+
+    for (int i = 1000; i < 20000; ++i) {
+        int k = i % 2000;
+        storage.Put("Key " + std::to_string(k), "Val " + std::to_string(k));
+    }
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    auto stats = storage.GetStats();
+    EXPECT_EQ(4u * 20000, stats.hits + stats.misses);
+    EXPECT_LE(stats.size, stats.max_size);
+}
+
+// Readers run under the shared lock while writer keeps evicting. Hits are applied before each eviction, so
+// the key read between writes stays, and none of them is lost from the counters
+TEST(ReadBufferedLRUTest, ConcurrentReaders) {
+    ReadBufferedLRU storage(8 * 1024);
+    for (int i = 0; i < 1000; ++i) {
+        storage.Put("Key " + std::to_string(i), "Val " + std::to_string(i));
+    }
+
+    storage.Put("Key 0", "Val 0");
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 20000; ++i) {
+                int k = i % 2 ? 0 : (i * 7 + t) % 2000;
+                if (storage.Get("Key " + std::to_string(k), value)) {
+                    EXPECT_EQ("Val " + std::to_string(k), value);
+                }
+            }
+        });
+    }
+
+    std::string value;
+    for (int i = 1000; i < 20000; ++i) {
+        int k = i % 2000;
+        storage.Put("Key " + std::to_string(k), "Val " + std::to_string(k));
+
+        if (i % 100 == 0) {
+            EXPECT_TRUE(storage.Get("Key 0", value));
+        }
+    }
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_TRUE(storage.Get("Key 0", value));
+    EXPECT_EQ("Val 0", value);
+    auto stats = storage.GetStats();
+    EXPECT_EQ(4u * 20000 + 191, stats.hits + stats.misses);
+}
+
+// Calls of all threads are executed one at a time by combiners, so none of the increments is lost
+TEST(FlatCombineLRUTest, ConcurrentIncrements) {
+    FlatCombineLRU storage(1024 * 1024);
+    EXPECT_TRUE(storage.Put("COUNTER", "0"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&storage, t]() {
+            uint64_t value;
+            std::string own = "KEY" + std::to_string(t), out;
+            for (int i = 0; i < 5000; ++i) {
+                EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("COUNTER", 1, value));
+                EXPECT_TRUE(storage.Put(own, std::to_string(i)));
+                EXPECT_TRUE(storage.Get(own, out));
+                EXPECT_EQ(std::to_string(i), out);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("COUNTER", value));
+    EXPECT_EQ("20000", value);
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ("4999", value);
+}
+
+// CLOCK over hash buckets evicts in no particular order, so it is checked apart from the exact LRU ones
+TEST(LockFreeHashTest, Basic) {
+    LockFreeHash storage;
+
+    std::string value;
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+    EXPECT_TRUE(storage.Set("KEY1", "val11"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val11", value);
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+
+    EXPECT_TRUE(storage.Put("KEY1", "val12"));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val12", value);
+    EXPECT_FALSE(storage.Put("Big", std::string(1024, 'b')));
+
+    auto stats = storage.GetStats();
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(0u, stats.evictions);
+    EXPECT_EQ(17u, stats.size);
+}
+
+TEST(LockFreeHashTest, KeyRefLookups) {
+    LockFreeHash storage;
+    check_key_refs(storage);
+}
+
+// Expired value is taken away by the first lookup and isn't counted in the size anymore
+TEST(LockFreeHashTest, Expire) {
+    LockFreeHash storage;
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("KEY1", "1", now + 3600));
+    EXPECT_TRUE(storage.Put("KEY2", "val2", now + 1));
+    EXPECT_TRUE(storage.Put("KEY3", "val3"));
+    EXPECT_TRUE(storage.Set("KEY3", "val33", now - 1));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY4", "val4", -1));
+
+    // Append and Increment keep expire time
+    EXPECT_TRUE(storage.Append("KEY1", "0"));
+    uint64_t value = 0;
+    EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 5, value));
+    EXPECT_EQ(15, value);
+
+    std::string out;
+    EXPECT_FALSE(storage.Get("KEY3", out));
+    EXPECT_FALSE(storage.Get("KEY4", out));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    EXPECT_FALSE(storage.Get("KEY2", out));
+    EXPECT_FALSE(storage.Set("KEY2", "val22"));
+    EXPECT_EQ(6u, storage.GetStats().size);
+
+    std::time_t scanned = 0;
+    storage.Scan([&scanned](const char *, std::size_t, const char *, std::size_t, std::time_t when) {
+        scanned = when;
+    });
+    EXPECT_EQ(now + 3600, scanned);
+
+    uint64_t cas = 0;
+    EXPECT_EQ(1, storage.MultiViewCas({"KEY1"}, [&cas](const std::string &, const char *, size_t, uint64_t version) {
+        cas = version;
+    }));
+    EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap("KEY1", "val1", now - 1, cas));
+    EXPECT_FALSE(storage.Get("KEY1", out));
+    EXPECT_EQ(0u, storage.GetStats().size);
+}
+
+TEST(LockFreeHashTest, EvictionBound) {
+    const size_t length = 20;
+    LockFreeHash storage(2 * 1000 * length);
+
+    for (long i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(storage.Put(pad_space("Key " + std::to_string(i), length),
+                                pad_space("Val " + std::to_string(i), length)));
+    }
+
+    size_t found = 0;
+    std::string value;
+    for (long i = 0; i < 10000; ++i) {
+        found += storage.Get(pad_space("Key " + std::to_string(i), length), value);
+    }
+    EXPECT_LE(found, 1000);
+    EXPECT_GE(found, 500);
+    EXPECT_TRUE(storage.Get(pad_space("Key 9999", length), value));
+
+    auto stats = storage.GetStats();
+    EXPECT_EQ(found + 1, stats.hits);
+    EXPECT_EQ(10000 - found, stats.misses);
+    EXPECT_EQ(10000 - found, stats.evictions);
+}
+
+// Appends racing for the same key are never lost
+TEST(LockFreeHashTest, ConcurrentAppends) {
+    LockFreeHash storage(1024 * 1024);
+    EXPECT_TRUE(storage.Put("KEY", ""));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&storage, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                EXPECT_TRUE(storage.Append("KEY", std::string(1, 'a' + t)));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY", value));
+    for (int t = 0; t < 4; ++t) {
+        EXPECT_EQ(1000, std::count(value.begin(), value.end(), 'a' + t));
+    }
+}
+
+// Counter incremented by read-modify-write loops, none of the increments should be lost
+TEST(LockFreeHashTest, ConcurrentCompareAndSwap) {
+    LockFreeHash storage(1024 * 1024);
+    EXPECT_TRUE(storage.Put("KEY", "0"));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&storage]() {
+            std::vector<std::string> keys{"KEY"};
+            for (int i = 0; i < 1000; ++i) {
+                Afina::Storage::CasResult result;
+                do {
+                    std::string value;
+                    uint64_t version = 0;
+                    storage.MultiViewCas(keys, [&](const std::string &, const char *data, size_t size, uint64_t cas) {
+                        value.assign(data, size);
+                        version = cas;
+                    });
+                    result = storage.CompareAndSwap("KEY", std::to_string(std::stoi(value) + 1), 0, version);
+                } while (result == Afina::Storage::CasResult::kExists);
+                EXPECT_EQ(Afina::Storage::CasResult::kStored, result);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY", value));
+    EXPECT_EQ("4000", value);
+}
+
+// Writers update, delete and evict while readers run, nobody should see a torn or foreign value
+TEST(LockFreeHashTest, ConcurrentWriters) {
+    LockFreeHash storage(16 * 1024);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&storage, t]() {
+            std::string value;
+            for (int i = 0; i < 50000; ++i) {
+                int k = (i * 7 + t) % 2000;
+                std::string key = "Key " + std::to_string(k);
+                switch ((i + t) % 4) {
+                case 0:
+                    storage.Put(key, "Val " + std::to_string(k) + std::string(k % 16, '.'));
+                    break;
+                case 1:
+                    storage.Delete(key);
+                    break;
+                default:
+                    if (storage.Get(key, value)) {
+                        EXPECT_EQ("Val " + std::to_string(k) + std::string(k % 16, '.'), value);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(HashLRUTest, ExpiredIsInvisible) {
+    HashLRU storage;
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1", now + 3600));
+    EXPECT_TRUE(storage.Put("KEY2", "val2", now - 1));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3", -1));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_TRUE(value == "val1");
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_FALSE(storage.Get("KEY3", value));
+
+    // Past expire time drops existing value as well
+    EXPECT_TRUE(storage.Set("KEY1", "val11", now - 1));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+}
+
+// Expired items must free room by the timer wheel before LRU has to evict anything live
+TEST(HashLRUTest, ReclaimExpired) {
+    HashLRU storage(100);
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("live", "0123456789"));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Put("key" + std::to_string(i), "012345", now + 3600));
+    }
+
+    // Item expire time can't be set to the past directly, shift all of them by a short-lived overwrite
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Set("key" + std::to_string(i), "012345", now + 1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    storage.Reclaim(1000);
+
+    // 8 * 10 bytes are free now, so nothing live gets evicted
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Put("new" + std::to_string(i), "012345"));
+    }
+    std::string value;
+    EXPECT_TRUE(storage.Get("live", value));
+    EXPECT_TRUE(value == "0123456789");
+}
+
+// Later expire time doesn't get a timer of its own, the pending one is moved to it once it fires
+TEST(HashLRUTest, ReclaimAfterLaterExpire) {
+    HashLRU storage(100);
+    std::time_t now = std::time(nullptr);
+
+    EXPECT_TRUE(storage.Put("live", "0123456789"));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Put("key" + std::to_string(i), "012345", now + 1));
+        EXPECT_TRUE(storage.Set("key" + std::to_string(i), "012345", now + 4));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    storage.Reclaim(1000);
+
+    // Nothing is removed by the early timers, and "live" is the LRU tail now
+    std::string value;
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Get("key" + std::to_string(i), value));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    storage.Reclaim(1000);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(storage.Put("new" + std::to_string(i), "012345"));
+    }
+    EXPECT_TRUE(storage.Get("live", value));
+}
+
+// With slab allocator storage never goes above the allocator ceiling and evicts within size class
+TEST(HashLRUTest, SlabCeiling) {
+    auto slab = std::make_shared<Afina::Allocator::Slab>(16 * 4096, 4096);
+    HashLRU storage(slab);
+
+    std::string value(100, 'v');
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), value));
+    }
+    EXPECT_EQ(16 * 4096, slab->memory_used());
+
+    std::string out;
+    EXPECT_TRUE(storage.Get("Key 9999", out));
+    EXPECT_TRUE(out == value);
+    EXPECT_FALSE(storage.Get("Key 0", out));
+
+    // Value of the same size class is updated in place even though there is no free memory
+    EXPECT_TRUE(storage.Set("Key 9999", std::string(99, 'w')));
+    EXPECT_TRUE(storage.Get("Key 9999", out));
+    EXPECT_TRUE(out == std::string(99, 'w'));
+
+    EXPECT_FALSE(storage.Put("Big", std::string(4096, 'b')));
+}
+
+// Class without free chunks takes the slab of the LRU tail once memory is taken by another class
+TEST(HashLRUTest, SlabMovesBetweenClasses) {
+    auto slab = std::make_shared<Afina::Allocator::Slab>(4 * 1024 * 1024);
+    HashLRU storage(slab);
+
+    for (int i = 0; i < 200000; ++i) {
+        ASSERT_TRUE(storage.Put("Key " + std::to_string(i), "value"));
+    }
+    EXPECT_EQ(4 * 1024 * 1024, slab->memory_used());
+
+    std::string big(8 * 1024, 'b');
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(storage.Put("Big " + std::to_string(i), big));
+    }
+    EXPECT_EQ(4 * 1024 * 1024, slab->memory_used());
+
+    std::string out;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(storage.Get("Big " + std::to_string(i), out));
+        EXPECT_TRUE(out == big);
+    }
+    EXPECT_FALSE(storage.Get("Key 0", out));
+
+    // Only items of the moved slab are gone, wherever they were in the list
+    int alive = 0;
+    for (int i = 190000; i < 200000; ++i) {
+        alive += storage.Get("Key " + std::to_string(i), out);
+    }
+    EXPECT_GT(alive, 5000);
+}
+
+// Appended value moves to bigger chunks as it grows, with its place in the list and expire time
+TEST(HashLRUTest, AppendGrowsThroughSlabClasses) {
+    for (bool slab : {false, true}) {
+        std::unique_ptr<HashLRU> storage(slab ? new HashLRU(std::make_shared<Afina::Allocator::Slab>(64 * 1024 * 1024))
+                                              : new HashLRU(1024 * 1024));
+        std::time_t expire = std::time(nullptr) + 3600;
+        EXPECT_TRUE(storage->Put("KEY1", "", expire));
+        EXPECT_TRUE(storage->Put("KEY2", "val2"));
+
+        std::string expected;
+        for (int i = 0; i < 1000; ++i) {
+            std::string line = "line " + std::to_string(i) + "\n";
+            EXPECT_TRUE(i % 2 ? storage->Append("KEY1", line) : storage->Prepend("KEY1", line));
+            expected = i % 2 ? expected + line : line + expected;
+        }
+
+        std::string value;
+        EXPECT_TRUE(storage->Get("KEY1", value));
+        EXPECT_EQ(expected, value);
+
+        std::vector<std::string> keys;
+        std::time_t scanned = 0;
+        storage->Scan([&](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t expire) {
+            keys.emplace_back(key, key_size);
+            if (keys.back() == "KEY1") {
+                scanned = expire;
+            }
+        });
+        EXPECT_EQ(std::vector<std::string>({"KEY2", "KEY1"}), keys);
+        EXPECT_EQ(expire, scanned);
+    }
+}
+
+// Room kept for further appends never lets value outgrow the storage
+TEST(HashLRUTest, AppendUpToLimit) {
+    HashLRU storage(64);
+    EXPECT_TRUE(storage.Put("K", "v"));
+    std::string expected = "v";
+    while (expected.size() < 63) {
+        EXPECT_TRUE(storage.Append("K", "x"));
+        expected += "x";
+    }
+    EXPECT_FALSE(storage.Append("K", "x"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("K", value));
+    EXPECT_EQ(expected, value);
+    EXPECT_TRUE(storage.Put("K", std::string(63, 'y')));
+    EXPECT_TRUE(storage.Get("K", value));
+    EXPECT_EQ(std::string(63, 'y'), value);
+}
+
+// Counter is kept in binary, but every reader sees decimal digits
+TEST(HashLRUTest, BinaryCounter) {
+    HashLRU storage(1024);
+    EXPECT_TRUE(storage.Put("KEY1", "99"));
+    uint64_t value = 0;
+    for (int i = 0; i < 901; ++i) {
+        EXPECT_EQ(Afina::Storage::IncrResult::kUpdated, storage.Increment("KEY1", 1, value));
+    }
+    EXPECT_EQ(1000, value);
+
+    std::string viewed;
+    EXPECT_TRUE(storage.View("KEY1", [&viewed](const char *data, std::size_t size) { viewed.assign(data, size); }));
+    EXPECT_EQ("1000", viewed);
+    EXPECT_EQ(1, storage.MultiView({"KEY1"}, [&viewed](const std::string &, const char *data, std::size_t size) {
+        viewed.assign(data, size);
+    }));
+    EXPECT_EQ("1000", viewed);
+    storage.Scan([&viewed](const char *, std::size_t, const char *data, std::size_t size, std::time_t) {
+        viewed.assign(data, size);
+    });
+    EXPECT_EQ("1000", viewed);
+
+    // Text written over the counter is taken as is, even if it is as long as the binary one
+    EXPECT_TRUE(storage.Put("KEY1", "12345678"));
+    EXPECT_TRUE(storage.Get("KEY1", viewed));
+    EXPECT_EQ("12345678", viewed);
+}
+
+// Items left in shared memory by graceful Stop are picked up by the next storage with the same segment
+TEST(HashLRUTest, WarmRestart) {
+    std::string segment = "/afina-test-" + std::to_string(getpid());
+    WarmSegment::Remove(segment);
+    std::time_t expire = std::time(nullptr) + 1000;
+    {
+        HashLRU storage(segment, 16 * 1024 * 1024);
+        storage.Start();
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(storage.Put("Key " + std::to_string(i), std::string(i, 'v')));
+        }
+        EXPECT_TRUE(storage.Put("Timed", "value", expire));
+        EXPECT_TRUE(storage.Delete("Key 50"));
+        std::string out;
+        EXPECT_TRUE(storage.Get("Key 0", out));
+        storage.Stop();
+    }
+
+    std::vector<std::string> order;
+    {
+        HashLRU storage(segment, 16 * 1024 * 1024);
+        storage.Start();
+
+        // LRU order and expire time survive as well
+        storage.Scan([&](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t when) {
+            order.emplace_back(key, key_size);
+            if (order.back() == "Timed") {
+                EXPECT_EQ(expire, when);
+            }
+        });
+        ASSERT_EQ(100, order.size());
+        EXPECT_EQ("Key 1", order.front());
+        EXPECT_EQ("Timed", order[order.size() - 2]);
+        EXPECT_EQ("Key 0", order.back());
+
+        std::string out;
+        for (int i = 0; i < 100; ++i) {
+            if (i == 50) {
+                EXPECT_FALSE(storage.Get("Key 50", out));
+                continue;
+            }
+            ASSERT_TRUE(storage.Get("Key " + std::to_string(i), out));
+            EXPECT_EQ(std::string(i, 'v'), out);
+        }
+
+        // Restored chunks are never handed out again
+        for (int i = 0; i < 20; ++i) {
+            ASSERT_TRUE(storage.Put("New " + std::to_string(i), std::string(i, 'n')));
+        }
+        ASSERT_TRUE(storage.Get("Key 99", out));
+        EXPECT_EQ(std::string(99, 'v'), out);
+    }
+
+    // Without Stop segment is dirty, so the next start is cold
+    HashLRU storage(segment, 16 * 1024 * 1024);
+    storage.Start();
+    std::string out;
+    EXPECT_FALSE(storage.Get("Key 99", out));
+    WarmSegment::Remove(segment);
+}
@@ -0,0 +1,287 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "storage/ExtentStore.h"
+#include "storage/TieredLRU.h"
+
+using namespace Afina::Backend;
+
+static std::string tier_path(const std::string &name) {
+    return "/tmp/afina-" + name + "-" + std::to_string(getpid()) + ".tier";
+}
+
+// 20 bytes of key and value, 32 bytes of extent record
+static std::string key_of(int i) { return "Key " + std::to_string(1000 + i); }
+static std::string value_of(int i) { return "Value " + std::to_string(100000 + i); }
+
+TEST(TieredLRUTest, EvictedEntriesAreDemotedAndPromoted) {
+    TieredLRU storage(tier_path("demote"), 100, 16 * 1024, 1024);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put(key_of(i), value_of(i)));
+    }
+
+    TieredLRU::Stats stats = storage.GetStats();
+    EXPECT_EQ(5, stats.demotions);
+    EXPECT_EQ(5, stats.disk.entries);
+
+    // Recent entries are in RAM, older ones come back from the file and push those out
+    std::string value;
+    for (int i = 9; i >= 0; --i) {
+        ASSERT_TRUE(storage.Get(key_of(i), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+    EXPECT_FALSE(storage.Get("Key none", value));
+
+    stats = storage.GetStats();
+    EXPECT_EQ(5, stats.ram_hits);
+    EXPECT_EQ(6, stats.ram_misses);
+    EXPECT_EQ(5, stats.disk_hits);
+    EXPECT_EQ(1, stats.disk_misses);
+    EXPECT_EQ(5, stats.promotions);
+    EXPECT_EQ(5, stats.disk.entries);
+
+    // Each key lives in one tier only
+    EXPECT_FALSE(storage.PutIfAbsent(key_of(0), "other"));
+    EXPECT_FALSE(storage.PutIfAbsent(key_of(9), "other"));
+    EXPECT_TRUE(storage.Set(key_of(0), "new"));
+    EXPECT_TRUE(storage.Delete(key_of(1)));
+    EXPECT_FALSE(storage.Get(key_of(1), value));
+    EXPECT_TRUE(storage.Get(key_of(0), value));
+    EXPECT_EQ("new", value);
+}
+
+TEST(TieredLRUTest, MultiViewReadsColdKeys) {
+    TieredLRU storage(tier_path("multiview"), 100, 64 * 1024, 1024);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(key_of(i));
+        EXPECT_TRUE(storage.Put(key_of(i), value_of(i)));
+    }
+    keys.push_back("Key none");
+    EXPECT_GT(storage.GetStats().disk.extents_used, 2);
+
+    std::map<std::string, std::string> found;
+    EXPECT_EQ(100, storage.MultiView(keys, [&found](const std::string &key, const char *value, std::size_t size) {
+                  found[key] = std::string(value, size);
+              }));
+    ASSERT_EQ(100, found.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(value_of(i), found[key_of(i)]);
+    }
+
+    TieredLRU::Stats stats = storage.GetStats();
+    EXPECT_EQ(95, stats.disk_hits);
+    EXPECT_EQ(1, stats.disk_misses);
+}
+
+TEST(TieredLRUTest, AppendToColdEntry) {
+    TieredLRU storage(tier_path("append"), 100, 16 * 1024, 1024);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put(key_of(i), value_of(i)));
+    }
+
+    // Cold entry is promoted, the one that outgrows RAM goes to the file
+    std::string value;
+    EXPECT_TRUE(storage.Append(key_of(0), "+"));
+    EXPECT_TRUE(storage.Prepend(key_of(9), std::string(100, '-')));
+    EXPECT_TRUE(storage.Get(key_of(0), value));
+    EXPECT_EQ(value_of(0) + "+", value);
+    EXPECT_TRUE(storage.Get(key_of(9), value));
+    EXPECT_EQ(std::string(100, '-') + value_of(9), value);
+    EXPECT_FALSE(storage.Append("Key none", "+"));
+}
+
+TEST(TieredLRUTest, CompareAndSwapInBothTiers) {
+    TieredLRU storage(tier_path("cas"), 100, 16 * 1024, 1024);
+    std::map<std::string, uint64_t> versions;
+    auto read = [&storage, &versions](const std::string &key) {
+        storage.MultiViewCas({key}, [&versions](const std::string &key, const char *, std::size_t, uint64_t cas) {
+            versions[key] = cas;
+        });
+        return versions[key];
+    };
+
+    // Entry too big for RAM lives in the file only
+    std::string big(100, 'x'), value;
+    EXPECT_TRUE(storage.Put(key_of(0), big));
+    EXPECT_TRUE(storage.Put(key_of(1), value_of(1)));
+    uint64_t cold = read(key_of(0));
+    uint64_t hot = read(key_of(1));
+    EXPECT_NE(0, cold);
+    EXPECT_NE(cold, hot);
+
+    EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap(key_of(0), big + "y", 0, cold));
+    EXPECT_EQ(Afina::Storage::CasResult::kExists, storage.CompareAndSwap(key_of(0), big, 0, cold));
+    EXPECT_TRUE(storage.Get(key_of(0), value));
+    EXPECT_EQ(big + "y", value);
+
+    // Value that outgrows RAM moves to the file
+    EXPECT_EQ(Afina::Storage::CasResult::kStored, storage.CompareAndSwap(key_of(1), big, 0, hot));
+    EXPECT_EQ(Afina::Storage::CasResult::kExists, storage.CompareAndSwap(key_of(1), big, 0, hot));
+    EXPECT_TRUE(storage.Get(key_of(1), value));
+    EXPECT_EQ(big, value);
+    EXPECT_EQ(Afina::Storage::CasResult::kNotFound, storage.CompareAndSwap("Key none", big, 0, hot));
+}
+
+// Expire time moves between tiers with the entry, both of them drop expired entries
+TEST(TieredLRUTest, ExpireFollowsEntry) {
+    TieredLRU storage(tier_path("expire"), 100, 16 * 1024, 1024);
+    std::time_t now = std::time(nullptr);
+    EXPECT_TRUE(storage.Put(key_of(0), value_of(0), now + 3600));
+    EXPECT_TRUE(storage.Put(key_of(1), value_of(1), now + 1));
+    EXPECT_TRUE(storage.Put(key_of(2), value_of(2)));
+    for (int i = 3; i < 10; ++i) {
+        EXPECT_TRUE(storage.Put(key_of(i), value_of(i)));
+    }
+    EXPECT_EQ(5, storage.GetStats().disk.entries);
+
+    std::map<std::string, std::time_t> expires;
+    auto scan = [&storage, &expires]() {
+        expires.clear();
+        storage.Scan([&expires](const char *key, std::size_t key_size, const char *, std::size_t, std::time_t when) {
+            expires[std::string(key, key_size)] = when;
+        });
+    };
+    scan();
+    EXPECT_EQ(now + 3600, expires[key_of(0)]);
+    EXPECT_EQ(now + 1, expires[key_of(1)]);
+
+    // Past expire time takes cold entry away as well
+    EXPECT_TRUE(storage.Set(key_of(2), "new", now - 1));
+    std::string value;
+    EXPECT_FALSE(storage.Get(key_of(2), value));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    EXPECT_FALSE(storage.Get(key_of(1), value));
+    EXPECT_FALSE(storage.PutIfAbsent(key_of(0), "other"));
+    EXPECT_TRUE(storage.PutIfAbsent(key_of(1), "other"));
+
+    // Promoted and appended entry keeps its expire time
+    EXPECT_TRUE(storage.Append(key_of(0), "+"));
+    EXPECT_TRUE(storage.Get(key_of(0), value));
+    EXPECT_EQ(value_of(0) + "+", value);
+    scan();
+    EXPECT_EQ(9, expires.size());
+    EXPECT_EQ(now + 3600, expires[key_of(0)]);
+}
+
+// Lookups wait for the file without the lock, entries keep moving between tiers meanwhile
+TEST(TieredLRUTest, ConcurrentColdLookups) {
+    TieredLRU storage(tier_path("concurrent"), 200, 64 * 1024, 1024);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(storage.Put(key_of(i), value_of(i)));
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&storage, &wrong, t]() {
+            std::string value;
+            for (int n = 0; n < 2000; ++n) {
+                int i = (n * 7 + t * 13) % 100;
+                if (n % 5 == 0) {
+                    storage.Put(key_of(i), value_of(i));
+                } else if (n % 5 == 1) {
+                    std::vector<std::string> keys{key_of(i), key_of((i + 50) % 100)};
+                    storage.MultiView(keys, [&wrong, t](const std::string &key, const char *value, std::size_t size) {
+                        wrong[t] += value_of(std::stoi(key.substr(4)) - 1000) != std::string(value, size);
+                    });
+                } else if (!storage.Get(key_of(i), value) || value != value_of(i)) {
+                    wrong[t]++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(std::vector<int>(4, 0), wrong);
+}
+
+// Record found before the entry changed is never taken for its value
+TEST(ExtentStoreTest, FetchSeesChangesMadeMeanwhile) {
+    ExtentStore store(tier_path("fetch"), 8 * 1024, 1024);
+    for (int i = 0; i < 64; ++i) {
+        EXPECT_TRUE(store.Put(key_of(i), value_of(i)));
+    }
+
+    // First entries are in sealed extents, the last one is still in memory
+    std::vector<ExtentStore::Fetch> fetches(3);
+    ASSERT_TRUE(store.Locate(key_of(0), fetches[0]));
+    ASSERT_TRUE(store.Locate(key_of(1), fetches[1]));
+    ASSERT_TRUE(store.Locate(key_of(63), fetches[2]));
+    EXPECT_FALSE(store.Locate("Key none", fetches[0]));
+    EXPECT_TRUE(fetches[2].loaded);
+    store.Load(fetches);
+
+    EXPECT_TRUE(store.Put(key_of(0), value_of(100)));
+    std::string value;
+    EXPECT_FALSE(store.Take(fetches[0], value));
+    ASSERT_TRUE(store.Get(key_of(0), value));
+    EXPECT_EQ(value_of(100), value);
+
+    ASSERT_TRUE(store.Take(fetches[1], value));
+    EXPECT_EQ(value_of(1), value);
+    ASSERT_TRUE(store.Take(fetches[2], value));
+    EXPECT_EQ(value_of(63), value);
+}
+
+TEST(ExtentStoreTest, CompactionReclaimsExtents) {
+    ExtentStore store(tier_path("compact"), 8 * 1024, 1024);
+    for (int i = 0; i < 128; ++i) {
+        EXPECT_TRUE(store.Put(key_of(i), value_of(i)));
+    }
+    EXPECT_EQ(4, store.GetStats().extents_used);
+
+    // Every fourth entry survives, so extents get sparse but never empty
+    for (int i = 0; i < 128; ++i) {
+        if (i % 4 != 0) {
+            EXPECT_TRUE(store.Delete(key_of(i)));
+        }
+    }
+    for (int i = 0; i < 128; ++i) {
+        EXPECT_TRUE(store.Put(key_of(1000 + i), value_of(i)));
+    }
+
+    ExtentStore::Stats stats = store.GetStats();
+    EXPECT_EQ(0, stats.drops);
+    EXPECT_GT(stats.compactions, 1);
+    EXPECT_EQ(32 + 128, stats.entries);
+    EXPECT_EQ(stats.entries * 32, stats.live_bytes);
+
+    std::string value;
+    for (int i = 0; i < 128; i += 4) {
+        ASSERT_TRUE(store.Get(key_of(i), value));
+        EXPECT_EQ(value_of(i), value);
+    }
+}
+
+TEST(ExtentStoreTest, OldestExtentIsDroppedWhenFull) {
+    ExtentStore store(tier_path("drop"), 4 * 1024, 1024);
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_TRUE(store.Put(key_of(i), value_of(i)));
+    }
+    EXPECT_FALSE(store.Put("Key", std::string(1024, 'x')));
+
+    ExtentStore::Stats stats = store.GetStats();
+    EXPECT_GT(stats.drops, 0);
+    EXPECT_EQ(4, stats.extents_used);
+
+    std::string value;
+    EXPECT_FALSE(store.Get(key_of(0), value));
+    ASSERT_TRUE(store.Get(key_of(199), value));
+    EXPECT_EQ(value_of(199), value);
+
+    std::size_t scanned = 0;
+    EXPECT_TRUE(store.Scan([&scanned](const char *, std::size_t, const char *, std::size_t, std::time_t) {
+        scanned++;
+    }));
+    EXPECT_EQ(stats.entries, scanned);
+}
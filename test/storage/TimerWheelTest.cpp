@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include <map>
+#include <vector>
+
+#include "storage/TimerWheel.h"
+
+using namespace Afina::Backend;
+
+// Every value fires exactly at its deadline tick, including the ones cascaded from upper levels
+TEST(TimerWheelTest, FiresOnDeadline) {
+    const uint64_t start = 1000000;
+    TimerWheel<uint64_t> wheel(start);
+    std::vector<uint64_t> deadlines = {start,         start + 1,      start + 63,     start + 64,     start + 65,
+                                       start + 4095,  start + 4096,   start + 4097,   start + 300000, start - 5,
+                                       start + 20000000};
+    for (uint64_t deadline : deadlines) {
+        wheel.Schedule(deadline, deadline);
+    }
+
+    // Time moves in small random steps near the start, and in big ones later on
+    std::map<uint64_t, uint64_t> fired;
+    const uint64_t end = start + 20000000 + 997;
+    for (uint64_t now = start; now <= end; now += now < start + 5000 ? 1 + now % 7 : 997) {
+        while (!wheel.Advance(now, 16, [&fired, now](uint64_t deadline) { fired[deadline] = now; })) {
+        }
+    }
+
+    ASSERT_EQ(deadlines.size(), fired.size());
+    for (auto &it : fired) {
+        EXPECT_LE(it.first, it.second);
+        EXPECT_LT(it.second - it.first, it.first < start + 5000 ? 7 : 997) << "deadline " << it.first;
+    }
+}
+
+// Single Advance never does more steps than budget allows
+TEST(TimerWheelTest, BoundedSlices) {
+    TimerWheel<int> wheel(0);
+    for (int i = 0; i < 1000; ++i) {
+        wheel.Schedule(10, i);
+    }
+
+    std::size_t calls = 0;
+    std::size_t fired = 0;
+    while (!wheel.Advance(100, 10, [&fired](int) { fired++; })) {
+        calls++;
+    }
+    EXPECT_EQ(1000, fired);
+    EXPECT_GE(calls, 100);
+}
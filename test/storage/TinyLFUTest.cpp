@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+#include "storage/HashLRU.h"
+#include "storage/TinyLFU.h"
+
+using namespace Afina::Backend;
+
+static std::string make_key(int i) {
+    std::string key = "Key " + std::to_string(i);
+    key.resize(20, ' ');
+    return key;
+}
+
+TEST(TinyLFUTest, PutGetDelete) {
+    TinyLFU storage(std::make_shared<HashLRU>());
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val2"));
+    EXPECT_TRUE(storage.Set("KEY1", "val3"));
+    EXPECT_FALSE(storage.Set("KEY2", "val2"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val3", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+
+    TinyLFU::Stats stats = storage.GetStats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(1, stats.misses);
+}
+
+// One pass over cold keys must not flush frequently used ones
+TEST(TinyLFUTest, ScanResistance) {
+    const size_t item = 40;
+    TinyLFU storage(std::make_shared<HashLRU>(1000 * item), 1000 * item);
+
+    std::string value(20, 'v'), out;
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 500; ++i) {
+            if (!storage.Get(make_key(i), out)) {
+                storage.Put(make_key(i), value);
+            }
+        }
+    }
+
+    for (int i = 1000; i < 11000; ++i) {
+        storage.Put(make_key(i), value);
+    }
+
+    int hot = 0;
+    for (int i = 0; i < 500; ++i) {
+        hot += storage.Get(make_key(i), out);
+    }
+    EXPECT_GT(hot, 450);
+
+    TinyLFU::Stats stats = storage.GetStats();
+    EXPECT_GT(stats.rejected, stats.admitted);
+}